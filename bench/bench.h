@@ -0,0 +1,66 @@
+// bench/bench.h
+#ifndef ADAPTSIM_BENCH_H
+#define ADAPTSIM_BENCH_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+    // 基准函数：执行一轮工作并返回本轮完成的操作数
+    using BenchFn = std::function<uint64_t()>;
+
+    struct Case {
+        std::string name;
+        BenchFn fn;
+    };
+
+    // 所有基准用例的注册表（按注册顺序运行）
+    std::vector<Case>& registry();
+
+    struct Registrar {
+        Registrar(const char* name, BenchFn fn) {
+            registry().push_back({name, std::move(fn)});
+        }
+    };
+
+    // 阻止编译器把基准结果优化掉
+    template <typename T>
+    inline void do_not_optimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // 可复现的伪随机数 (splitmix64)，保证每次运行的访问序列一致
+    inline uint64_t next_random(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // 差分测试基准的参考模型：ADAPTSIM_BENCH_REF 指定的 .so（如 NEMU），否则为随 sim_bench 构建的 stub_ref
+    inline std::string ref_path() {
+        const char* env = std::getenv("ADAPTSIM_BENCH_REF");
+        if (env && *env) {
+            return env;
+        }
+#ifdef ADAPTSIM_BENCH_STUB_REF
+        return ADAPTSIM_BENCH_STUB_REF;
+#else
+        return "";
+#endif
+    }
+
+} // namespace bench
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+// 在文件作用域注册一个基准用例
+#define BENCH_CASE(name, fn) \
+    static bench::Registrar BENCH_CONCAT(bench_registrar_, __LINE__)(name, fn)
+
+#endif //ADAPTSIM_BENCH_H
@@ -0,0 +1,94 @@
+// bench/bench_main.cpp
+//
+// sim_bench 入口：依次运行所有注册的基准。
+// 用法: sim_bench [名称子串] [--json 结果.json] [--min-time 秒]
+//   --json 另外写出机器可读的结果，供 tools/bench_compare.py 与基线对比
+//
+
+#include "bench.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace bench
+{
+    std::vector<Case>& registry() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+}
+
+// 所链接的 Vcore 模型变体（见 CMakeLists.txt 的 ADAPTSIM_MODEL_VARIANTS）
+#ifdef ADAPTSIM_MODEL_VARIANT
+static constexpr const char* MODEL_VARIANT = ADAPTSIM_MODEL_VARIANT;
+#else
+static constexpr const char* MODEL_VARIANT = "default";
+#endif
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string json_path;
+    // 每个用例至少运行这么久，以摊薄计时误差
+    double min_seconds = 0.2;
+    for (int i = 1; i < argc; i++) {
+        const bool has_arg = i + 1 < argc;
+        if (std::strcmp(argv[i], "--json") == 0 && has_arg) {
+            json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && has_arg) {
+            min_seconds = std::strtod(argv[++i], nullptr);
+        } else {
+            filter = argv[i];
+        }
+    }
+    std::FILE* json = nullptr;
+    if (!json_path.empty()) {
+        json = std::fopen(json_path.c_str(), "w");
+        if (!json) {
+            std::fprintf(stderr, "sim_bench: cannot write %s\n", json_path.c_str());
+            return 1;
+        }
+        std::fprintf(json, "{\"schema\": 1, \"variant\": \"%s\", \"min_time\": %g, \"results\": [", MODEL_VARIANT,
+                     min_seconds);
+    }
+
+    std::printf("model variant: %s\n", MODEL_VARIANT);
+    std::printf("%-36s %14s %12s %10s\n", "benchmark", "ops", "Mops/s", "ns/op");
+    bool first = true;
+    for (const auto& c : bench::registry()) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        c.fn(); // 预热：分配页、填充缓存
+
+        uint64_t ops = 0;
+        double seconds = 0.0;
+        const auto start = std::chrono::steady_clock::now();
+        do {
+            ops += c.fn();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (seconds < min_seconds);
+
+        std::printf("%-36s %14llu %12.2f %10.2f\n", c.name.c_str(),
+                    static_cast<unsigned long long>(ops), ops / seconds / 1e6, seconds * 1e9 / ops);
+        std::fflush(stdout);
+        if (json) {
+            // 每个用例一行，便于逐行比较
+            std::fprintf(json, "%s\n  {\"name\": \"%s\", \"ops\": %llu, \"seconds\": %.6f, \"ops_per_sec\": %.3f, "
+                               "\"ns_per_op\": %.4f}",
+                         first ? "" : ",", c.name.c_str(), static_cast<unsigned long long>(ops), seconds,
+                         ops / seconds, seconds * 1e9 / ops);
+            first = false;
+        }
+    }
+    if (json) {
+        std::fprintf(json, "\n]}\n");
+        if (std::fclose(json) != 0) {
+            std::fprintf(stderr, "sim_bench: failed writing %s\n", json_path.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// bench/core_loop_bench.cpp
+//
+// Sim_core 时钟循环吞吐（提交指令数/秒）：每种特性组合一个用例，对比专门化与全特性循环。
+// 差分测试用例默认使用随 sim_bench 构建的 stub_ref，设置 ADAPTSIM_BENCH_REF=<nemu.so> 时改用该参考模型。
+// core_khz/* 为打包的工作负载上 run_cycle 的端到端仿真频率（周期/秒）。
+//
+
+#include "bench.h"
+#include "workloads.h"
+#include "AdaptSim/multicore/context.h"
+#include "AdaptSim/multicore/core.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace
+{
+    constexpr uint32_t IMG_BASE = 0x80000000;
+    constexpr uint64_t INSTS_PER_ROUND = 1u << 14;
+
+    // 死循环：addi x1, x1, 1; jal x0, -4
+    constexpr uint32_t LOOP_IMG[] = {0x00108093, 0xffdff06f};
+
+    // 所有追踪与检查都关闭的配置，各用例在此基础上打开一项
+    multiple::cfg bare_cfg() {
+        multiple::cfg conf = multiple::cfg_inst;
+        conf.diff_enaled = false;
+        conf.trace_enabled = false;
+        conf.inst_trace_enabled = false;
+        conf.mem_trace_enabled = false;
+        conf.hang_cycles = 0;
+        conf.wave_file = "/dev/null";
+        conf.inst_trace_file = "/dev/null";
+        return conf;
+    }
+
+    class LoopBench {
+    public:
+        explicit LoopBench(const multiple::cfg& conf) : ctx(conf) {
+            ctx.mem.write_bytes(IMG_BASE, LOOP_IMG, sizeof(LOOP_IMG));
+            core = std::make_unique<multiple::Sim_core>(ctx);
+            core->sim_init();
+            if (conf.diff_enaled) {
+                utils::Difftest* dt = ctx.create_difftest(0);
+                dt->memcpy(IMG_BASE, const_cast<uint32_t*>(LOOP_IMG), sizeof(LOOP_IMG), DIFFTEST_TO_REF);
+                core->attach_difftest(dt);
+            }
+        }
+
+        uint64_t round() {
+            multiple::StopConditions stop;
+            stop.max_insts = INSTS_PER_ROUND;
+            return core->run(stop).insts;
+        }
+
+    private:
+        multiple::SimContext ctx;
+        std::unique_ptr<multiple::Sim_core> core;
+    };
+
+    // 模型在第一次运行时才构造，被过滤掉的用例不占用资源
+    bench::BenchFn loop_case(std::function<void(multiple::cfg&)> setup) {
+        return [setup, lb = std::shared_ptr<LoopBench>()]() mutable {
+            if (!lb) {
+                multiple::cfg conf = bare_cfg();
+                setup(conf);
+                lb = std::make_shared<LoopBench>(conf);
+            }
+            return lb->round();
+        };
+    }
+
+} // namespace
+
+BENCH_CASE("core_loop/bare", loop_case([](multiple::cfg&) {}));
+BENCH_CASE("core_loop/bare_generic", loop_case([](multiple::cfg& c) { c.specialize_loop = false; }));
+BENCH_CASE("core_loop/watchdog", loop_case([](multiple::cfg& c) { c.hang_cycles = 100000; }));
+BENCH_CASE("core_loop/itrace", loop_case([](multiple::cfg& c) { c.inst_trace_enabled = true; }));
+BENCH_CASE("core_loop/wave", loop_case([](multiple::cfg& c) { c.trace_enabled = true; }));
+BENCH_CASE("core_loop/wave_async", loop_case([](multiple::cfg& c) {
+    c.trace_enabled = true;
+    c.wave_async = true;
+}));
+BENCH_CASE("core_loop/all", loop_case([](multiple::cfg& c) {
+    c.trace_enabled = true;
+    c.inst_trace_enabled = true;
+    c.hang_cycles = 100000;
+}));
+
+// 差分测试需要参考模型，找不到时不注册
+static const bool register_difftest = [] {
+    const std::string path = bench::ref_path();
+    if (path.empty()) {
+        return false;
+    }
+    bench::registry().push_back({"core_loop/difftest", loop_case([path](multiple::cfg& c) {
+        c.diff_enaled = true;
+        c.diff_ref_path = path;
+    })});
+    bench::registry().push_back({"core_loop/difftest_generic", loop_case([path](multiple::cfg& c) {
+        c.diff_enaled = true;
+        c.diff_ref_path = path;
+        c.specialize_loop = false;
+    })});
+    return true;
+}();
+
+namespace
+{
+    constexpr int CYCLES_PER_ROUND = 1 << 15;
+
+    class KhzBench {
+    public:
+        explicit KhzBench(const bench::Workload& w) : ctx(bare_cfg()) {
+            ctx.mem.write_bytes(IMG_BASE, w.image, w.words * sizeof(uint32_t));
+            core = std::make_unique<multiple::Sim_core>(ctx);
+            core->sim_init();
+        }
+
+        uint64_t round() {
+            return static_cast<uint64_t>(core->run_cycle(CYCLES_PER_ROUND));
+        }
+
+    private:
+        multiple::SimContext ctx;
+        std::unique_ptr<multiple::Sim_core> core;
+    };
+
+} // namespace
+
+// 每秒周期数即仿真频率，Mops/s 乘以 1000 为 KHz
+static const bool register_khz = [] {
+    for (const bench::Workload& w : bench::WORKLOADS) {
+        bench::registry().push_back({std::string("core_khz/") + w.name,
+                                     [&w, kb = std::shared_ptr<KhzBench>()]() mutable {
+                                         if (!kb) {
+                                             kb = std::make_shared<KhzBench>(w);
+                                         }
+                                         return kb->round();
+                                     }});
+    }
+    return true;
+}();
@@ -0,0 +1,74 @@
+// bench/decode_bench.cpp
+//
+// RV32 指令分类吞吐：表驱动解码（无缓存 / 直接映射缓存），以及 Capstone 反汇编文本的生成速度。
+//
+
+#include "bench.h"
+#include "AdaptSim/utils/decode.h"
+#include "AdaptSim/utils/disasm.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t OPS_PER_ROUND = 1u << 16;
+
+    // 模拟真实程序：约 2K 条不同编码构成的热点循环，按随机顺序访问
+    const std::vector<uint32_t>& inst_stream() {
+        static const std::vector<uint32_t> stream = [] {
+            uint64_t state = 1234;
+            std::vector<uint32_t> distinct(2048);
+            for (auto& inst : distinct) {
+                const auto& p = utils::detail::OP_TABLE[bench::next_random(state) % std::size(utils::detail::OP_TABLE)];
+                inst = (static_cast<uint32_t>(bench::next_random(state)) & ~p.mask) | p.match;
+            }
+            std::vector<uint32_t> v(OPS_PER_ROUND);
+            for (auto& inst : v) {
+                inst = distinct[bench::next_random(state) % distinct.size()];
+            }
+            return v;
+        }();
+        return stream;
+    }
+
+    uint64_t decode_uncached() {
+        uint32_t sum = 0;
+        for (uint32_t inst : inst_stream()) {
+            sum += utils::rv32_decode(inst).flags;
+        }
+        bench::do_not_optimize(sum);
+        return OPS_PER_ROUND;
+    }
+
+    uint64_t decode_cached() {
+        uint32_t sum = 0;
+        for (uint32_t inst : inst_stream()) {
+            sum += utils::decode_cached(inst).flags;
+        }
+        bench::do_not_optimize(sum);
+        return OPS_PER_ROUND;
+    }
+
+    // 反汇编比解码慢几个数量级，每轮只取指令流的一段
+    constexpr uint32_t DISASM_PER_ROUND = 1u << 10;
+
+    template <std::string (*Fn)(uint32_t, uint32_t)>
+    uint64_t disasm() {
+        static uint32_t cursor = 0;
+        size_t len = 0;
+        const std::vector<uint32_t>& stream = inst_stream();
+        for (uint32_t i = 0; i < DISASM_PER_ROUND; ++i) {
+            len += Fn(0x80000000 + i * 4, stream[cursor]).size();
+            cursor = (cursor + 1) % OPS_PER_ROUND;
+        }
+        bench::do_not_optimize(len);
+        return DISASM_PER_ROUND;
+    }
+
+} // namespace
+
+BENCH_CASE("decode/rv32_uncached", decode_uncached);
+BENCH_CASE("decode/rv32_cached", decode_cached);
+BENCH_CASE("disasm/capstone", disasm<utils::disassemble>);
+BENCH_CASE("disasm/capstone_colored", disasm<utils::disassemble_with_colors>);
@@ -0,0 +1,88 @@
+// bench/difftest_bench.cpp
+//
+// Difftest 自身的开销（每条提交指令）：逐条对比与批量对比。
+// DUT 一侧的提交序列由参考模型预先跑出，计时中只有 Difftest 与 REF。
+//
+
+#include "bench.h"
+#include "workloads.h"
+#include "AdaptSim/utils/difftest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t IMG_BASE = 0x80000000;
+    constexpr size_t TRACE_LEN = 1u << 14;
+
+    void load_workload(utils::Difftest& dt, const bench::Workload& w) {
+        std::vector<uint32_t> img(w.image, w.image + w.words);
+        dt.memcpy(IMG_BASE, img.data(), img.size() * sizeof(uint32_t), DIFFTEST_TO_REF);
+    }
+
+    class DiffBench {
+    public:
+        DiffBench(const std::string& ref, const bench::Workload& w, uint32_t batch) : dt(ref.c_str(), 0) {
+            // 先让 REF 自己跑一遍得到 DUT 的提交序列：pc 为提交指令的地址，gpr 为执行后的寄存器
+            load_workload(dt, w);
+            start = dt.get_ref_state();
+            trace.reserve(TRACE_LEN);
+            for (size_t i = 0; i < TRACE_LEN; i++) {
+                const uint32_t pc = dt.get_ref_state().pc;
+                dt.exec(1);
+                utils::diff_context_t c = dt.get_ref_state();
+                c.pc = pc;
+                trace.push_back(c);
+            }
+            dt.set_batch(batch, false);
+        }
+
+        uint64_t round() {
+            // 工作负载的写内存都是幂等的，每轮只需把寄存器恢复到起点
+            dt.restore_ref(start, 0);
+            for (const utils::diff_context_t& c : trace) {
+                if (!dt.commit(c)) [[unlikely]] {
+                    std::fprintf(stderr, "difftest bench: unexpected mismatch\n");
+                    std::exit(1);
+                }
+            }
+            if (!dt.flush()) {
+                std::fprintf(stderr, "difftest bench: unexpected mismatch\n");
+                std::exit(1);
+            }
+            return trace.size();
+        }
+
+    private:
+        utils::Difftest dt;
+        utils::diff_context_t start{};
+        std::vector<utils::diff_context_t> trace;
+    };
+
+    // 第一次运行时才加载参考模型，被过滤掉的用例不占用链接命名空间
+    bench::BenchFn diff_case(const bench::Workload& w, uint32_t batch) {
+        return [&w, batch, db = std::shared_ptr<DiffBench>()]() mutable {
+            if (!db) {
+                db = std::make_shared<DiffBench>(bench::ref_path(), w, batch);
+            }
+            return db->round();
+        };
+    }
+
+} // namespace
+
+static const bool register_difftest_cases = [] {
+    if (bench::ref_path().empty()) {
+        return false;
+    }
+    for (const bench::Workload& w : bench::WORKLOADS) {
+        const std::string name = w.name;
+        bench::registry().push_back({"difftest/step_" + name, diff_case(w, 1)});
+        bench::registry().push_back({"difftest/batch64_" + name, diff_case(w, 64)});
+    }
+    return true;
+}();
@@ -0,0 +1,103 @@
+// bench/dpi_bench.cpp
+//
+// DPI-C 访存回调 mem_read / mem_write 的往返开销：即 RTL 每次访存时经过的全部 C++ 路径
+// （绑定内存查找、写观察者与访存追踪的分支、VMem 读写）。
+//
+
+#include "bench.h"
+#include "AdaptSim/vmemory.h"
+#include "AdaptSim/utils/memtrace.h"
+
+#include <memory>
+#include <vector>
+
+extern "C" void mem_read(int addr, int* data);
+extern "C" void mem_write(int addr, int data);
+
+namespace
+{
+    constexpr uint32_t BASE = 0x80000000;
+    constexpr uint32_t WORKING_SET = 1u << 20; // 1MB，接近典型测试程序的数据段
+    constexpr uint32_t OPS_PER_ROUND = 1u << 16;
+
+    // 运行期间把 DPI 回调的内存与追踪实例绑定到基准自己的对象上
+    struct Bind {
+        explicit Bind(memory::VMem* mem, utils::MemTrace* trace = nullptr)
+            : prev_mem(memory::bind_memory(mem)), prev_trace(utils::bind_mem_trace(trace)) {}
+        ~Bind() {
+            memory::bind_memory(prev_mem);
+            utils::bind_mem_trace(prev_trace);
+        }
+        memory::VMem* prev_mem;
+        utils::MemTrace* prev_trace;
+    };
+
+    const std::vector<int>& addrs() {
+        static const std::vector<int> v = [] {
+            std::vector<int> a(OPS_PER_ROUND);
+            uint64_t state = 99;
+            for (auto& x : a) {
+                x = static_cast<int>(BASE + (static_cast<uint32_t>(bench::next_random(state)) % WORKING_SET & ~3u));
+            }
+            return a;
+        }();
+        return v;
+    }
+
+    uint64_t dpi_read(memory::VMem* mem, utils::MemTrace* trace = nullptr) {
+        Bind bind(mem, trace);
+        int sum = 0;
+        for (int addr : addrs()) {
+            int data;
+            mem_read(addr, &data);
+            sum += data;
+        }
+        bench::do_not_optimize(sum);
+        return OPS_PER_ROUND;
+    }
+
+    uint64_t dpi_write(memory::VMem* mem, utils::MemTrace* trace = nullptr) {
+        Bind bind(mem, trace);
+        int i = 0;
+        for (int addr : addrs()) {
+            mem_write(addr, i++);
+        }
+        return OPS_PER_ROUND;
+    }
+
+    // 写后立即读回，模拟 store 之后紧跟 load 的程序
+    uint64_t dpi_roundtrip(memory::VMem* mem) {
+        Bind bind(mem);
+        int sum = 0;
+        for (int addr : addrs()) {
+            int data;
+            mem_write(addr, sum);
+            mem_read(addr, &data);
+            sum += data + 1;
+        }
+        bench::do_not_optimize(sum);
+        return OPS_PER_ROUND * 2;
+    }
+
+    // 飞行记录器方式的访存追踪，只追加到环形缓冲区
+    utils::MemTrace* flight_trace() {
+        static auto trace = [] {
+            auto t = std::make_unique<utils::MemTrace>();
+            t->start();
+            return t;
+        }();
+        return trace.get();
+    }
+
+    memory::VMem* mem() {
+        static auto m = std::make_unique<memory::VMem>();
+        return m.get();
+    }
+
+} // namespace
+
+BENCH_CASE("dpi/mem_read_w", [] { return dpi_read(mem()); });
+BENCH_CASE("dpi/mem_write_w", [] { return dpi_write(mem()); });
+BENCH_CASE("dpi/mem_write_read_w", [] { return dpi_roundtrip(mem()); });
+BENCH_CASE("dpi/mem_read_w_traced", [] { return dpi_read(mem(), flight_trace()); });
+BENCH_CASE("dpi/mem_write_w_traced", [] { return dpi_write(mem(), flight_trace()); });
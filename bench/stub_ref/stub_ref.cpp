@@ -0,0 +1,155 @@
+// bench/stub_ref/stub_ref.cpp
+//
+// 基准用的最小 difftest 参考模型：RV32IM 解释器，接口与 NEMU 的 difftest_* 一致。
+// 只为了在没有 NEMU 的机器上测量 Difftest 本身的开销，不处理异常、中断与 CSR
+// （ecall/mret/CSR 指令按空操作执行，ebreak 停在原地）。
+//
+
+#include "AdaptSim/utils/decode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t MEM_BASE = 0x80000000;
+    constexpr uint32_t MEM_SIZE = 16u << 20;
+
+    // 布局与 utils::diff_context_t 一致
+    struct Cpu {
+        uint32_t gpr[32];
+        uint32_t pc;
+    };
+
+    Cpu cpu;
+    std::vector<uint8_t> mem;
+
+    bool in_mem(uint32_t addr, uint32_t len) {
+        return addr >= MEM_BASE && addr - MEM_BASE + len <= MEM_SIZE;
+    }
+
+    uint32_t load(uint32_t addr, uint32_t len) {
+        uint32_t v = 0;
+        if (in_mem(addr, len)) {
+            std::memcpy(&v, &mem[addr - MEM_BASE], len);
+        }
+        return v;
+    }
+
+    void store(uint32_t addr, uint32_t len, uint32_t v) {
+        if (in_mem(addr, len)) {
+            std::memcpy(&mem[addr - MEM_BASE], &v, len);
+        }
+    }
+
+    void step() {
+        const uint32_t inst = load(cpu.pc, 4);
+        const utils::DecodedInst& d = utils::decode_cached(inst);
+        const uint32_t a = cpu.gpr[d.rs1];
+        const uint32_t b = cpu.gpr[d.rs2];
+        const uint32_t imm = static_cast<uint32_t>(d.imm);
+        const auto sa = static_cast<int32_t>(a);
+        const auto sb = static_cast<int32_t>(b);
+        uint32_t next = cpu.pc + 4;
+        uint32_t rd = 0;
+
+        using utils::RvOp;
+        switch (d.op) {
+            case RvOp::LUI: rd = imm; break;
+            case RvOp::AUIPC: rd = cpu.pc + imm; break;
+            case RvOp::JAL: rd = next; next = cpu.pc + imm; break;
+            case RvOp::JALR: rd = next; next = (a + imm) & ~1u; break;
+            case RvOp::BEQ: if (a == b) next = cpu.pc + imm; break;
+            case RvOp::BNE: if (a != b) next = cpu.pc + imm; break;
+            case RvOp::BLT: if (sa < sb) next = cpu.pc + imm; break;
+            case RvOp::BGE: if (sa >= sb) next = cpu.pc + imm; break;
+            case RvOp::BLTU: if (a < b) next = cpu.pc + imm; break;
+            case RvOp::BGEU: if (a >= b) next = cpu.pc + imm; break;
+            case RvOp::LB: rd = static_cast<uint32_t>(static_cast<int8_t>(load(a + imm, 1))); break;
+            case RvOp::LH: rd = static_cast<uint32_t>(static_cast<int16_t>(load(a + imm, 2))); break;
+            case RvOp::LW: rd = load(a + imm, 4); break;
+            case RvOp::LBU: rd = load(a + imm, 1); break;
+            case RvOp::LHU: rd = load(a + imm, 2); break;
+            case RvOp::SB: store(a + imm, 1, b); break;
+            case RvOp::SH: store(a + imm, 2, b); break;
+            case RvOp::SW: store(a + imm, 4, b); break;
+            case RvOp::ADDI: rd = a + imm; break;
+            case RvOp::SLTI: rd = sa < static_cast<int32_t>(imm); break;
+            case RvOp::SLTIU: rd = a < imm; break;
+            case RvOp::XORI: rd = a ^ imm; break;
+            case RvOp::ORI: rd = a | imm; break;
+            case RvOp::ANDI: rd = a & imm; break;
+            case RvOp::SLLI: rd = a << (imm & 31); break;
+            case RvOp::SRLI: rd = a >> (imm & 31); break;
+            case RvOp::SRAI: rd = static_cast<uint32_t>(sa >> (imm & 31)); break;
+            case RvOp::ADD: rd = a + b; break;
+            case RvOp::SUB: rd = a - b; break;
+            case RvOp::SLL: rd = a << (b & 31); break;
+            case RvOp::SLT: rd = sa < sb; break;
+            case RvOp::SLTU: rd = a < b; break;
+            case RvOp::XOR: rd = a ^ b; break;
+            case RvOp::SRL: rd = a >> (b & 31); break;
+            case RvOp::SRA: rd = static_cast<uint32_t>(sa >> (b & 31)); break;
+            case RvOp::OR: rd = a | b; break;
+            case RvOp::AND: rd = a & b; break;
+            case RvOp::MUL: rd = a * b; break;
+            case RvOp::MULH: rd = static_cast<uint32_t>((int64_t{sa} * int64_t{sb}) >> 32); break;
+            case RvOp::MULHSU: rd = static_cast<uint32_t>((int64_t{sa} * static_cast<int64_t>(uint64_t{b})) >> 32); break;
+            case RvOp::MULHU: rd = static_cast<uint32_t>((uint64_t{a} * uint64_t{b}) >> 32); break;
+            case RvOp::DIV:
+                rd = b == 0 ? ~0u : (sa == INT32_MIN && sb == -1) ? a : static_cast<uint32_t>(sa / sb);
+                break;
+            case RvOp::DIVU: rd = b == 0 ? ~0u : a / b; break;
+            case RvOp::REM:
+                rd = b == 0 ? a : (sa == INT32_MIN && sb == -1) ? 0 : static_cast<uint32_t>(sa % sb);
+                break;
+            case RvOp::REMU: rd = b == 0 ? a : a % b; break;
+            case RvOp::EBREAK: next = cpu.pc; break;
+            default: break;
+        }
+        if (d.flags & utils::INST_WRITES_RD) {
+            cpu.gpr[d.rd] = rd;
+        }
+        cpu.pc = next;
+    }
+
+} // namespace
+
+extern "C" {
+
+    void difftest_init() {
+        mem.assign(MEM_SIZE, 0);
+        std::memset(&cpu, 0, sizeof(cpu));
+        cpu.pc = MEM_BASE;
+    }
+
+    void difftest_memcpy(uint32_t addr, void* buf, size_t n, bool direction) {
+        if (!in_mem(addr, static_cast<uint32_t>(n))) {
+            return;
+        }
+        if (direction) {
+            std::memcpy(&mem[addr - MEM_BASE], buf, n);
+        } else {
+            std::memcpy(buf, &mem[addr - MEM_BASE], n);
+        }
+    }
+
+    void difftest_regcpy(void* dut, bool direction) {
+        if (direction) {
+            std::memcpy(&cpu, dut, sizeof(cpu));
+        } else {
+            std::memcpy(dut, &cpu, sizeof(cpu));
+        }
+    }
+
+    void difftest_exec(uint64_t n) {
+        while (n--) {
+            step();
+        }
+    }
+
+    void difftest_raise_intr(uint64_t) {}
+
+}
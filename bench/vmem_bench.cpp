@@ -0,0 +1,168 @@
+// bench/vmem_bench.cpp
+//
+// VMem 读写吞吐：顺序/随机访问，对比旧的 std::map 逐字节实现。
+// 以及测试之间复位内存的两种方式：重新加载镜像与恢复写时复制快照（均以镜像页数计）。
+//
+
+#include "bench.h"
+#include "AdaptSim/vmemory.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t BASE = 0x80000000;
+    constexpr uint32_t WORKING_SET = 16u << 20; // 16MB
+    constexpr uint32_t OPS_PER_ROUND = 1u << 16;
+
+    // 旧实现：std::map 存储 4KB 块，每字节一次查找（仅作为对照组）
+    class MapMem {
+        static constexpr uint32_t BLOCK_SIZE = 4096;
+        std::map<uint32_t, std::vector<uint8_t>> memory_blocks;
+
+    public:
+        uint32_t read(uint32_t addr, uint32_t len) {
+            uint32_t result = 0;
+            for (uint32_t i = 0; i < len; ++i) {
+                auto it = memory_blocks.find((addr + i) / BLOCK_SIZE);
+                uint8_t byte_val = it != memory_blocks.end() ? it->second[(addr + i) % BLOCK_SIZE] : 0;
+                result |= static_cast<uint32_t>(byte_val) << (i * 8);
+            }
+            return result;
+        }
+
+        void write(uint32_t addr, uint32_t len, uint32_t data) {
+            for (uint32_t i = 0; i < len; ++i) {
+                auto it = memory_blocks.try_emplace((addr + i) / BLOCK_SIZE, BLOCK_SIZE, 0).first;
+                it->second[(addr + i) % BLOCK_SIZE] = (data >> (i * 8)) & 0xFF;
+            }
+        }
+    };
+
+    const std::vector<uint32_t>& random_addrs() {
+        static const std::vector<uint32_t> addrs = [] {
+            std::vector<uint32_t> v(OPS_PER_ROUND);
+            uint64_t state = 42;
+            for (auto& a : v) {
+                a = BASE + (static_cast<uint32_t>(bench::next_random(state)) % WORKING_SET & ~3u);
+            }
+            return v;
+        }();
+        return addrs;
+    }
+
+    template <typename Mem>
+    uint64_t seq_read(Mem& mem) {
+        static uint32_t cursor = 0;
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < OPS_PER_ROUND; ++i) {
+            sum += mem.read(BASE + cursor, 4);
+            cursor = (cursor + 4) % WORKING_SET;
+        }
+        bench::do_not_optimize(sum);
+        return OPS_PER_ROUND;
+    }
+
+    template <typename Mem>
+    uint64_t seq_write(Mem& mem) {
+        static uint32_t cursor = 0;
+        for (uint32_t i = 0; i < OPS_PER_ROUND; ++i) {
+            mem.write(BASE + cursor, 4, i);
+            cursor = (cursor + 4) % WORKING_SET;
+        }
+        return OPS_PER_ROUND;
+    }
+
+    template <typename Mem>
+    uint64_t rand_read(Mem& mem) {
+        uint32_t sum = 0;
+        for (uint32_t addr : random_addrs()) {
+            sum += mem.read(addr, 4);
+        }
+        bench::do_not_optimize(sum);
+        return OPS_PER_ROUND;
+    }
+
+    template <typename Mem>
+    uint64_t rand_write(Mem& mem) {
+        uint32_t i = 0;
+        for (uint32_t addr : random_addrs()) {
+            mem.write(addr, 4, i++);
+        }
+        return OPS_PER_ROUND;
+    }
+
+    memory::VMem& vmem() {
+        static auto mem = std::make_unique<memory::VMem>();
+        return *mem;
+    }
+
+    MapMem& map_mem() {
+        static MapMem mem;
+        return mem;
+    }
+
+} // namespace
+
+BENCH_CASE("vmem/seq_write_w", [] { return seq_write(vmem()); });
+BENCH_CASE("vmem/seq_read_w", [] { return seq_read(vmem()); });
+BENCH_CASE("vmem/rand_write_w", [] { return rand_write(vmem()); });
+BENCH_CASE("vmem/rand_read_w", [] { return rand_read(vmem()); });
+BENCH_CASE("vmem_legacy_map/seq_write_w", [] { return seq_write(map_mem()); });
+BENCH_CASE("vmem_legacy_map/seq_read_w", [] { return seq_read(map_mem()); });
+BENCH_CASE("vmem_legacy_map/rand_write_w", [] { return rand_write(map_mem()); });
+BENCH_CASE("vmem_legacy_map/rand_read_w", [] { return rand_read(map_mem()); });
+
+namespace
+{
+    constexpr uint32_t IMAGE_SIZE = 16u << 20;
+
+    // 生成一次 16MB 的临时镜像文件，供加载基准使用
+    const std::string& image_path() {
+        static const std::string path = [] {
+            std::string p = "/tmp/adaptsim_bench_img.bin";
+            std::vector<uint8_t> buf(IMAGE_SIZE);
+            uint64_t state = 7;
+            for (auto& b : buf) {
+                b = static_cast<uint8_t>(bench::next_random(state));
+            }
+            std::ofstream(p, std::ios::binary).write(reinterpret_cast<const char*>(buf.data()), buf.size());
+            return p;
+        }();
+        return path;
+    }
+
+    uint64_t load_image(memory::LoadMode mode) {
+        memory::VMem mem;
+        mem.set_verbose(false); // 计时循环里不打印、不刷新 stdout
+        mem.load_from_file(image_path(), BASE, mode);
+        bench::do_not_optimize(mem.allocated_pages());
+        return IMAGE_SIZE / memory::VMem::PAGE_SIZE;
+    }
+
+    // 一次测试通常只改动镜像中的少量页；恢复快照只需还原这些页
+    uint64_t restore_snapshot(uint32_t dirty) {
+        static auto mem = [] {
+            auto m = std::make_unique<memory::VMem>();
+            m->set_verbose(false);
+            m->load_from_file(image_path(), BASE, memory::LoadMode::Copy);
+            return m;
+        }();
+        static const memory::MemSnapshot snap = mem->snapshot();
+        static uint64_t state = 11;
+        for (uint32_t i = 0; i < dirty; ++i) {
+            mem->write(BASE + (static_cast<uint32_t>(bench::next_random(state)) % IMAGE_SIZE & ~3u), 4, i);
+        }
+        mem->restore(snap);
+        return IMAGE_SIZE / memory::VMem::PAGE_SIZE;
+    }
+
+} // namespace
+
+BENCH_CASE("vmem/load_image_copy_pages", [] { return load_image(memory::LoadMode::Copy); });
+BENCH_CASE("vmem/load_image_mmap_pages", [] { return load_image(memory::LoadMode::Mmap); });
+BENCH_CASE("vmem/restore_snapshot_dirty64_pages", [] { return restore_snapshot(64); });
+BENCH_CASE("vmem/restore_snapshot_dirty1k_pages", [] { return restore_snapshot(1024); });
@@ -0,0 +1,72 @@
+// bench/workloads.h
+//
+// 随 sim_bench 打包的 RV32I 小程序（手工编码），都是从 0x80000000 开始的无限循环，
+// 供端到端仿真速度和差分测试开销的基准使用。
+//
+
+#ifndef ADAPTSIM_BENCH_WORKLOADS_H
+#define ADAPTSIM_BENCH_WORKLOADS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace bench
+{
+    struct Workload {
+        const char* name;
+        const uint32_t* image;
+        size_t words;
+    };
+
+    namespace workload_images
+    {
+        // 整数运算循环：add / addi / xor / slli / sub，每 6 条一次跳转
+        inline constexpr uint32_t ALU[] = {
+            0x00000093, // addi x1, x0, 0
+            0x00100113, // addi x2, x0, 1
+            0x002080b3, // add x1, x1, x2  ; loop
+            0x00110113, // addi x2, x2, 1
+            0x0020c1b3, // xor x3, x1, x2
+            0x00319213, // slli x4, x3, 3
+            0x401202b3, // sub x5, x4, x1
+            0xfedff06f, // jal x0, loop
+        };
+
+        // 逐字拷贝 1KB（lw / sw），每 1KB 重新开始
+        inline constexpr uint32_t MEMCPY[] = {
+            0x80010537, // lui x10, 0x80010  ; start: src
+            0x800205b7, // lui x11, 0x80020  ; dst
+            0x10000613, // addi x12, x0, 256  ; words
+            0x00052283, // lw x5, 0(x10)  ; loop
+            0x00128293, // addi x5, x5, 1
+            0x0055a023, // sw x5, 0(x11)
+            0x00450513, // addi x10, x10, 4
+            0x00458593, // addi x11, x11, 4
+            0xfff60613, // addi x12, x12, -1
+            0xfe0614e3, // bne x12, x0, loop
+            0xfd9ff06f, // jal x0, start
+        };
+
+        // 函数调用与返回：jal ra / jalr，每 7 条三次跳转
+        inline constexpr uint32_t CALL[] = {
+            0x00000513, // addi x10, x0, 0
+            0x00c000ef, // jal x1, f  ; loop
+            0x00150513, // addi x10, x10, 1
+            0xff9ff06f, // jal x0, loop
+            0x00155313, // srli x6, x10, 1  ; f
+            0x00f37393, // andi x7, x6, 15
+            0x007282b3, // add x5, x5, x7
+            0x00008067, // jalr x0, 0(x1)
+        };
+    }
+
+    inline constexpr Workload WORKLOADS[] = {
+        {"alu", workload_images::ALU, std::size(workload_images::ALU)},
+        {"memcpy", workload_images::MEMCPY, std::size(workload_images::MEMCPY)},
+        {"call", workload_images::CALL, std::size(workload_images::CALL)},
+    };
+
+} // namespace bench
+
+#endif //ADAPTSIM_BENCH_WORKLOADS_H
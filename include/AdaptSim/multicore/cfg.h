@@ -4,7 +4,9 @@
 
 #ifndef CFG_H
 #define CFG_H
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace multiple {
 
@@ -12,12 +14,45 @@ namespace multiple {
     {
         bool diff_enaled = true;  // 差分测试启用
         bool trace_enabled = true; // 波形追踪启用
-        bool inst_trace_enabled = true; // 指令追踪启用
+        bool inst_trace_enabled = false; // 指令追踪启用
+        std::string inst_trace_file = "itrace.bin"; // 指令提交日志文件（用 itrace_view 查看）
+        std::string inst_trace_codec = "none"; // 指令日志块压缩: none / lz4 / zstd
         bool mem_trace_enabled = true; // 内存追踪启用
+        std::string mem_trace_file = ""; // 内存追踪输出文件；为空时只保留环形缓冲区（飞行记录器）
+        std::string mem_trace_dump_file = "memtrace.bin"; // 飞行记录器方式下，差分测试失配或异常终止时写出的文件
+        bool perf_enabled = false; // 每周期采样流水线握手信号，统计占用、停顿与访存延迟
+        std::string perf_file = "perf.json"; // 性能计数器在仿真结束时写出的 JSON
+        bool prof_enabled = false; // 客户程序热点分析：PC 直方图、基本块、折叠调用栈（符号取自 img_path 的 ELF）
+        uint64_t prof_sample_cycles = 0; // 每隔这么多周期采样一次 PC（0 为逐条提交记录）
+        uint64_t prof_bbv_interval = 100000000; // SimPoint BBV 区间的指令数（0 不生成）
+        std::string prof_output = "prof"; // 输出前缀：prof.flat / prof.folded / prof.bb / prof.bbv
         std::string diff_ref_path = ""; // 差分测试参考路径
+        uint32_t diff_batch = 1; // 批量差分测试：每 N 条指令对比一次，失配时逐条定位（1 为逐条对比）
+        bool diff_batch_adaptive = false; // 批大小从 1 起步，对比一致时翻倍直到 diff_batch
+        bool diff_async = false; // 在独立线程上运行参考模型，与 DUT 仿真并行（此时总是逐条对比，diff_batch 不生效）
+        uint64_t hang_cycles = 100000; // 看门狗：连续这么多周期没有指令提交即判定挂死（0 为不检查）
+        uint32_t selfprof_progress_ms = 1000; // 以 ADAPTSIM_SELF_PROFILE 编译时，run 每隔这么久打印一行进度（0 不打印）
+        bool specialize_loop = true; // 按启用的特性选用专门化的时钟循环；false 时总用全特性循环（用于对比）
+        uint64_t ff_insts = 0; // 快进：先让 REF 执行这么多条指令，再把状态装入 RTL（0 为不快进）
+        uint32_t ff_pc = 0; // 快进到 REF 的 PC 等于该值为止（0 为不按 PC；与 ff_insts 同时设置时 ff_insts 为上限）
+        uint32_t ff_mem_base = 0x80000000; // REF 的内存区间：快进后从 REF 拷贝到 DUT，批量差分失配时据此回滚 REF
+        uint32_t ff_mem_size = 0x08000000;
+        std::string ff_pc_signal = "core__DOT__IFU__DOT__pc"; // 装入 PC 的 RTL 寄存器
         std::string wave_file = "wave.vcd"; // 波形文件名
+        bool wave_flight = false; // 波形飞行记录器：只在内存中保留最近的波形，失配/异常终止时写到 wave_file
+        uint64_t wave_flight_cycles = 100000; // 飞行记录器至少保留的周期数
+        // 触发式波形窗口，如 "pc:0x80000000-0x80000100"、"inst:1000-2000"、"cycle:5000-6000"；
+        // 非空时只在窗口内输出波形，每个窗口写到单独的文件 (wave_w0.vcd, wave_w1.vcd ...)
+        std::vector<std::string> wave_windows = {};
+        uint32_t wave_window_max_files = 64; // 窗口文件数上限（PC 窗口每次进入都会新开一个文件）
+        // 波形文件由后台线程写出（双缓冲），仿真线程只在两块缓冲都满时等待。只分担写盘与压缩；
+        // 要把 VCD 编码也移出仿真线程，以 ADAPTSIM_VERILATOR_FST 构建，改用 Verilator 的 FST 追踪线程
+        bool wave_async = false;
+        std::string wave_compress = "none"; // wave_async 时的压缩方式："none" 或 "zstd"（文件名追加 .zst）
+        uint32_t wave_async_buffer_kb = 4096; // wave_async 每块缓冲区大小
         std::string img_path = ""; // 默认内存镜像路径
         bool extern_img = false; // 是否使用外部内存镜像
+        bool mmap_img = false; // 以 mmap 写时复制方式加载镜像（大镜像启动更快）
     };
 
     extern cfg cfg_inst; // 声明一个外部链接的全局配置实例
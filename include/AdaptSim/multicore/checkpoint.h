@@ -0,0 +1,62 @@
+//
+// 仿真检查点文件格式
+//
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+
+namespace multiple {
+
+    /**
+     * 文件布局（主机小端序）：
+     *   CheckpointHeader
+     *   CheckpointSection[n_sections]
+     *   各段内容；PageData 段按 4KB 对齐放在文件末尾，恢复时直接 MAP_PRIVATE 映射，
+     *   同一检查点可被多个仿真上下文同时恢复并共享未写过的页。
+     * 段可以比对应的结构体短（结构体在末尾追加过字段），缺少的字段按 0 处理。
+     */
+    inline constexpr char CHECKPOINT_MAGIC[8] = {'A', 'S', 'C', 'H', 'K', 'P', 'N', 'T'};
+    inline constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+    struct CheckpointHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t n_sections;
+    };
+
+    enum class CheckpointSectionKind : uint32_t {
+        Meta      = 1, // CheckpointMeta
+        PageIndex = 2, // uint32_t 页地址[n]
+        PageData  = 3, // n 个整页，与 PageIndex 一一对应
+        Model     = 4, // Verilator 模型与 VerilatedContext 的序列化数据 (需 --savable)
+        Ref       = 5, // CheckpointRef
+    };
+
+    struct CheckpointSection {
+        uint32_t kind;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct CheckpointMeta {
+        uint64_t cycle_cnt;
+        uint64_t inst_cnt;
+        uint64_t sim_time;
+        int32_t  cpu_state;
+        int32_t  halt_ret;
+        uint64_t ff_inst_cnt; // 旧文件的 Meta 段没有这一项，恢复为 0
+    };
+
+    struct CheckpointRef {
+        uint32_t gpr[32];
+        uint32_t pc;
+        uint32_t reserved;
+        uint64_t commit_cnt;
+    };
+
+} // namespace multiple
+
+#endif //CHECKPOINT_H
@@ -0,0 +1,71 @@
+//
+// 单个仿真的上下文
+//
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <memory>
+#include "cfg.h"
+#include "state.h"
+#include "AdaptSim/vmemory.h"
+#include "AdaptSim/utils/memtrace.h"
+#include "AdaptSim/utils/difftest.h"
+
+class VerilatedContext;
+
+namespace multiple {
+
+    /**
+     * @brief 一个仿真独占的全部状态：配置、内存、CPU 状态、访存追踪与差分测试。
+     *
+     * 多个上下文可以在各自的线程上并行运行。DPI 回调没有参数能指明所属仿真，
+     * 因此 Sim_core 在进入模型前用 Binding 把当前线程的 get_memory() /
+     * get_mem_trace() 指向本上下文；以 Mmap 方式加载同一镜像的上下文共享只读页。
+     * 多线程模型（--threads > 1）的 DPI 回调运行在 Verilator 工作线程上，那里没有 Binding：
+     * Sim_core 用 register_model() 登记自己的 VerilatedContext，回调按调用方的 DPI scope 找回上下文。
+     */
+    class SimContext {
+    public:
+        explicit SimContext(const cfg& config = cfg_inst);
+
+        SimContext(const SimContext&) = delete;
+        SimContext& operator=(const SimContext&) = delete;
+
+        cfg config;
+        memory::VMem mem;
+        utils::MemTrace mem_trace;
+        CPU_State cpu_state{CPU_STATES::CPU_STOP, 0};
+        std::unique_ptr<utils::Difftest> difftest; // 声明在 mem 之后：先析构，析构时从 mem 上注销写观察者
+
+        // 按 config.diff_ref_path 创建差分测试；须在镜像载入 mem 之后调用
+        utils::Difftest* create_difftest(long img_size);
+
+        int is_exit_status_bad() const { return multiple::is_exit_status_bad(cpu_state); }
+
+        // 当前线程所绑定的上下文，未绑定时为 nullptr
+        static SimContext* current();
+
+        // 登记 vctx 中模型的 DPI 回调属于 ctx；ctx 为 nullptr 时注销
+        static void register_model(const VerilatedContext* vctx, SimContext* ctx);
+
+        // RAII：在作用域内把当前线程绑定到 ctx（nullptr 时不做任何事），退出时恢复原绑定
+        class Binding {
+        public:
+            explicit Binding(SimContext* ctx);
+            ~Binding();
+
+            Binding(const Binding&) = delete;
+            Binding& operator=(const Binding&) = delete;
+
+        private:
+            SimContext* ctx;
+            SimContext* prev_ctx = nullptr;
+            memory::VMem* prev_mem = nullptr;
+            utils::MemTrace* prev_trace = nullptr;
+        };
+    };
+
+} // namespace multiple
+
+#endif //CONTEXT_H
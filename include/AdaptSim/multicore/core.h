@@ -5,16 +5,31 @@
 #ifndef CORE_H
 #define CORE_H
 
+#include <atomic>
 #include <cstdint>
 #include <memory> // For std::unique_ptr
+#include <string>
+#include <vector>
 #include "utils/difftest.h"
+#include "utils/itrace.h"
+#include "utils/difftest_pipeline.h"
+#include "utils/wavetrace.h"
+#include "utils/profiler.h"
+#include "signals.h"
+#include "perf.h"
+#include "cfg.h"
+#include "state.h"
 
 // 前向声明 Verilator 生成的类，以避免在头文件中包含大型 Verilator 头文件
 class Vcore;
 class VerilatedVcdC;
+class VerilatedFstC;
+class VerilatedContext;
 
 namespace multiple {
 
+    class SimContext;
+
     // 调试信息结构体，用于从仿真核心获取状态
     struct CoreDebugInfo {
         uint32_t pc;
@@ -29,16 +44,109 @@ namespace multiple {
         uint64_t cycle_cnt;
     };
 
+    // 时钟循环的编译期特性（按位组合）。Sim_core::run 为每种组合实例化一份循环，
+    // 按运行开始时的配置选用，未启用的特性在循环中不留任何检查
+    namespace loop_feature {
+        constexpr unsigned WAVE     = 1u << 0; // 波形：tfp / 飞行记录器 / 触发窗口
+        constexpr unsigned ITRACE   = 1u << 1; // 指令提交日志
+        constexpr unsigned DIFFTEST = 1u << 2; // 差分测试
+        constexpr unsigned WATCHDOG = 1u << 3; // 看门狗与周期上限
+        constexpr unsigned PERF     = 1u << 4; // 性能计数器采样
+        constexpr unsigned PROFILE  = 1u << 5; // 客户程序热点分析
+        constexpr unsigned ALL      = WAVE | ITRACE | DIFFTEST | WATCHDOG | PERF | PROFILE;
+    }
+
+    // Sim_core::run 的停止条件；计数类条件为 0 表示不限
+    struct StopConditions {
+        uint64_t max_insts = 0;    // 本次调用最多提交的指令数
+        uint64_t max_cycles = 0;   // 本次调用最多推进的周期数
+        uint64_t hang_cycles = 0;  // 连续无提交的周期上限；0 时使用 cfg.hang_cycles
+        std::vector<uint32_t> breakpoints; // PC 断点：该地址的指令提交后停下
+        const std::atomic<bool>* stop = nullptr; // 外部停止标志（其他线程置位），每条指令检查一次
+    };
+
+    // Sim_core::run 的结束原因
+    enum class RunExit {
+        Halt,       // 执行 ebreak，cpu.halt_ret 为 a0 (CPU_END)
+        Mismatch,   // 差分测试失配 (CPU_ABORT)
+        Hang,       // 看门狗：长时间没有指令提交 (CPU_ABORT)
+        MaxInsts,   // 以下均为暂停 (CPU_STOP)，可再次调用 run 继续
+        MaxCycles,
+        Breakpoint,
+        Stopped     // 外部停止标志
+    };
+
+    const char* run_exit_name(RunExit reason);
+
+    struct RunResult {
+        RunExit reason;
+        uint64_t insts;  // 本次调用提交的指令数
+        uint64_t cycles; // 本次调用推进的周期数
+        uint32_t pc;     // 最后一条提交指令的 PC
+    };
+
     // Verilator 仿真核心的封装类
     class Sim_core {
     private:
+        SimContext* ctx;        // 所属仿真上下文；为空时使用进程全局的 cfg_inst / cpu_state / 内存
+        const cfg& conf;
+        CPU_State& cpu;
+        std::unique_ptr<VerilatedContext> vctx; // 每个核心独立的仿真时间与追踪开关
         std::unique_ptr<Vcore> Top;
+        std::unique_ptr<utils::AsyncWaveSink> wave_sink; // cfg.wave_async 时 tfp 的输出文件，须在 tfp 之后析构
+#ifdef ADAPTSIM_WAVE_FST
+        std::unique_ptr<VerilatedFstC> tfp; // 模型以 --trace-fst 生成，编码与压缩在 Verilator 的追踪线程上
+#else
         std::unique_ptr<VerilatedVcdC> tfp;
+#endif
+        std::unique_ptr<utils::WaveRecorder> wave_rec; // cfg.wave_flight 时代替 tfp
+        bool wave_dumped = false;
+        // 触发式波形窗口；tfp 在第一个窗口打开时才创建并挂接到模型
+        std::unique_ptr<utils::WaveTrigger> wave_trig;
+        uint64_t wave_next_cycle = UINT64_MAX; // 时钟循环中下一次需要判断周期窗口的周期
+        unsigned wave_files = 0;
+        uint64_t inst_cnt = 0; // RTL 提交的指令数
+        uint64_t ff_inst_cnt = 0; // 快进时 REF 执行的指令数，不计入 inst_cnt，以免抬高 IPC
+        std::unique_ptr<utils::InstTraceWriter> itrace; // 指令提交日志，未启用时为空
+        utils::Difftest* difftest = nullptr; // 差分测试（由外部持有），未启用时为空
+        std::unique_ptr<utils::DifftestPipeline> diff_pipe; // cfg.diff_async 时在独立线程上检查
+        uint64_t cycle_cnt = 0; // 时钟上升沿计数
+
+        // 内部信号注册表（构建期生成），GPR 与调试端口都经由它访问
+        std::unique_ptr<SignalRegistry> signals;
+        SignalGroup gpr_group;          // rf_1 .. rf_31
+        SignalRef wb_en, wb_addr;       // RF 写端口；找不到时每次读回全部 GPR
+        SignalRef debug_out, debug_mem_addr, debug_mem_data;
+        // GPR 影子副本与脏位：只重新读取上次检查以来写过的寄存器
+        uint32_t gpr_shadow[32] = {};
+        uint32_t gpr_dirty = ~0u;       // 自上次 get_diff_info 以来写回的寄存器
+        uint32_t gpr_dirty_prev = ~0u;  // 上一次的脏位，再读一次以覆盖写回晚一拍生效的情况
+        std::unique_ptr<PerfCounters> perf; // cfg.perf_enabled 时每个上升沿采样
+        std::unique_ptr<utils::Profiler> profiler; // cfg.prof_enabled 时每条提交指令记录一次
+
+        explicit Sim_core(SimContext* ctx);
 
-        void toggle_clock();
+        // 由当前配置得出时钟循环需要的特性；bounded 表示有看门狗或周期上限
+        unsigned loop_features(bool bounded) const;
+        template <unsigned F> void toggle_clock_t();
+        void toggle_clock(); // 全部特性，用于复位等非热点路径
+        // 翻转时钟直到一条指令提交；F 含 WATCHDOG 时推进到 deadline 周期为止，超出返回 false
+        template <unsigned F> bool clock_until_commit(uint64_t deadline);
+        // 指令提交后的处理：写回脏位、波形窗口、指令日志、差分测试与 ebreak。
+        // 返回 false 表示运行结束，cpu.state 已置为 CPU_END 或 CPU_ABORT
+        template <unsigned F> bool on_commit();
+        template <unsigned F> RunResult run_loop(const StopConditions& stop);
+        void poll_wave_windows(bool at_commit);
+        // 创建 tfp 并挂接到模型；cfg.wave_async 时输出到后台写线程（FST 模型上不需要）
+        void attach_wave();
+        // 在指令提交时采样 RF 写端口，累积脏位
+        void note_writeback();
 
     public:
+        // 使用进程全局状态，同一进程只能有一个
         Sim_core();
+        // 使用 ctx 中的状态；不同上下文的核心可以在不同线程上并行运行
+        explicit Sim_core(SimContext& ctx);
         ~Sim_core();
 
         // 禁止拷贝和赋值，因为该类管理着独特的资源
@@ -46,11 +154,50 @@ namespace multiple {
         Sim_core& operator=(const Sim_core&) = delete;
 
         void sim_init();
+        // 挂接差分测试；按 cfg 中的 diff_batch / diff_async 设置批量和流水模式
+        void attach_difftest(utils::Difftest* dt);
+        // 检查完所有尚未对比的提交；返回整个运行是否一致
+        bool finish_difftest();
         CoreDebugInfo get_debug_info() const;
-        void run_inst_once();
+        // 写出飞行记录器中保留的波形；path 为空时使用 cfg.wave_file
+        bool dump_wave(const std::string& path = "");
+        // 写出访存飞行记录器中保留的记录；path 为空时使用 cfg.mem_trace_dump_file
+        bool dump_mem_trace(const std::string& path = "") const;
+        // 推进到下一条指令提交；cfg.hang_cycles 个周期内没有提交时返回 false
+        bool run_inst_once();
+        // 返回实际执行的指令数；difftest 失配或挂死 (CPU_ABORT)、执行 ebreak (CPU_END) 时提前返回。
+        // 即 max_insts = num_inst 的 run()
         int run_inst(int num_inst);
+        // 按 stop 中的条件运行，直到任一条件满足；CPU_STOP 状态下调用会从上次停下处继续
+        RunResult run(const StopConditions& stop);
         int run_cycle(int num_cycle);
         utils::diff_context_t get_diff_info();
+        uint64_t get_cycle_count() const { return cycle_cnt; }
+        uint64_t get_inst_count() const { return inst_cnt; }
+        uint64_t get_ff_inst_count() const { return ff_inst_cnt; }
+        // 把模型、内存、CPU 状态、计数器和 REF 状态保存到一个检查点文件；
+        // 需要以 --savable 编译模型 (ADAPTSIM_VERILATOR_SAVABLE)
+        bool save_checkpoint(const std::string& path);
+        // 从检查点恢复；内存页以写时复制方式映射，可从同一检查点恢复多个核心
+        bool restore_checkpoint(const std::string& path);
+        /**
+         * @brief 功能快进：REF 按 cfg 的 ff_insts / ff_pc 执行，再把其寄存器与内存装入 DUT，
+         *        之后从该点继续周期精确仿真。须在 sim_init 之后、第一条指令之前调用。
+         *        REF 在快进中停机时程序已经结束：不再装入 DUT，CPU 状态置为 CPU_END；按指令数快进时
+         *        停机点只能确定到一段之内，返回该段之前的条数。自环 (j .) 不算停机，照常装入 DUT。
+         * @param ref 参考模型；随后继续做差分测试时应与 attach_difftest 的是同一个
+         * @return REF 快进的指令数（另见 get_ff_inst_count）；失败时返回 0
+         */
+        uint64_t fast_forward(utils::Difftest& ref);
+        // 性能计数器，未启用时为空；运行中可随时读取
+        const PerfCounters* get_perf() const { return perf.get(); }
+        // 写出性能计数器 JSON；path 为空时使用 cfg.perf_file
+        bool dump_perf(const std::string& path = "") const;
+        const utils::Profiler* get_profiler() const { return profiler.get(); }
+        // 写出热点分析结果（符号取自 cfg.img_path），析构时自动调用
+        bool dump_profile();
+        // 按名称访问任意内部信号
+        const SignalRegistry& get_signals() const { return *signals; }
 
     };
 
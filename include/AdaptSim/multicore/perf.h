@@ -0,0 +1,141 @@
+//
+// 由流水线握手信号得出的微结构性能计数器
+//
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "signals.h"
+
+namespace multiple {
+
+    // 一级流水寄存器（validReg_N）的计数
+    struct StageCounters {
+        const char* name;
+        uint64_t valid = 0;  // 寄存器有效的周期（占用）
+        uint64_t fire = 0;   // 被下游取走的次数
+        uint64_t stall = 0;  // 有效但下游未取走的周期
+        uint64_t bubble = 0; // 无效的周期
+    };
+
+    // 访存请求到响应的延迟分布（周期）
+    struct LatencyCounters {
+        static constexpr size_t BUCKETS = 64; // 0..62 逐周期计数，最后一格为 63 及以上
+
+        const char* name;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = UINT64_MAX;
+        uint64_t max = 0;
+        std::array<uint64_t, BUCKETS> hist{};
+
+        void record(uint64_t latency) {
+            count++;
+            sum += latency;
+            min = latency < min ? latency : min;
+            max = latency > max ? latency : max;
+            hist[latency < BUCKETS - 1 ? latency : BUCKETS - 1]++;
+        }
+    };
+
+    /**
+     * @brief 每个时钟上升沿采样一次握手信号并累加计数。
+     *
+     * 流水级之间的寄存器为 core 顶层的 validReg_N，其出队握手为 consumerFire_N；
+     * 出队信号被 Verilator 优化掉时视为下游总是就绪（fire = valid）。
+     * 访存延迟取请求寄存器入队到响应寄存器入队之间的周期数。
+     * 计数器是普通字段，运行中可以随时读取。IPC 只按采样覆盖的区间计算，不含复位周期，
+     * 也不含第一次采样之前（快进、恢复检查点）计入的指令。
+     */
+    class PerfCounters {
+    public:
+        explicit PerfCounters(const SignalRegistry& signals);
+
+        // inst 为到本周期为止已提交的指令数，第一次采样时记为 IPC 的起点
+        void sample(uint64_t cycle, uint64_t inst) {
+            if (cycles_++ == 0) [[unlikely]] {
+                inst_base = inst;
+            }
+            for (Stage& s : stage_sigs) {
+                const bool valid = *s.valid;
+                const bool fire = s.fire ? *s.fire : valid;
+                StageCounters& c = stages_[s.index];
+                c.valid += valid;
+                c.fire += fire;
+                c.stall += valid && !fire;
+                c.bubble += !valid;
+            }
+            for (MemPort& m : mem_sigs) {
+                m.sample(cycle, latency_[m.load_index], latency_[m.store_index]);
+            }
+        }
+
+        const std::vector<StageCounters>& stages() const { return stages_; }
+        // 每个访存端口的读（及写）延迟分布
+        const std::vector<LatencyCounters>& latencies() const { return latency_; }
+        // 找到的握手信号数，为 0 时计数器没有意义
+        size_t resolved() const { return stage_sigs.size() + mem_sigs.size(); }
+
+        // 已采样的周期数
+        uint64_t cycles() const { return cycles_; }
+        // 第一次采样以来提交的指令数；inst_cnt 为当前的已提交指令数
+        uint64_t insts(uint64_t inst_cnt) const { return cycles_ ? inst_cnt - inst_base : 0; }
+
+        // 写出 JSON；IPC 为 insts(inst_cnt) / cycles()
+        bool write_json(const std::string& path, uint64_t inst_cnt) const;
+
+    private:
+        struct Stage {
+            size_t index;
+            const uint8_t* valid;
+            const uint8_t* fire; // 为空时 fire = valid
+        };
+
+        struct MemPort {
+            size_t load_index;  // latency_ 中的下标
+            size_t store_index; // 不区分读写时与 load_index 相同
+            const uint8_t* req_valid;
+            const uint8_t* req_fire;  // 请求入队；为空时用 req_valid 的上升沿
+            const uint8_t* resp_valid;
+            const uint8_t* resp_fire; // 响应入队；为空时用 resp_valid 的上升沿
+            const uint8_t* wen;       // 为空时全部计为 load
+            bool prev_req = false;
+            bool prev_resp = false;
+            bool pending = false;
+            bool pending_store = false;
+            uint64_t start = 0;
+
+            void sample(uint64_t cycle, LatencyCounters& load, LatencyCounters& store) {
+                const bool req_valid_now = *req_valid;
+                const bool resp_valid_now = *resp_valid;
+                const bool resp = resp_fire ? *resp_fire : resp_valid_now && !prev_resp;
+                if (resp && pending) {
+                    (pending_store ? store : load).record(cycle - start);
+                    pending = false;
+                }
+                const bool req = req_fire ? *req_fire : req_valid_now && !prev_req;
+                if (req && !pending) {
+                    pending = true;
+                    pending_store = wen && *wen;
+                    start = cycle;
+                }
+                prev_req = req_valid_now;
+                prev_resp = resp_valid_now;
+            }
+        };
+
+        std::vector<StageCounters> stages_;
+        std::vector<LatencyCounters> latency_;
+        std::vector<Stage> stage_sigs;
+        std::vector<MemPort> mem_sigs;
+        uint64_t cycles_ = 0;
+        uint64_t inst_base = 0;
+    };
+
+} // namespace multiple
+
+#endif //PERF_H
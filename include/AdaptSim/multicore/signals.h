@@ -0,0 +1,105 @@
+//
+// Verilator 内部信号注册表
+//
+
+#ifndef SIGNALS_H
+#define SIGNALS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class Vcore___024root;
+
+namespace multiple {
+
+    // 构建期由 tools/gen_signal_registry.py 扫描 Vcore___024root.h 生成的表项
+    struct SignalDesc {
+        const char* name;                     // Verilator 扁平化名称，如 core__DOT__RF__DOT__rf_1
+        void* (*addr)(Vcore___024root* root); // 返回该信号在某个模型实例中的地址
+        uint16_t width;                       // 位宽
+        uint16_t bytes;                       // 存储字节数 (CData=1 ... VlWide<N>=4N)
+    };
+
+    namespace detail {
+        extern const SignalDesc* const SIGNAL_TABLE;
+        extern const size_t SIGNAL_TABLE_SIZE;
+    }
+
+    // 已绑定到具体模型实例的信号
+    struct SignalRef {
+        const char* name = nullptr;
+        void* ptr = nullptr;
+        uint16_t width = 0;
+        uint16_t bytes = 0;
+
+        explicit operator bool() const { return ptr != nullptr; }
+        // 读出低 64 位
+        uint64_t value() const {
+            switch (bytes) {
+                case 1: return *static_cast<const uint8_t*>(ptr);
+                case 2: return *static_cast<const uint16_t*>(ptr);
+                case 4: return *static_cast<const uint32_t*>(ptr);
+                default: return *static_cast<const uint64_t*>(ptr);
+            }
+        }
+        // 写入低 64 位（用于向模型注入状态，宽信号的高位不变）
+        void set(uint64_t v) const {
+            switch (bytes) {
+                case 1: *static_cast<uint8_t*>(ptr) = static_cast<uint8_t>(v); break;
+                case 2: *static_cast<uint16_t*>(ptr) = static_cast<uint16_t>(v); break;
+                case 4: *static_cast<uint32_t*>(ptr) = static_cast<uint32_t>(v); break;
+                default: *static_cast<uint64_t*>(ptr) = v; break;
+            }
+        }
+    };
+
+    // 一组信号，名称只解析一次，之后按指针批量读取到连续缓冲区
+    class SignalGroup {
+    public:
+        size_t size() const { return refs.size(); }
+        const SignalRef& operator[](size_t i) const { return refs[i]; }
+        // 所有信号都解析成功
+        bool complete() const { return missing == 0; }
+
+        // 逐个信号截断为 32 位写入 out[0..size)
+        void snapshot(uint32_t* out) const;
+        // 只读取 mask 中置位的信号（第 i 位对应第 i 个信号，仅前 32 个有效）
+        void snapshot(uint32_t* out, uint32_t mask) const;
+        // 按原始字节拼接写入 out，返回写入的字节数（即 raw_size()）
+        size_t snapshot_raw(uint8_t* out) const;
+        size_t raw_size() const { return raw_bytes; }
+
+    private:
+        friend class SignalRegistry;
+        std::vector<SignalRef> refs;
+        size_t raw_bytes = 0;
+        size_t missing = 0;
+        // 所有信号存储宽度相同时走按类型展开的快路径
+        uint16_t uniform_bytes = 0;
+    };
+
+    // 某个 Vcore 实例的全部内部信号：名称 -> 地址/位宽
+    class SignalRegistry {
+    public:
+        explicit SignalRegistry(Vcore___024root* root);
+
+        size_t size() const { return signals.size(); }
+        const std::vector<SignalRef>& all() const { return signals; }
+
+        // 找不到时返回空的 SignalRef
+        SignalRef find(std::string_view name) const;
+        // 按顺序解析 names；缺失的信号保留空位并计入 missing
+        SignalGroup group(const std::vector<std::string>& names) const;
+
+    private:
+        std::vector<SignalRef> signals;
+        std::unordered_map<std::string_view, size_t> index;
+    };
+
+} // namespace multiple
+
+#endif //SIGNALS_H
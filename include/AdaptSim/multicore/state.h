@@ -7,6 +7,26 @@
 
 namespace multiple {
 
+enum class CPU_STATES
+{
+    CPU_RUNNING,
+    CPU_STOP,
+    CPU_END,
+    CPU_ABORT,
+    CPU_QUIT
+};
+
+// 创建一个结构体来保存CPU状态和返回值
+struct CPU_State {
+    CPU_STATES state;
+    int halt_ret;
+};
+
+extern CPU_State cpu_state;
+
+int is_exit_status_bad();
+int is_exit_status_bad(const CPU_State& state);
+
 class state {
 
 };
@@ -0,0 +1,242 @@
+// include/AdaptSim/utils/decode.h
+#ifndef ADAPTSIM_DECODE_H
+#define ADAPTSIM_DECODE_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace utils {
+
+    // RV32IM (+ Zicsr/Zifencei/特权级常用) 指令
+    enum class RvOp : uint8_t {
+        INVALID,
+        LUI, AUIPC, JAL, JALR,
+        BEQ, BNE, BLT, BGE, BLTU, BGEU,
+        LB, LH, LW, LBU, LHU,
+        SB, SH, SW,
+        ADDI, SLTI, SLTIU, XORI, ORI, ANDI, SLLI, SRLI, SRAI,
+        ADD, SUB, SLL, SLT, SLTU, XOR, SRL, SRA, OR, AND,
+        MUL, MULH, MULHSU, MULHU, DIV, DIVU, REM, REMU,
+        FENCE, FENCE_I,
+        ECALL, EBREAK, MRET,
+        CSRRW, CSRRS, CSRRC, CSRRWI, CSRRSI, CSRRCI,
+        COUNT
+    };
+
+    // 指令大类，供统计、过滤和性能分析使用
+    enum class InstClass : uint8_t {
+        Invalid, Alu, AluImm, Upper, Load, Store, Branch, Jump, MulDiv, Fence, System, Csr
+    };
+
+    // 编码格式
+    enum class InstFormat : uint8_t { None, R, I, S, B, U, J };
+
+    enum InstFlags : uint8_t {
+        INST_BRANCH    = 1u << 0, // 条件分支
+        INST_JUMP      = 1u << 1, // jal / jalr
+        INST_LOAD      = 1u << 2,
+        INST_STORE     = 1u << 3,
+        INST_WRITES_RD = 1u << 4, // 写回 rd（rd == x0 时不置位）
+        INST_TRAP      = 1u << 5, // ecall / ebreak / mret
+    };
+
+    // 解码结果，纯 POD，可以直接按值拷贝或放进缓存
+    struct DecodedInst {
+        uint32_t   raw;
+        int32_t    imm;
+        RvOp       op;
+        InstClass  cls;
+        InstFormat fmt;
+        uint8_t    rd;
+        uint8_t    rs1;
+        uint8_t    rs2;
+        uint8_t    flags;
+
+        constexpr bool valid() const { return op != RvOp::INVALID; }
+        constexpr bool is_branch() const { return flags & INST_BRANCH; }
+        constexpr bool is_jump() const { return flags & INST_JUMP; }
+        constexpr bool is_load() const { return flags & INST_LOAD; }
+        constexpr bool is_store() const { return flags & INST_STORE; }
+        // 会改变控制流的指令（基本块的结尾）
+        constexpr bool is_control_flow() const { return flags & (INST_BRANCH | INST_JUMP | INST_TRAP); }
+    };
+
+    namespace detail {
+        struct OpPattern {
+            uint32_t   mask;
+            uint32_t   match;
+            RvOp       op;
+            InstClass  cls;
+            InstFormat fmt;
+            uint8_t    flags;
+        };
+
+        constexpr uint32_t OPC   = 0x0000007f;
+        constexpr uint32_t F3    = 0x0000707f;
+        constexpr uint32_t F7F3  = 0xfe00707f;
+        constexpr uint32_t EXACT = 0xffffffff;
+
+        inline constexpr OpPattern OP_TABLE[] = {
+            {OPC,   0x00000037, RvOp::LUI,     InstClass::Upper,  InstFormat::U, INST_WRITES_RD},
+            {OPC,   0x00000017, RvOp::AUIPC,   InstClass::Upper,  InstFormat::U, INST_WRITES_RD},
+            {OPC,   0x0000006f, RvOp::JAL,     InstClass::Jump,   InstFormat::J, INST_JUMP | INST_WRITES_RD},
+            {F3,    0x00000067, RvOp::JALR,    InstClass::Jump,   InstFormat::I, INST_JUMP | INST_WRITES_RD},
+            {F3,    0x00000063, RvOp::BEQ,     InstClass::Branch, InstFormat::B, INST_BRANCH},
+            {F3,    0x00001063, RvOp::BNE,     InstClass::Branch, InstFormat::B, INST_BRANCH},
+            {F3,    0x00004063, RvOp::BLT,     InstClass::Branch, InstFormat::B, INST_BRANCH},
+            {F3,    0x00005063, RvOp::BGE,     InstClass::Branch, InstFormat::B, INST_BRANCH},
+            {F3,    0x00006063, RvOp::BLTU,    InstClass::Branch, InstFormat::B, INST_BRANCH},
+            {F3,    0x00007063, RvOp::BGEU,    InstClass::Branch, InstFormat::B, INST_BRANCH},
+            {F3,    0x00000003, RvOp::LB,      InstClass::Load,   InstFormat::I, INST_LOAD | INST_WRITES_RD},
+            {F3,    0x00001003, RvOp::LH,      InstClass::Load,   InstFormat::I, INST_LOAD | INST_WRITES_RD},
+            {F3,    0x00002003, RvOp::LW,      InstClass::Load,   InstFormat::I, INST_LOAD | INST_WRITES_RD},
+            {F3,    0x00004003, RvOp::LBU,     InstClass::Load,   InstFormat::I, INST_LOAD | INST_WRITES_RD},
+            {F3,    0x00005003, RvOp::LHU,     InstClass::Load,   InstFormat::I, INST_LOAD | INST_WRITES_RD},
+            {F3,    0x00000023, RvOp::SB,      InstClass::Store,  InstFormat::S, INST_STORE},
+            {F3,    0x00001023, RvOp::SH,      InstClass::Store,  InstFormat::S, INST_STORE},
+            {F3,    0x00002023, RvOp::SW,      InstClass::Store,  InstFormat::S, INST_STORE},
+            {F3,    0x00000013, RvOp::ADDI,    InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00002013, RvOp::SLTI,    InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00003013, RvOp::SLTIU,   InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00004013, RvOp::XORI,    InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00006013, RvOp::ORI,     InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00007013, RvOp::ANDI,    InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F7F3,  0x00001013, RvOp::SLLI,    InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F7F3,  0x00005013, RvOp::SRLI,    InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F7F3,  0x40005013, RvOp::SRAI,    InstClass::AluImm, InstFormat::I, INST_WRITES_RD},
+            {F7F3,  0x00000033, RvOp::ADD,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x40000033, RvOp::SUB,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x00001033, RvOp::SLL,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x00002033, RvOp::SLT,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x00003033, RvOp::SLTU,    InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x00004033, RvOp::XOR,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x00005033, RvOp::SRL,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x40005033, RvOp::SRA,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x00006033, RvOp::OR,      InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x00007033, RvOp::AND,     InstClass::Alu,    InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02000033, RvOp::MUL,     InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02001033, RvOp::MULH,    InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02002033, RvOp::MULHSU,  InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02003033, RvOp::MULHU,   InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02004033, RvOp::DIV,     InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02005033, RvOp::DIVU,    InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02006033, RvOp::REM,     InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F7F3,  0x02007033, RvOp::REMU,    InstClass::MulDiv, InstFormat::R, INST_WRITES_RD},
+            {F3,    0x0000000f, RvOp::FENCE,   InstClass::Fence,  InstFormat::I, 0},
+            {F3,    0x0000100f, RvOp::FENCE_I, InstClass::Fence,  InstFormat::I, 0},
+            {EXACT, 0x00000073, RvOp::ECALL,   InstClass::System, InstFormat::I, INST_TRAP},
+            {EXACT, 0x00100073, RvOp::EBREAK,  InstClass::System, InstFormat::I, INST_TRAP},
+            {EXACT, 0x30200073, RvOp::MRET,    InstClass::System, InstFormat::I, INST_TRAP},
+            {F3,    0x00001073, RvOp::CSRRW,   InstClass::Csr,    InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00002073, RvOp::CSRRS,   InstClass::Csr,    InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00003073, RvOp::CSRRC,   InstClass::Csr,    InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00005073, RvOp::CSRRWI,  InstClass::Csr,    InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00006073, RvOp::CSRRSI,  InstClass::Csr,    InstFormat::I, INST_WRITES_RD},
+            {F3,    0x00007073, RvOp::CSRRCI,  InstClass::Csr,    InstFormat::I, INST_WRITES_RD},
+        };
+
+        // 按 opcode[6:2] 分桶的表项索引，编译期生成，解码时只扫描同一 opcode 的几项
+        constexpr size_t BUCKET_CAP = 20;
+        struct Bucket {
+            uint8_t count;
+            uint8_t idx[BUCKET_CAP];
+        };
+
+        constexpr std::array<Bucket, 32> make_buckets() {
+            std::array<Bucket, 32> b{};
+            for (size_t i = 0; i < std::size(OP_TABLE); ++i) {
+                Bucket& bk = b[(OP_TABLE[i].match >> 2) & 31];
+                bk.idx[bk.count++] = static_cast<uint8_t>(i);
+            }
+            return b;
+        }
+        inline constexpr std::array<Bucket, 32> OP_BUCKETS = make_buckets();
+
+        constexpr int32_t sext(uint32_t v, unsigned bits) {
+            const uint32_t m = 1u << (bits - 1);
+            return static_cast<int32_t>((v ^ m) - m);
+        }
+
+        constexpr int32_t extract_imm(uint32_t x, InstFormat fmt) {
+            switch (fmt) {
+            case InstFormat::I: return sext(x >> 20, 12);
+            case InstFormat::S: return sext(((x >> 25) << 5) | ((x >> 7) & 0x1f), 12);
+            case InstFormat::B: return sext(((x >> 31) << 12) | (((x >> 7) & 1) << 11) |
+                                            (((x >> 25) & 0x3f) << 5) | (((x >> 8) & 0xf) << 1), 13);
+            case InstFormat::U: return static_cast<int32_t>(x & 0xfffff000);
+            case InstFormat::J: return sext(((x >> 31) << 20) | (((x >> 12) & 0xff) << 12) |
+                                            (((x >> 20) & 1) << 11) | (((x >> 21) & 0x3ff) << 1), 21);
+            default:            return 0;
+            }
+        }
+    } // namespace detail
+
+    // 不带缓存的表驱动解码，可在编译期求值
+    constexpr DecodedInst rv32_decode(uint32_t inst) {
+        DecodedInst d{inst, 0, RvOp::INVALID, InstClass::Invalid, InstFormat::None, 0, 0, 0, 0};
+        if ((inst & 3) != 3) {
+            return d; // 压缩指令不在 RV32IM 范围内
+        }
+        const detail::Bucket& bk = detail::OP_BUCKETS[(inst >> 2) & 31];
+        for (uint8_t i = 0; i < bk.count; ++i) {
+            const detail::OpPattern& p = detail::OP_TABLE[bk.idx[i]];
+            if ((inst & p.mask) != p.match) {
+                continue;
+            }
+            d.op = p.op;
+            d.cls = p.cls;
+            d.fmt = p.fmt;
+            d.imm = detail::extract_imm(inst, p.fmt);
+            d.rd = (p.fmt == InstFormat::S || p.fmt == InstFormat::B) ? 0 : (inst >> 7) & 31;
+            d.rs1 = (p.fmt == InstFormat::U || p.fmt == InstFormat::J) ? 0 : (inst >> 15) & 31;
+            d.rs2 = (p.fmt == InstFormat::R || p.fmt == InstFormat::S || p.fmt == InstFormat::B) ? (inst >> 20) & 31 : 0;
+            d.flags = p.flags;
+            if (d.rd == 0) {
+                d.flags &= ~INST_WRITES_RD;
+            }
+            break;
+        }
+        return d;
+    }
+
+    static_assert(rv32_decode(0x00100093).op == RvOp::ADDI && rv32_decode(0x00100093).imm == 1);
+    static_assert(rv32_decode(0xfe000ee3).is_branch() && rv32_decode(0xfe000ee3).imm == -4);
+    static_assert(rv32_decode(0x02208233).op == RvOp::MUL);
+
+    /**
+     * @brief 按指令编码直接映射的解码缓存。标签就是编码本身，
+     * 初始时所有槽都存放编码 0 的解码结果，因此不需要额外的有效位。
+     */
+    class DecodeCache {
+    public:
+        explicit DecodeCache(unsigned log2_entries = 12);
+
+        const DecodedInst& decode(uint32_t inst) {
+            DecodedInst& slot = entries[(inst * 0x9e3779b1u) >> shift];
+            if (slot.raw != inst) [[unlikely]] {
+                slot = rv32_decode(inst);
+                ++misses;
+            }
+            return slot;
+        }
+
+        uint64_t miss_count() const { return misses; }
+
+    private:
+        std::unique_ptr<DecodedInst[]> entries;
+        unsigned shift;
+        uint64_t misses = 0;
+    };
+
+    // 当前线程的解码缓存
+    const DecodedInst& decode_cached(uint32_t inst);
+
+    const char* rv_op_name(RvOp op);
+    // "R-type" / "I-type" / ... 与原 Capstone 版本 get_instruction_type 的分类一致
+    const char* instruction_type_name(const DecodedInst& d);
+
+} // namespace utils
+
+#endif //ADAPTSIM_DECODE_H
@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <cstddef> // for size_t
+#include <vector>
 
 // 类型定义，保持与你的风格一致
 using word_t = uint32_t;
@@ -14,6 +15,10 @@ using paddr_t = uint32_t;
 #define DIFFTEST_TO_DUT 0
 #define DIFFTEST_TO_REF 1
 
+namespace memory {
+    class VMem;
+}
+
 namespace utils {
 
     // 寄存器上下文结构体
@@ -77,21 +82,96 @@ namespace utils {
         bool is_good() const { return good; }
 
         /**
-         * @brief 一步完整的difftest对比流程
-         * @param dut_pc DUT当前执行指令的PC
+         * @brief 一步完整的difftest对比流程：REF执行一条指令后与DUT对比
+         * @param dut DUT刚退休指令的PC，以及该指令退休后的寄存器
          * @return 如果对比一致则返回true，否则返回false
          */
-        bool step(paddr_t dut_pc);
+        bool step(const diff_context_t& dut);
+
+        // --- 批量模式 ---
+
+        /**
+         * @brief 设置批大小。n > 1 时 commit 只记录DUT的提交，每 n 条才让REF执行 n 条并对比一次；
+         *        寄存器或store失配时REF回滚到上一个一致点，再逐条重放以找出第一条分歧指令。
+         *        回滚REF内存需要DUT内存（observe_dut_stores），否则只能按本批次DUT的store回滚。
+         * @param n        批大小（1 表示逐条对比）
+         * @param adaptive 为 true 时从 1 开始，批次一致则批大小翻倍（不超过 n）
+         */
+        void set_batch(uint32_t n, bool adaptive = false);
+
+        /**
+         * @brief 提交一条DUT退休指令，按当前模式逐条或批量对比
+         * @return 发现不一致时返回false
+         */
+        bool commit(const diff_context_t& dut);
+
+        // 立即对比已记录但尚未检查的提交（例如程序结束时）
+        bool flush();
+
+        // 已通过对比的指令数；失配时为第一条分歧指令的序号
+        uint64_t get_commit_count() const { return commit_cnt; }
+        uint32_t get_batch() const { return batch_max; }
+
+        /**
+         * @brief 记录一次DUT写内存，放入定长的store队列，在下一个对比点与REF内存核对
+         * @param old_data 写入前的内容（批量模式回滚REF内存用）
+         */
+        void store_commit(paddr_t addr, word_t data, int len, word_t old_data = 0);
+
+        // store 失配报告中使用的周期数来源
+        void set_cycle_source(const uint64_t* cycle) { cycle_src = cycle; }
+
+        // 注册为 VMem 的写内存观察者，DUT 的每次写内存都会调用 store_commit
+        void observe_dut_stores();
+
+        // REF 的物理内存区间；批量失配回滚时只同步这一段（默认与 NEMU 的 0x80000000 起 128MB 一致）
+        void set_ref_memory(paddr_t base, uint64_t size) {
+            ref_mem_base = base;
+            ref_mem_size = size;
+        }
 
-        // 用于处理写内存时的对比
-        void store_commit(paddr_t addr, word_t data, int len);
+        // 读出REF当前的寄存器状态（保存检查点用），调用前应先 flush
+        diff_context_t get_ref_state();
+        // 把REF寄存器设为 ref，丢弃所有尚未检查的记录（恢复检查点用）；REF内存由调用方同步
+        void restore_ref(const diff_context_t& ref, uint64_t commit_count);
 
         // 用于跳过一条指令的执行（例如，当遇到CSR指令时）
         void skip_dut_once();
 
 
     private:
-        void* handle; // 动态库的句柄 (void* is the correct type for dlopen handle)
+        // 对比REF与DUT：ref_pc_before 是REF执行该指令前的PC，ref 是执行后的状态
+        static bool check(paddr_t ref_pc_before, const diff_context_t& ref, const diff_context_t& dut,
+                          bool report);
+        // 用DUT状态覆盖REF（跳过指令时）
+        void sync_ref_to(const diff_context_t& dut);
+        // 批次失配：回滚REF并逐条重放 pending
+        bool bisect();
+        // 丢弃 undo_log 中已提交指令的项
+        void trim_undo_log();
+        // 核对store队列中 [begin, end) 的store：按地址合并成若干区间，每个区间只调用一次 func_memcpy 读取REF内存
+        bool check_store_range(size_t begin, size_t end, bool report);
+        // 核对已提交指令的store，并把它们移出队列
+        bool check_stores();
+        // 用DUT内存覆盖REF内存中的 [ref_mem_base, ref_mem_base + ref_mem_size)
+        void sync_ref_memory();
+        // memory::StoreObserver 回调，转发给 store_commit
+        static void on_dut_store(void* self, uint32_t addr, uint32_t len, uint32_t old_data, uint32_t new_data);
+
+        struct StoreEntry {
+            paddr_t  addr;
+            uint32_t len;
+            word_t   data;
+            uint64_t cycle;
+        };
+
+        struct StoreUndo {
+            paddr_t  addr;
+            uint32_t len;
+            word_t   old_data;
+        };
+
+        void* handle = nullptr; // 动态库的句柄 (void* is the correct type for dlopen handle)
 
         // 函数指针，用于存储从 .so 文件中查找到的函数地址
         void (*func_memcpy)(paddr_t, void*, size_t, bool);
@@ -102,6 +182,31 @@ namespace utils {
 
         bool good = false;    // 标志位，表示动态库是否加载和符号查找成功
         bool is_skip = false; // 标志位，用于跳过一次对比
+        memory::VMem* observed_mem = nullptr; // 已注册为其写观察者的 DUT 内存
+        paddr_t ref_mem_base = 0x80000000;
+        uint64_t ref_mem_size = 0x08000000;
+
+        paddr_t ref_pc = 0;           // REF下一条要执行的指令PC
+        uint64_t commit_cnt = 0;
+        uint32_t batch_max = 1;
+        uint32_t batch_cur = 1;
+        bool batch_adaptive = false;
+        diff_context_t last_good{};   // 上一个一致点的REF寄存器快照
+        std::vector<diff_context_t> pending; // 本批次DUT的逐条提交记录
+        std::vector<uint32_t> pending_stores; // 每条 pending 提交时 store 队列的长度，逐条重放时据此划分各指令的store
+        std::vector<StoreUndo> undo_log;     // 一致点之后DUT写内存的旧值，与DUT当前内存一起用于回滚REF内存
+        size_t undo_committed = 0;           // undo_log 中属于已提交指令的项数，其后的属于尚未提交的指令
+
+        static constexpr size_t STORE_QUEUE_CAP = 4096;
+        static constexpr uint32_t STORE_COALESCE_GAP = 64;   // 间隔不超过该值的store合并到同一区间
+        static constexpr uint32_t STORE_RANGE_MAX = 4096;    // 单次 func_memcpy 的最大长度（互相重叠的store不拆开，可能超出）
+        std::vector<StoreEntry> store_queue; // 容量固定为 STORE_QUEUE_CAP
+        size_t store_committed = 0;          // 已提交指令产生的store数量，其后的属于尚未提交的指令
+        uint64_t store_dropped = 0;          // 队列满时未能核对的store数
+        const uint64_t* cycle_src = nullptr;
+        std::vector<uint32_t> sq_order;      // 以下为 check_stores 的复用缓冲区
+        std::vector<uint8_t> sq_ref;
+        std::vector<int32_t> sq_owner;
     };
 
 } // namespace utils
@@ -0,0 +1,85 @@
+// include/AdaptSim/utils/difftest_pipeline.h
+#ifndef ADAPTSIM_DIFFTEST_PIPELINE_H
+#define ADAPTSIM_DIFFTEST_PIPELINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "AdaptSim/utils/difftest.h"
+#include "AdaptSim/utils/spsc_ring.h"
+
+namespace utils {
+
+    /**
+     * @brief 流水化的差分测试：DUT 线程只把提交记录放进 SPSC 队列，
+     * 检查线程驱动 REF 逐条对比，使 Verilator eval 与 REF 执行并行。
+     * 队列满时 DUT 线程等待；第一次失配会带上 DUT 的周期数报告。
+     * 批量模式失配时要用DUT内存回滚REF，与DUT线程并行时做不到，因此 start 会把批大小设回 1。
+     */
+    class DifftestPipeline {
+    public:
+        explicit DifftestPipeline(Difftest& dt, size_t capacity = 4096);
+        ~DifftestPipeline();
+
+        DifftestPipeline(const DifftestPipeline&) = delete;
+        DifftestPipeline& operator=(const DifftestPipeline&) = delete;
+
+        // 启动检查线程并接管 DUT 写内存的观察；Difftest 设置了批量模式时改回逐条对比
+        void start();
+
+        /**
+         * @brief DUT 线程：提交一条退休指令
+         * @return 检查线程已经发现失配时返回 false，DUT 应停止
+         */
+        bool commit(uint64_t cycle, const diff_context_t& dut, word_t inst);
+
+        // DUT 周期数来源，用于给 store 记录打上周期（在 DUT 线程读取）
+        void set_cycle_source(const uint64_t* cycle) { dut_cycle_src = cycle; }
+
+        // 下一条提交的指令跳过对比（MMIO、CSR 等）
+        void skip_dut_once() { skip_next = true; }
+
+        // 等待检查线程处理完所有记录并停止；返回整个运行是否一致
+        bool finish();
+
+        bool failed() const { return has_failed.load(std::memory_order_acquire); }
+        // 第一条分歧指令的序号和 DUT 周期数（仅在 failed() 时有效）
+        uint64_t mismatch_index() const { return fail_index; }
+        uint64_t mismatch_cycle() const { return fail_cycle; }
+
+    private:
+        struct Record {
+            // REG 只更新检查线程中的 DUT 寄存器影子，不对应一条指令
+            enum Kind : uint8_t { COMMIT, COMMIT_SKIP, REG, STORE } kind;
+            uint8_t  rd;     // COMMIT/REG: 写回的寄存器（0 表示无）；STORE: 字节数
+            uint64_t cycle;
+            paddr_t  addr;   // COMMIT: pc；STORE: 地址
+            word_t   data;   // COMMIT/REG: 写回值；STORE: 新数据
+            word_t   extra;  // COMMIT: 指令编码；STORE: 旧数据
+        };
+
+        void checker_loop();
+        static void on_dut_store(void* self, uint32_t addr, uint32_t len, uint32_t old_data, uint32_t new_data);
+
+        Difftest& difftest;
+        SpscRing<Record> ring;
+        std::thread checker;
+        std::atomic<bool> done{false};
+        std::atomic<bool> has_failed{false};
+        uint64_t fail_index = 0;
+        uint64_t fail_cycle = 0;
+        uint64_t checker_cycle = 0; // 检查线程当前处理的记录的周期，作为 Difftest 的周期来源
+
+        // DUT 线程侧状态
+        word_t dut_gpr[32] = {};
+        bool skip_next = false;
+        uint64_t last_cycle = 0;
+        const uint64_t* dut_cycle_src = nullptr;
+        memory::VMem* observed_mem = nullptr; // start 时当前线程绑定的 DUT 内存
+    };
+
+} // namespace utils
+
+#endif //ADAPTSIM_DIFFTEST_PIPELINE_H
@@ -5,4 +5,15 @@
 #ifndef DISASM_H
 #define DISASM_H
 
+#include <cstdint>
+#include <string>
+
+namespace utils
+{
+    // 基于 Capstone 的 RV32 反汇编（带 ANSI 颜色），实现见 src/utils/disasm.cpp
+    std::string disassemble(uint32_t addr, uint32_t instruction);
+    std::string disassemble_with_colors(uint32_t addr, uint32_t instruction);
+    void test_disassembler();
+}
+
 #endif //DISASM_H
@@ -0,0 +1,138 @@
+// include/AdaptSim/utils/itrace.h
+#ifndef ADAPTSIM_ITRACE_H
+#define ADAPTSIM_ITRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+    // 块压缩算法；未编译进对应库时自动退化为 None
+    enum class InstTraceCodec : uint8_t {
+        None = 0,
+        LZ4  = 1,
+        Zstd = 2
+    };
+
+    // 按名称 ("none" / "lz4" / "zstd") 解析压缩算法，未知名称返回 None
+    InstTraceCodec parse_inst_trace_codec(const std::string& name);
+    bool inst_trace_codec_available(InstTraceCodec codec);
+
+    /*
+     * 文件格式：
+     *   InstTraceFileHeader
+     *   { InstTraceBlockHeader, 块数据 (stored_size 字节) } ...
+     * 块数据解压后是连续的变长记录，每块开头重置差分基准，因此块可以独立解码：
+     *   flags (1B)   bit0: PC 不连续   bit1: 有寄存器写回
+     *   [pc 差分]    zigzag varint，相对 prev_pc + 4（仅 bit0）
+     *   inst (4B)
+     *   [rd (1B), 值差分]  zigzag varint，相对该寄存器在本块中上一次写回的值（仅 bit1）
+     */
+    struct InstTraceFileHeader {
+        char     magic[8]; // "ASITRACE"
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct InstTraceBlockHeader {
+        uint32_t raw_size;
+        uint32_t stored_size;
+        uint32_t n_records;
+        uint8_t  codec;
+        uint8_t  reserved[3];
+    };
+
+    inline constexpr char ITRACE_MAGIC[8] = {'A', 'S', 'I', 'T', 'R', 'A', 'C', 'E'};
+    inline constexpr uint32_t ITRACE_VERSION = 1;
+
+    // 解码后的单条提交记录
+    struct InstTraceEntry {
+        uint64_t index;    // 第几条提交的指令
+        uint32_t pc;
+        uint32_t inst;
+        uint8_t  rd;       // 0 表示没有（可见的）寄存器写回
+        uint32_t rd_value;
+    };
+
+    /**
+     * @brief 指令提交日志写入器。仿真循环中只做差分编码和追加字节，
+     * 不做格式化和反汇编；块满时（可选压缩后）整块写出。
+     */
+    class InstTraceWriter {
+    public:
+        InstTraceWriter() = default;
+        ~InstTraceWriter();
+
+        InstTraceWriter(const InstTraceWriter&) = delete;
+        InstTraceWriter& operator=(const InstTraceWriter&) = delete;
+
+        bool open(const std::string& path, InstTraceCodec codec = InstTraceCodec::None);
+        void close();
+
+        /**
+         * @brief 记录一条退休指令
+         * @param gpr 该指令退休后的 32 个通用寄存器；与上一次相比发生变化的寄存器记为写回
+         */
+        void commit(uint32_t pc, uint32_t inst, const uint32_t* gpr);
+
+        // 寄存器不经提交而整体改变时（快进、恢复检查点）重设写回判断的基准，不产生记录
+        void sync(const uint32_t* gpr);
+
+        uint64_t count() const { return n_total; }
+
+    private:
+        void reset_block();
+        void flush_block();
+
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+        static constexpr size_t MAX_RECORD = 16;
+
+        std::FILE* out = nullptr;
+        InstTraceCodec codec = InstTraceCodec::None;
+        std::vector<uint8_t> block;
+        std::vector<uint8_t> packed;
+        size_t used = 0;
+        uint32_t n_block = 0;
+        uint64_t n_total = 0;
+
+        uint32_t arch_gpr[32] = {};   // 上一条指令退休后的寄存器，用于找出写回
+        uint32_t prev_pc = 0;         // 以下为块内差分基准
+        uint32_t delta_gpr[32] = {};
+    };
+
+    /**
+     * @brief 指令提交日志读取器，供离线工具使用
+     */
+    class InstTraceReader {
+    public:
+        InstTraceReader() = default;
+        ~InstTraceReader();
+
+        InstTraceReader(const InstTraceReader&) = delete;
+        InstTraceReader& operator=(const InstTraceReader&) = delete;
+
+        bool open(const std::string& path);
+        // 读取下一条记录，文件结束或出错时返回 false
+        bool next(InstTraceEntry& entry);
+        // 跳到第 index 条记录；不需要的整块只读块头，不解压
+        bool seek(uint64_t index);
+
+    private:
+        bool load_block();
+
+        std::FILE* in = nullptr;
+        std::vector<uint8_t> block;
+        std::vector<uint8_t> packed;
+        size_t pos = 0;
+        uint32_t left_in_block = 0;
+        uint64_t next_index = 0;
+
+        uint32_t prev_pc = 0;
+        uint32_t delta_gpr[32] = {};
+    };
+
+} // namespace utils
+
+#endif //ADAPTSIM_ITRACE_H
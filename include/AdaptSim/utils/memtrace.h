@@ -0,0 +1,128 @@
+// include/AdaptSim/utils/memtrace.h
+#ifndef ADAPTSIM_MEMTRACE_H
+#define ADAPTSIM_MEMTRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+    // 单条访存记录，定长二进制格式（文件中按主机小端序存放）
+    struct MemTraceRecord {
+        uint64_t cycle;   // 发生访存时的时钟周期数
+        uint32_t addr;
+        uint32_t data;
+        uint8_t  len;     // 字节数
+        uint8_t  is_write;
+        uint8_t  reserved[6];
+    };
+    static_assert(sizeof(MemTraceRecord) == 24, "MemTraceRecord layout is part of the file format");
+
+    // 追踪文件头
+    struct MemTraceFileHeader {
+        char     magic[8];    // "ASMTRACE"
+        uint32_t version;
+        uint32_t record_size;
+    };
+    inline constexpr char MEMTRACE_MAGIC[8] = {'A', 'S', 'M', 'T', 'R', 'A', 'C', 'E'};
+    inline constexpr uint32_t MEMTRACE_VERSION = 1;
+
+    /**
+     * @brief 访存追踪：预分配的环形缓冲区，访存路径上不分配内存、不刷新输出。
+     *
+     * 两种工作方式：
+     *  - 飞行记录器 (start)：只保留最近 capacity 条记录，需要时调用 dump 写出；
+     *  - 落盘 (open)：后台线程持续把缓冲区排空到文件，缓冲区满时生产者等待。
+     */
+    class MemTrace {
+    public:
+        MemTrace() = default;
+        ~MemTrace();
+
+        MemTrace(const MemTrace&) = delete;
+        MemTrace& operator=(const MemTrace&) = delete;
+
+        // 以飞行记录器方式启动，capacity 向上取整到 2 的幂
+        void start(size_t capacity = DEFAULT_CAPACITY);
+        // 启动并在后台线程中把记录写入 path
+        bool open(const std::string& path, size_t capacity = DEFAULT_CAPACITY);
+        // 停止追踪；落盘方式下写完剩余记录并关闭文件
+        void close();
+
+        // 周期计数来源（通常是 Sim_core 的周期计数器）
+        void set_cycle_source(const uint64_t* cycle) { cycle_src = cycle; }
+
+        bool active() const { return is_active; }
+
+        // 访存回调中调用，调用方应先检查 active()
+        void record(uint32_t addr, uint32_t data, uint8_t len, bool is_write) {
+            const uint64_t h = head.load(std::memory_order_relaxed);
+            if (draining) {
+                while (h - tail.load(std::memory_order_acquire) >= capacity) {
+                    std::this_thread::yield(); // 写线程跟不上时反压
+                }
+            }
+            MemTraceRecord& r = ring[h & mask];
+            r.cycle = cycle_src ? *cycle_src : 0;
+            r.addr = addr;
+            r.data = data;
+            r.len = len;
+            r.is_write = is_write;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        // 把缓冲区中保留的记录（从旧到新）写到文件，用于飞行记录器方式
+        bool dump(const std::string& path) const;
+
+        uint64_t total_records() const { return head.load(std::memory_order_relaxed); }
+
+        static constexpr size_t DEFAULT_CAPACITY = size_t{1} << 20;
+
+    private:
+        void drain_loop();
+        // 写出 [from, to) 区间的记录
+        bool write_range(std::FILE* f, uint64_t from, uint64_t to) const;
+
+        std::unique_ptr<MemTraceRecord[]> ring;
+        size_t capacity = 0;
+        size_t mask = 0;
+        const uint64_t* cycle_src = nullptr;
+        bool is_active = false;
+        bool draining = false;
+
+        // head 只由生产者（仿真线程）写，tail 只由写线程写；分开缓存行避免伪共享
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        alignas(64) std::atomic<bool> stop_flag{false};
+        std::FILE* out = nullptr;
+        std::thread writer;
+    };
+
+    namespace detail {
+        extern MemTrace mem_trace_instance;
+        extern thread_local MemTrace* bound_mem_trace;
+    }
+
+    // 当前线程的访存追踪实例：绑定了仿真上下文时是上下文自己的实例，否则是进程默认实例。
+    // 内联以便 DPI 回调中只剩一次分支判断
+    inline MemTrace& get_mem_trace() {
+        MemTrace* trace = detail::bound_mem_trace;
+        return trace ? *trace : detail::mem_trace_instance;
+    }
+
+    // 把当前线程的 get_mem_trace() 绑定到 trace（nullptr 恢复默认实例），返回之前的绑定
+    inline MemTrace* bind_mem_trace(MemTrace* trace) {
+        MemTrace* prev = detail::bound_mem_trace;
+        detail::bound_mem_trace = trace;
+        return prev;
+    }
+
+} // namespace utils
+
+#endif //ADAPTSIM_MEMTRACE_H
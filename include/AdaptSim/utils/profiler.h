@@ -0,0 +1,191 @@
+// include/AdaptSim/utils/profiler.h
+#ifndef ADAPTSIM_PROFILER_H
+#define ADAPTSIM_PROFILER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "decode.h"
+
+namespace utils {
+
+    // ELF 符号表（STT_FUNC 与无类型标签），按地址查找所在函数
+    class SymbolTable {
+    public:
+        // 读取 ELF32 的 .symtab；不是 ELF 或没有符号时返回 false，之后查找一律落空
+        bool load_elf(const std::string& path);
+        size_t size() const { return symbols.size(); }
+
+        // 包含 addr 的符号名；找不到时返回 nullptr。offset 可选返回 addr 相对符号起始的偏移
+        const char* lookup(uint32_t addr, uint32_t* offset = nullptr) const;
+        // 同 lookup，找不到时为 "0x...." 形式的地址
+        std::string name(uint32_t addr) const;
+
+    private:
+        struct Symbol {
+            uint32_t addr;
+            uint32_t size; // 0 表示一直延伸到下一个符号
+            std::string name;
+        };
+        std::vector<Symbol> symbols; // 按地址升序
+    };
+
+    /**
+     * @brief uint32 键到计数的开放寻址表：线性探测，容量为 2 的幂，装载率超过一半时扩容。
+     * 每个槽 24 字节，热点循环中的访问基本都落在同一缓存行内。
+     */
+    class CounterMap {
+    public:
+        struct Entry {
+            uint32_t key;
+            uint32_t tag;    // 使用者自定义
+            uint64_t count;
+            uint64_t weight;
+        };
+        static constexpr uint32_t EMPTY = UINT32_MAX; // RV32 的 PC 与块号都不会取到该值
+
+        explicit CounterMap(unsigned log2_capacity = 12);
+
+        // 不存在时插入一个全零的表项
+        Entry& operator[](uint32_t key) {
+            size_t i = hash(key) & mask;
+            while (true) {
+                Entry& e = slots[i];
+                if (e.key == key) [[likely]] {
+                    return e;
+                }
+                if (e.key == EMPTY) {
+                    if ((used + 1) * 2 > slots.size()) {
+                        grow();
+                        return (*this)[key];
+                    }
+                    used++;
+                    e.key = key;
+                    return e;
+                }
+                i = (i + 1) & mask;
+            }
+        }
+
+        size_t size() const { return used; }
+        void clear();
+
+        template <typename Fn>
+        void for_each(Fn&& fn) const {
+            for (const Entry& e : slots) {
+                if (e.key != EMPTY) {
+                    fn(e);
+                }
+            }
+        }
+
+    private:
+        static size_t hash(uint32_t key) { return (key * 0x9e3779b1u) >> 2; }
+        void grow();
+
+        std::vector<Entry> slots;
+        size_t mask;
+        size_t used = 0;
+    };
+
+    /**
+     * @brief 客户程序热点分析：逐条提交或每 N 周期采样 PC，按基本块计数并生成 SimPoint BBV。
+     *
+     * - PC 直方图：count 为指令数（采样模式下为样本数），weight 为归到该 PC 的周期数；
+     * - 基本块：从块首执行到第一条控制流指令 (分支 / 跳转 / 陷入) 为止，以块首 PC 标识；
+     * - 调用栈：jal/jalr 写 ra (x1/x5) 视为调用，jalr x0, ra 视为返回，折叠栈以函数入口为帧；
+     * - BBV：每 bbv_interval 条指令一行，SimPoint 的 "T:块号:指令数" 格式。
+     */
+    class Profiler {
+    public:
+        struct Options {
+            uint64_t sample_cycles = 0; // 0 为逐条提交记录；否则每隔这么多周期记一个样本
+            uint64_t bbv_interval = 0;  // 0 不生成 BBV
+            std::string output = "prof"; // 输出前缀：.flat / .folded / .bb / .bbv
+        };
+
+        explicit Profiler(Options opt);
+        ~Profiler();
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        // 每条指令提交时调用；cycle 为提交时的周期数
+        void commit(uint32_t pc, uint32_t inst, uint64_t cycle) {
+            const DecodedInst& d = decode_cached(inst);
+            if (pending_call) [[unlikely]] {
+                enter_call(pc);
+            }
+            if (opt.sample_cycles == 0) {
+                CounterMap::Entry& e = pcs[pc];
+                e.count++;
+                e.weight += cycle - last_cycle;
+                stack_weight[cur_node] += cycle - last_cycle;
+                last_cycle = cycle;
+            } else if (cycle >= next_sample) {
+                const uint64_t n = (cycle - next_sample) / opt.sample_cycles + 1;
+                CounterMap::Entry& e = pcs[pc];
+                e.count += n;
+                e.weight += n * opt.sample_cycles;
+                stack_weight[cur_node] += n * opt.sample_cycles;
+                next_sample += n * opt.sample_cycles;
+            }
+
+            if (block_len == 0) {
+                block_start = pc;
+            }
+            block_len++;
+            if (d.is_control_flow()) {
+                end_block();
+                if (d.is_jump()) {
+                    track_call(d);
+                }
+            }
+        }
+
+        // 结束未完成的基本块与 BBV 区间，写出 flat / folded / bb 文件
+        bool write(const SymbolTable& syms);
+
+        const CounterMap& pc_histogram() const { return pcs; }
+        const CounterMap& basic_blocks() const { return blocks; }
+
+    private:
+        // 调用树节点：frame 为被调函数入口
+        struct Node {
+            uint32_t parent;
+            uint32_t frame;
+        };
+
+        void end_block();
+        void flush_interval();
+        void track_call(const DecodedInst& d);
+        void enter_call(uint32_t target);
+
+        Options opt;
+        CounterMap pcs;
+        CounterMap blocks;   // 块首 PC -> (tag = 块号, count = 执行次数, weight = 指令数)
+        CounterMap interval; // 当前 BBV 区间：块号 -> 指令数
+        uint32_t n_blocks = 0;
+        uint32_t block_start = 0;
+        uint32_t block_len = 0;
+        uint64_t interval_insts = 0;
+        std::FILE* bbv = nullptr;
+
+        uint64_t last_cycle = 0;
+        uint64_t next_sample = 0;
+
+        std::vector<Node> nodes;             // nodes[0] 为根
+        std::vector<uint64_t> stack_weight;  // 每个节点上的周期数
+        std::unordered_map<uint64_t, uint32_t> children; // (父节点 << 32 | 入口) -> 子节点
+        uint32_t cur_node = 0;
+        bool pending_call = false; // 上一条是调用，下一条提交的 PC 即被调函数入口
+    };
+
+} // namespace utils
+
+#endif //ADAPTSIM_PROFILER_H
@@ -0,0 +1,128 @@
+// include/AdaptSim/utils/selfprof.h
+#ifndef ADAPTSIM_SELFPROF_H
+#define ADAPTSIM_SELFPROF_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * 仿真器自身的耗时分析（不是客户程序的热点分析，那是 utils::Profiler）。
+ *
+ * 只有以 ADAPTSIM_SELF_PROFILE 编译时才生效；否则 SELFPROF_SCOPE 展开为空，
+ * 热点路径上不留任何代码。计时用 rdtsc，计入当前线程自己的计数器，
+ * 进程退出时（或调用 report）把各线程的数据汇总成一张表写到 stderr。
+ */
+namespace utils::selfprof {
+
+    // 被计时的路径；嵌套时外层只计入扣除内层后的自身时间（如 eval 不含其中的 DPI 回调）
+    enum class Section : uint8_t {
+        Eval,      // Top->eval()
+        MemRead,   // DPI mem_read
+        MemWrite,  // DPI mem_write
+        Wave,      // tfp->dump / 飞行记录器
+        ITrace,    // 指令提交日志
+        Difftest,  // Difftest::commit / step（包括 REF 执行与对比）
+        COUNT
+    };
+
+    const char* section_name(Section s);
+
+    // 时间戳计数；不是 x86 时退化为 steady_clock 的纳秒数
+    inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // 每个线程一份；只有所属线程写入，汇总时其他线程读取，因此用 relaxed 原子量而不是 fetch_add
+    struct ThreadStats {
+        std::atomic<uint64_t> ticks[static_cast<size_t>(Section::COUNT)] = {};
+        std::atomic<uint64_t> calls[static_cast<size_t>(Section::COUNT)] = {};
+        unsigned id = 0; // 按首次计时的先后编号
+
+        void add(Section s, uint64_t t) {
+            const size_t i = static_cast<size_t>(s);
+            ticks[i].store(ticks[i].load(std::memory_order_relaxed) + t, std::memory_order_relaxed);
+            calls[i].store(calls[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    };
+
+    // 当前线程的计数器；第一次调用时登记到全局表中，线程退出后数据仍保留到汇总
+    ThreadStats& thread_stats();
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Section s) : section(s), parent(current), start(now()) { current = this; }
+        ~ScopedTimer() {
+            const uint64_t elapsed = now() - start;
+            current = parent;
+            if (parent) {
+                parent->child += elapsed;
+            }
+            thread_stats().add(section, elapsed - child);
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        static inline thread_local ScopedTimer* current = nullptr;
+        Section section;
+        ScopedTimer* parent;
+        uint64_t start;
+        uint64_t child = 0; // 内层计时段的总时长
+    };
+
+    /**
+     * @brief 进度行：每隔 interval_ms 打印一次仿真频率、MIPS 与剩余时间。
+     * tick 在每条指令提交时调用，只比较一次指令数，每隔若干条指令才读一次时钟。
+     */
+    class Progress {
+    public:
+        // budget 为本次运行的指令数上限（0 表示不限，不估算剩余时间）
+        Progress(uint64_t insts, uint64_t cycles, uint64_t budget, uint32_t interval_ms);
+
+        void tick(uint64_t insts, uint64_t cycles) {
+            if (insts >= next_check) [[unlikely]] {
+                check(insts, cycles);
+            }
+        }
+
+    private:
+        void check(uint64_t insts, uint64_t cycles);
+
+        using clock = std::chrono::steady_clock;
+        clock::time_point begin, last;
+        uint64_t insts0, cycles0;     // 运行开始时的计数
+        uint64_t last_insts, last_cycles;
+        uint64_t budget;
+        clock::duration interval;
+        uint64_t check_stride = 1024; // 两次读时钟之间的指令数，按实际速度调整
+        uint64_t next_check;
+    };
+
+    // 把各线程的耗时汇总成表写到 out；进程退出时若有计时数据会自动调用一次
+    void report(std::FILE* out = stderr);
+
+} // namespace utils::selfprof
+
+#define SELFPROF_CONCAT_IMPL(a, b) a##b
+#define SELFPROF_CONCAT(a, b) SELFPROF_CONCAT_IMPL(a, b)
+
+#ifdef ADAPTSIM_SELF_PROFILE
+// 为当前作用域计时
+#define SELFPROF_SCOPE(section) \
+    ::utils::selfprof::ScopedTimer SELFPROF_CONCAT(selfprof_timer_, __LINE__)(::utils::selfprof::Section::section)
+#else
+#define SELFPROF_SCOPE(section) ((void)0)
+#endif
+
+#endif //ADAPTSIM_SELFPROF_H
@@ -0,0 +1,79 @@
+// include/AdaptSim/utils/spsc_ring.h
+#ifndef ADAPTSIM_SPSC_RING_H
+#define ADAPTSIM_SPSC_RING_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace utils {
+
+    /**
+     * @brief 有界单生产者/单消费者无锁环形队列。
+     * 两端各自缓存对方的索引，只有在看起来满/空时才重新读取原子变量。
+     */
+    template <typename T>
+    class SpscRing {
+    public:
+        explicit SpscRing(size_t capacity)
+            : cap(std::bit_ceil(capacity < 2 ? size_t{2} : capacity)),
+              mask(cap - 1),
+              slots(std::make_unique<T[]>(cap)) {}
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        // 生产者：队列满时返回 false
+        bool try_push(const T& v) {
+            const uint64_t h = head.load(std::memory_order_relaxed);
+            if (h - tail_cache >= cap) {
+                tail_cache = tail.load(std::memory_order_acquire);
+                if (h - tail_cache >= cap) {
+                    return false;
+                }
+            }
+            slots[h & mask] = v;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 生产者：队列满时让出 CPU 等待（反压）
+        void push(const T& v) {
+            while (!try_push(v)) {
+                std::this_thread::yield();
+            }
+        }
+
+        // 消费者：队列空时返回 false
+        bool try_pop(T& v) {
+            const uint64_t t = tail.load(std::memory_order_relaxed);
+            if (t == head_cache) {
+                head_cache = head.load(std::memory_order_acquire);
+                if (t == head_cache) {
+                    return false;
+                }
+            }
+            v = slots[t & mask];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const { return cap; }
+
+    private:
+        const size_t cap;
+        const size_t mask;
+        std::unique_ptr<T[]> slots;
+
+        alignas(64) std::atomic<uint64_t> head{0}; // 生产者写
+        uint64_t tail_cache = 0;                   // 生产者缓存的 tail
+        alignas(64) std::atomic<uint64_t> tail{0}; // 消费者写
+        uint64_t head_cache = 0;                   // 消费者缓存的 head
+    };
+
+} // namespace utils
+
+#endif //ADAPTSIM_SPSC_RING_H
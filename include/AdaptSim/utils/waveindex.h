@@ -0,0 +1,125 @@
+// include/AdaptSim/utils/waveindex.h
+#ifndef ADAPTSIM_WAVEINDEX_H
+#define ADAPTSIM_WAVEINDEX_H
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+    /*
+     * VCD 旁路索引 (<wave.vcd>.widx)，供离线查询大波形文件的任意时间窗口：
+     *   WaveIndexHeader
+     *   检查点数据 ...       每个检查点按值槽位顺序存 { u32 长度, 值 }，即该时间戳之前所有信号的值
+     *   信号表              n_signals × { u32 slot, u32 width, str id, str name, str range, str type }（str 为 u16 长度 + 字节）
+     *   检查点目录          n_checkpoints × WaveCheckpoint
+     *   时间标记            n_markers × WaveMarker
+     * 查询从时间窗口之前最近的检查点恢复全部信号值，只需读检查点到窗口结束之间的内容。
+     * 时间标记更密，导出不筛选信号的窗口时用来确定可以整段拷贝的区间。
+     */
+    struct WaveIndexHeader {
+        char     magic[8]; // "ASWAVIDX"
+        uint32_t version;
+        uint32_t n_slots;  // 不同的 VCD 标识符个数（同一标识符的别名共享一个槽位）
+        uint64_t vcd_size; // 建索引时 VCD 的大小与修改时间，用于发现过期的索引
+        int64_t  vcd_mtime;
+        uint64_t body_offset; // $enddefinitions $end 之后的第一个字节
+        uint64_t end_time;    // 最后一个时间戳
+        uint64_t signals_offset;
+        uint64_t checkpoints_offset;
+        uint64_t markers_offset;
+        uint32_t n_signals;
+        uint32_t n_checkpoints;
+        uint64_t n_markers;
+        char     timescale[16];
+    };
+
+    struct WaveCheckpoint {
+        uint64_t time;        // 检查点位于该时间戳之前
+        uint64_t offset;      // 该时间戳在 VCD 中的偏移
+        uint64_t data_offset; // 检查点数据在索引文件中的偏移
+    };
+
+    struct WaveMarker {
+        uint64_t time;
+        uint64_t offset;
+    };
+
+    inline constexpr char WAVEIDX_MAGIC[8] = {'A', 'S', 'W', 'A', 'V', 'I', 'D', 'X'};
+    inline constexpr uint32_t WAVEIDX_VERSION = 1;
+
+    struct WaveSignal {
+        std::string name;  // 层次名，如 TOP.core.IFU.pc
+        std::string range; // 位选，如 [31:0]，没有时为空
+        std::string type;  // wire / reg ...
+        std::string id;    // VCD 标识符
+        uint32_t width;
+        uint32_t slot;     // 值槽位
+    };
+
+    struct WaveIndexOptions {
+        uint64_t checkpoint_bytes = 64u << 20; // 相邻检查点之间的 VCD 字节数，决定查询时最多多读多少
+        uint64_t marker_bytes = 1u << 20;      // 相邻时间标记之间的 VCD 字节数
+    };
+
+    // 默认的索引路径：<vcd>.widx
+    std::string wave_index_path(const std::string& vcd);
+
+    /**
+     * @brief 顺序读一遍 VCD 生成索引。内存占用只与信号数和检查点个数有关，与文件大小无关。
+     */
+    bool build_wave_index(const std::string& vcd, const std::string& idx, const WaveIndexOptions& opts = {});
+
+    /**
+     * @brief 基于索引查询 VCD 的时间窗口
+     *
+     * 窗口为 [t0, t1]：t0 时刻（含该时刻的变化）的值作为初值，之后报告 (t0, t1] 内的变化。
+     */
+    class WaveIndex {
+    public:
+        WaveIndex() = default;
+        ~WaveIndex();
+
+        WaveIndex(const WaveIndex&) = delete;
+        WaveIndex& operator=(const WaveIndex&) = delete;
+
+        // 索引不存在或与 VCD 不一致时返回 false（stale() 区分两种情况）
+        bool open(const std::string& vcd, const std::string& idx);
+        bool stale() const { return is_stale; }
+
+        const std::vector<WaveSignal>& signals() const { return sigs; }
+        const WaveIndexHeader& header() const { return hdr; }
+
+        // 按层次名匹配信号：支持通配符；不带通配符时也匹配以 ".pattern" 结尾的名字
+        std::vector<size_t> find(const std::string& pattern) const;
+
+        // (时间, 信号下标, 值)；值保留 VCD 中的写法（标量 "1"、向量 "b0101"、实数 "r1.5"）
+        using ChangeFn = std::function<void(uint64_t, size_t, const std::string&)>;
+
+        // 报告所选信号在 t0 的值，以及 (t0, t1] 内的每次变化
+        bool values(uint64_t t0, uint64_t t1, const std::vector<size_t>& selected, const ChangeFn& fn);
+
+        // 导出只含窗口的 VCD；selected 为空时保留全部信号，窗口内的内容整段拷贝
+        bool trim(uint64_t t0, uint64_t t1, const std::vector<size_t>& selected, std::FILE* out);
+
+    private:
+        class Scanner;
+
+        // 打开 VCD 并从 t0 之前最近的检查点恢复信号值
+        bool load_checkpoint(uint64_t t0, Scanner& sc);
+
+        std::string vcd_path;
+        std::FILE* idx = nullptr;
+        WaveIndexHeader hdr{};
+        bool is_stale = false;
+        std::vector<WaveSignal> sigs;
+        std::vector<WaveCheckpoint> ckpts;
+        std::vector<WaveMarker> markers;
+    };
+
+} // namespace utils
+
+#endif //ADAPTSIM_WAVEINDEX_H
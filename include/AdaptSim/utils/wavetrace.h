@@ -0,0 +1,146 @@
+// include/AdaptSim/utils/wavetrace.h
+#ifndef ADAPTSIM_WAVETRACE_H
+#define ADAPTSIM_WAVETRACE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VerilatedVcdC;
+class VerilatedVcdFile;
+
+namespace utils {
+
+    /**
+     * @brief 波形飞行记录器：VCD 输出写进内存中的分段环形缓冲区，只保留最近若干周期。
+     *
+     * 每段以完整的头部和一次全量值开始（借助 VerilatedVcdC::openNext），
+     * 因此丢弃最旧的段后剩下的内容仍能拼成合法的 VCD。保留的段数固定，
+     * 覆盖的周期数不少于 window_cycles。
+     */
+    class WaveRecorder {
+    public:
+        explicit WaveRecorder(uint64_t window_cycles, unsigned segments = DEFAULT_SEGMENTS);
+        ~WaveRecorder();
+
+        WaveRecorder(const WaveRecorder&) = delete;
+        WaveRecorder& operator=(const WaveRecorder&) = delete;
+
+        // 交给 Vcore::trace 挂接；挂接后调用 open
+        VerilatedVcdC* vcd() { return tfp.get(); }
+        void open();
+
+        // 每半个周期调用一次；cycle 跨过段长时切换到下一段
+        void dump(uint64_t time, uint64_t cycle);
+
+        // 把保留的波形（从旧到新）写到 path
+        bool save(const std::string& path);
+
+        uint64_t window() const { return seg_cycles * (n_segments - 1); }
+
+        static constexpr unsigned DEFAULT_SEGMENTS = 8;
+
+    private:
+        class RingFile;
+
+        std::unique_ptr<RingFile> file;
+        std::unique_ptr<VerilatedVcdC> tfp;
+        unsigned n_segments;
+        uint64_t seg_cycles;
+        uint64_t seg_start = 0;
+    };
+
+    enum class WaveCompression : uint8_t { None, Zstd };
+
+    // "none" / "zstd"；不认识的名字或未编译进 zstd 时返回 false
+    bool parse_wave_compression(const std::string& name, WaveCompression& out);
+
+    /**
+     * @brief 异步波形输出：作为 VerilatedVcdC 的输出目标，仿真线程只把格式化好的变化值
+     * 追加到当前缓冲区，写满后交给后台线程写盘（可选 zstd 流式压缩）并换用另一块缓冲区。
+     * 只有两块缓冲区都满（后台线程还没写完上一块）时仿真线程才等待。
+     *
+     * 压缩时 open 的文件名会追加 ".zst"，可直接 zstd -d 还原为 VCD。
+     */
+    class AsyncWaveSink {
+    public:
+        explicit AsyncWaveSink(size_t buffer_bytes = DEFAULT_BUFFER, WaveCompression compression = WaveCompression::None);
+        ~AsyncWaveSink();
+
+        AsyncWaveSink(const AsyncWaveSink&) = delete;
+        AsyncWaveSink& operator=(const AsyncWaveSink&) = delete;
+
+        // 交给 VerilatedVcdC 的构造函数，之后经由 VerilatedVcdC 的 open/close 打开和关闭文件；
+        // 该 VerilatedVcdC 须先于本对象销毁
+        VerilatedVcdFile* file();
+
+        uint64_t bytes_in() const;     // 仿真线程交来的 VCD 字节数
+        uint64_t bytes_out() const;    // 实际写盘的字节数（压缩后）
+        uint64_t stall_count() const;  // 仿真线程因两块缓冲区都满而等待的次数
+
+        static constexpr size_t DEFAULT_BUFFER = 4u << 20;
+
+    private:
+        class File;
+        std::unique_ptr<File> impl;
+    };
+
+    // 触发式波形窗口：区间均为左闭右开
+    struct WaveWindow {
+        enum class Trigger {
+            PcRange,    // PC 进入 [begin, end) 时开始，离开时结束；可多次触发
+            InstCount,  // 已提交指令数在 [begin, end) 内
+            CycleRange  // 时钟周期在 [begin, end) 内
+        };
+        Trigger trigger;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // 解析 "pc:0x80000000-0x80000100" / "inst:1000-2000" / "cycle:5000-6000"
+    bool parse_wave_window(const std::string& spec, WaveWindow& out);
+
+    // 一次 poll 的结果：先关闭当前文件（如有），再因 open 号窗口打开新文件（如有）
+    struct WaveTriggerEvent {
+        bool close = false;
+        int open = -1;
+    };
+
+    /**
+     * @brief 触发式波形窗口的判定逻辑，不涉及波形对象本身。
+     *
+     * 有任一窗口处于激活状态时输出波形；重叠的窗口共用一个文件，
+     * 从无到有激活时开一个新文件，总数不超过 max_files。
+     * PC 与指令数触发在指令提交时判断，周期触发在时钟循环里按 next_cycle_event 判断。
+     */
+    class WaveTrigger {
+    public:
+        explicit WaveTrigger(std::vector<WaveWindow> windows, unsigned max_files = 64);
+
+        bool empty() const { return windows.empty(); }
+        bool recording() const { return n_active > 0; }
+
+        // at_commit 为 false 时只判断周期窗口
+        WaveTriggerEvent poll(uint32_t pc, uint64_t inst_cnt, uint64_t cycle, bool at_commit);
+        // 下一个需要在时钟循环中 poll 的周期；没有则为 UINT64_MAX
+        uint64_t next_cycle_event() const { return next_cycle; }
+
+    private:
+        bool should_close(const WaveWindow& w, size_t i, uint64_t inst_cnt, uint64_t cycle, bool at_commit) const;
+        bool should_open(const WaveWindow& w, size_t i, uint64_t inst_cnt, uint64_t cycle, bool at_commit) const;
+        void update_next_cycle();
+
+        std::vector<WaveWindow> windows;
+        std::vector<uint8_t> fired;   // 指令数/周期窗口只触发一次
+        std::vector<uint8_t> inside;  // PC 窗口：上次提交时是否在区间内
+        std::vector<uint8_t> active;
+        size_t n_active = 0;
+        unsigned files_left;
+        uint64_t next_cycle = UINT64_MAX;
+    };
+
+} // namespace utils
+
+#endif //ADAPTSIM_WAVETRACE_H
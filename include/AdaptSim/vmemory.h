@@ -4,25 +4,113 @@
 
 #include <cstdint>
 #include <cstddef>
-#include <vector>
+#include <atomic>
+#include <array>
+#include <memory>
 #include <string>
-#include <map>
+#include <vector>
 
 namespace memory
 {
+    // 镜像加载方式
+    enum class LoadMode {
+        Copy, // 按页批量拷贝进 VMem
+        Mmap  // 以 MAP_PRIVATE 映射文件页，首次写入时由内核写时复制
+    };
+
+    // DUT 写内存的观察者（difftest 使用），在 mem_write 写入 VMem 之前调用。
+    // 未设置时 mem_write 只多一次分支。
+    using StoreObserver = void (*)(void* user, uint32_t addr, uint32_t len, uint32_t old_data, uint32_t new_data);
+
+    // VMem::snapshot() 返回的句柄：与 VMem 共享页，只持有页指针；拷贝句柄不复制页内容
+    class MemSnapshot {
+    public:
+        bool valid() const { return state != nullptr; }
+        size_t page_count() const { return state ? state->addrs.size() : 0; }
+
+    private:
+        friend class VMem;
+        struct State {
+            std::vector<uint32_t> addrs;                 // 页地址，升序
+            std::vector<std::shared_ptr<uint8_t>> pages; // 与 addrs 一一对应
+        };
+        std::shared_ptr<const State> state;
+    };
+
     class VMem {
+    public:
+        // 4KB 页；32 位地址 = 10 位一级索引 + 10 位二级索引 + 12 位页内偏移
+        static constexpr uint32_t PAGE_SHIFT = 12;
+        static constexpr uint32_t PAGE_SIZE  = 1u << PAGE_SHIFT;
+        static constexpr uint32_t PAGE_MASK  = PAGE_SIZE - 1;
+        static constexpr uint32_t L2_BITS    = 10;
+        static constexpr uint32_t L1_BITS    = 32 - PAGE_SHIFT - L2_BITS;
+        static constexpr uint32_t L1_ENTRIES = 1u << L1_BITS;
+        static constexpr uint32_t L2_ENTRIES = 1u << L2_BITS;
+
     private:
-        // 使用 4KB 大小的内存块
-        static constexpr uint32_t BLOCK_SIZE = 4096;
-        // 使用 map 来稀疏地存储内存块
-        std::map<uint32_t, std::vector<uint8_t>> memory_blocks;
+        struct alignas(64) Page {
+            uint8_t data[PAGE_SIZE];
+        };
+
+        // 二级页表，按需分配；一级目录常驻 (8KB)
+        // pages 是读路径唯一查看的数组；wpages 非空表示该页可以原地写（只属于本 VMem 或是 mmap 的私有页），
+        // 为空时写路径先分配或复制该页。owned 持有页：堆上的页，或指向文件映射的别名（映射随最后一页释放）
+        struct PageTable {
+            std::array<uint8_t*, L2_ENTRIES> pages{};
+            std::array<uint8_t*, L2_ENTRIES> wpages{};
+            std::array<std::shared_ptr<uint8_t>, L2_ENTRIES> owned;
+            std::array<bool, L2_ENTRIES> dirty{}; // 已记入 dirty_log
+        };
+        std::array<std::unique_ptr<PageTable>, L1_ENTRIES> page_dir;
+        size_t page_count = 0;
+
+        // 最近一次 snapshot() / restore() 之后被改动的页，连同改动前的页（为空表示原来没有这一页）
+        struct DirtyPage {
+            uint32_t addr;
+            std::shared_ptr<uint8_t> prev;
+        };
+        std::shared_ptr<const MemSnapshot::State> snap_base; // dirty_log 所相对的快照；为空时不记录
+        std::vector<DirtyPage> dirty_log;
+
+        StoreObserver store_observer = nullptr;
+        void* store_observer_user = nullptr;
+
+        bool verbose = true; // 加载镜像后是否在 stdout 上打印一行摘要
 
-        // 内部辅助函数，用于获取或创建内存块
-        std::vector<uint8_t>& get_or_create_block(uint32_t addr);
+        static constexpr uint32_t l1_index(uint32_t addr) { return addr >> (PAGE_SHIFT + L2_BITS); }
+        static constexpr uint32_t l2_index(uint32_t addr) { return (addr >> PAGE_SHIFT) & (L2_ENTRIES - 1); }
+
+        // 查找页，不存在时返回 nullptr（读路径不分配内存）
+        uint8_t* find_page(uint32_t addr) const;
+        // 内部辅助函数，获取可写的页：不存在时创建（新页清零），与快照共享时先复制
+        uint8_t* get_or_create_page(uint32_t addr) {
+            if (PageTable* table = page_dir[l1_index(addr)].get()) {
+                if (uint8_t* page = table->wpages[l2_index(addr)]) [[likely]] {
+                    return page;
+                }
+            }
+            return make_writable(addr);
+        }
+        uint8_t* make_writable(uint32_t addr);
+        // 让 addr 所在页直接指向外部内存（用于 mmap 映射），page 持有该内存
+        void map_page(uint32_t addr, std::shared_ptr<uint8_t> page);
+        // 换掉 addr 所在页之前，在记录脏页时保存原来的页
+        void log_dirty(PageTable& table, uint32_t addr);
+
+        // 以私有可写方式映射整个文件，data 释放时解除映射；管道、设备等无法映射的文件改为读入内存。
+        // 空文件也算成功，此时 data 为空、size 为 0
+        static bool map_file(const std::string& filename, std::shared_ptr<uint8_t>& data, size_t& size);
+        // 将已映射文件中 [file_off, file_off + n) 放到 addr 处；页对齐的整页直接映射，其余拷贝
+        void place_mapped(uint32_t addr, const std::shared_ptr<uint8_t>& file, size_t file_off, size_t n, LoadMode mode);
+
+        // 跨页访问的逐字节慢速路径
+        uint32_t read_slow(uint32_t addr, uint32_t len) const;
+        void write_slow(uint32_t addr, uint32_t len, uint32_t data);
 
     public:
         VMem();
-        ~VMem() = default;
+        ~VMem();
 
         // 禁止拷贝和赋值
         VMem(const VMem&) = delete;
@@ -32,13 +120,108 @@ namespace memory
         uint32_t read(uint32_t addr, uint32_t len);
         void write(uint32_t addr, uint32_t len, uint32_t data);
 
+        // 批量读写任意长度的字节，按页拷贝
+        void read_bytes(uint32_t addr, void* dst, size_t n) const;
+        void write_bytes(uint32_t addr, const void* src, size_t n);
+        // 将区间清零；尚未分配的页本来就读出 0，因此不会被分配
+        void zero_range(uint32_t addr, size_t n);
+
+        // 已分配（或已映射）的页数
+        size_t allocated_pages() const { return page_count; }
+        // 丢弃全部页与文件映射，回到刚构造时的状态
+        void clear();
+        // 丢弃本实例的全部页，改为接管 other 的页（other 变为空）；写观察者各自保留
+        void take_pages(VMem& other);
+
+        // 按地址升序遍历已分配（或已映射）的页：fn(uint32_t page_addr, const uint8_t* data)
+        template <typename Fn>
+        void for_each_page(Fn&& fn) const {
+            for (uint32_t l1 = 0; l1 < L1_ENTRIES; ++l1) {
+                const PageTable* table = page_dir[l1].get();
+                if (!table) {
+                    continue;
+                }
+                for (uint32_t l2 = 0; l2 < L2_ENTRIES; ++l2) {
+                    if (const uint8_t* page = table->pages[l2]) {
+                        fn((l1 << (PAGE_SHIFT + L2_BITS)) | (l2 << PAGE_SHIFT), page);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief 页级写时复制快照：只复制页指针，之后第一次写某页时才复制该页
+         *
+         * 两次快照之间改动的页记在脏页表里；restore 回到最近一次快照（或最近一次 restore 的快照）
+         * 只需还原这些页。恢复到更早的快照要重建整个页表，耗时与页数成正比。
+         */
+        MemSnapshot snapshot();
+        void restore(const MemSnapshot& snap);
+
+        // 自最近一次 snapshot() / restore() 以来改动过的页数；从未做过快照时为 0
+        size_t dirty_pages() const { return dirty_log.size(); }
+        bool tracking_dirty() const { return snap_base != nullptr; }
+
+        // 按首次改动的顺序遍历脏页：fn(uint32_t page_addr, const uint8_t* data)，data 为空表示该页已不存在。
+        // 从未做过快照时没有基准，遍历全部页（差分测试同步、检查点、事后转储只需处理改动过的内存）
+        template <typename Fn>
+        void for_each_dirty_page(Fn&& fn) const {
+            if (!snap_base) {
+                for_each_page(fn);
+                return;
+            }
+            for (const DirtyPage& d : dirty_log) {
+                fn(d.addr, static_cast<const uint8_t*>(find_page(d.addr)));
+            }
+        }
+
+        // 以 MAP_PRIVATE 映射 filename，把从 data_offset 开始连续的 n 个整页依次放到 addrs[i]；
+        // 页在首次写入时才由内核复制，同一文件可被多个 VMem 共享（检查点恢复用）
+        bool map_file_pages(const std::string& filename, const uint32_t* addrs, size_t n, uint64_t data_offset);
+
+        // 本实例的写观察者；传 nullptr 取消
+        void set_store_observer(StoreObserver fn, void* user) {
+            store_observer = fn;
+            store_observer_user = user;
+        }
+        bool has_store_observer() const { return store_observer != nullptr; }
+        // 在写入之前通知观察者（附带旧值）
+        void notify_store(uint32_t addr, uint32_t len, uint32_t data) {
+            store_observer(store_observer_user, addr, len, read(addr, len), data);
+        }
+
+        // 加载函数默认打印一行摘要；批量构造、反复加载的调用方（测试、基准）可以关掉
+        void set_verbose(bool v) { verbose = v; }
+
         // 从文件加载内容到内存
-        bool load_from_file(const std::string& filename, uint32_t offset);
+        bool load_from_file(const std::string& filename, uint32_t offset, LoadMode mode = LoadMode::Copy);
         bool load_default_img(uint32_t offset);
+        // 加载 ELF32 (RISC-V, 小端) 镜像的 PT_LOAD 段，.bss 延迟清零；entry 可选返回入口地址
+        bool load_elf(const std::string& filename, uint32_t* entry = nullptr, LoadMode mode = LoadMode::Copy);
     };
 
-    // 提供一个全局的内存访问点
-    VMem& get_memory();
+    namespace detail {
+        extern thread_local VMem* bound_memory;
+        // 线程没有绑定时由 default_memory() 先调用它尝试建立绑定（多线程模型的 DPI 回调运行在
+        // Verilator 工作线程上，由 SimContext 按 DPI scope 找回所属上下文），成功时返回 true
+        extern std::atomic<bool (*)()> bind_unbound_thread;
+        VMem& default_memory();
+    }
+
+    // 当前线程的内存访问点：绑定了仿真上下文时是上下文自己的 VMem，否则是进程默认实例。
+    // DPI 回调经由这里找到所属仿真的内存。
+    inline VMem& get_memory() {
+        VMem* mem = detail::bound_memory;
+        return mem ? *mem : detail::default_memory();
+    }
+
+    // 把当前线程的 get_memory() 绑定到 mem（nullptr 恢复默认实例），返回之前的绑定
+    VMem* bind_memory(VMem* mem);
+
+    // 设置 get_memory() 当前所指实例的写观察者
+    inline void set_store_observer(StoreObserver fn, void* user) {
+        get_memory().set_store_observer(fn, user);
+    }
 
 } // namespace memory
 
@@ -49,4 +232,4 @@ extern "C" {
     void data_mem_write(int addr, int len, int data);
 }
 
-#endif //ADAPTSIM_VMEMORY_H
\ No newline at end of file
+#endif //ADAPTSIM_VMEMORY_H
@@ -12,12 +12,41 @@ namespace multiple {
     cfg cfg_inst {
         .diff_enaled = true,
         .trace_enabled = true,
-        .inst_trace_enabled = true,
+        .inst_trace_enabled = false,
+        .inst_trace_file = "itrace.bin",
+        .inst_trace_codec = "none",
         .mem_trace_enabled = true,
+        .mem_trace_file = "",
+        .mem_trace_dump_file = "memtrace.bin",
+        .perf_enabled = false,
+        .perf_file = "perf.json",
+        .prof_enabled = false,
+        .prof_sample_cycles = 0,
+        .prof_bbv_interval = 100000000,
+        .prof_output = "prof",
         .diff_ref_path = "/home/sealessland/ysyx-workbench/nemu/build/riscv32-nemu-interpreter-so",
+        .diff_batch = 1,
+        .diff_batch_adaptive = false,
+        .diff_async = false,
+        .hang_cycles = 100000,
+        .selfprof_progress_ms = 1000,
+        .specialize_loop = true,
+        .ff_insts = 0,
+        .ff_pc = 0,
+        .ff_mem_base = 0x80000000,
+        .ff_mem_size = 0x08000000,
+        .ff_pc_signal = "core__DOT__IFU__DOT__pc",
         .wave_file = "wave.vcd",
+        .wave_flight = false,
+        .wave_flight_cycles = 100000,
+        .wave_windows = {},
+        .wave_window_max_files = 64,
+        .wave_async = false,
+        .wave_compress = "none",
+        .wave_async_buffer_kb = 4096,
         .img_path = "",
-        .extern_img = false
+        .extern_img = false,
+        .mmap_img = false
     };
 
 } // namespace multiple
\ No newline at end of file
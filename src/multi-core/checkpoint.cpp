@@ -0,0 +1,333 @@
+// src/multi-core/checkpoint.cpp
+//
+// Sim_core 检查点的保存与恢复
+//
+
+#include "AdaptSim/multicore/checkpoint.h"
+#include "AdaptSim/multicore/core.h"
+#include "AdaptSim/multicore/context.h"
+#include "AdaptSim/vmemory.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "Vcore.h"
+#include "verilated.h"
+#ifdef ADAPTSIM_VERILATOR_SAVABLE
+#include "verilated_save.h"
+#endif
+
+namespace multiple {
+
+    namespace {
+
+        constexpr uint64_t CKPT_PAGE_SIZE = memory::VMem::PAGE_SIZE;
+
+        constexpr uint64_t align_up(uint64_t v, uint64_t a) {
+            return (v + a - 1) & ~(a - 1);
+        }
+
+#ifdef ADAPTSIM_VERILATOR_SAVABLE
+        // VerilatedSave / VerilatedRestore 只能读写独立文件，这里改为读写内存，
+        // 以便模型状态作为检查点文件中的一个段
+        class BlobSave final : public VerilatedSerialize {
+        public:
+            explicit BlobSave(std::vector<uint8_t>& out) : out(out) {
+                m_isOpen = true;
+                m_cp = m_bufp;
+                header();
+            }
+            ~BlobSave() override { close(); }
+            void close() override {
+                if (m_isOpen) {
+                    flush();
+                    m_isOpen = false;
+                }
+            }
+            void flush() override {
+                out.insert(out.end(), m_bufp, m_cp);
+                m_cp = m_bufp;
+            }
+
+        private:
+            std::vector<uint8_t>& out;
+        };
+
+        class BlobRestore final : public VerilatedDeserialize {
+        public:
+            explicit BlobRestore(const std::vector<uint8_t>& in) : in(in) {
+                m_isOpen = true;
+                m_cp = m_endp = m_bufp;
+                header();
+            }
+            ~BlobRestore() override { close(); }
+            void close() override { m_isOpen = false; }
+            void fill() override {
+                // 把未读完的数据移到缓冲区开头，再从 in 中补满
+                const size_t left = static_cast<size_t>(m_endp - m_cp);
+                std::memmove(m_bufp, m_cp, left);
+                m_cp = m_bufp;
+                m_endp = m_bufp + left;
+                const size_t n = std::min(in.size() - pos, bufferSize() - left);
+                std::memcpy(m_endp, in.data() + pos, n);
+                m_endp += n;
+                pos += n;
+            }
+
+        private:
+            const std::vector<uint8_t>& in;
+            size_t pos = 0;
+        };
+#endif
+
+        bool write_at(std::FILE* f, uint64_t offset, const void* data, size_t n) {
+            return std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0 && std::fwrite(data, 1, n, f) == n;
+        }
+
+        bool read_at(std::FILE* f, uint64_t offset, void* data, size_t n) {
+            return std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0 && std::fread(data, 1, n, f) == n;
+        }
+
+    } // namespace
+
+    bool Sim_core::save_checkpoint(const std::string& path) {
+        SimContext::Binding bind(ctx);
+#ifndef ADAPTSIM_VERILATOR_SAVABLE
+        std::cerr << "Checkpoint: the Verilator model was not built with --savable" << std::endl;
+        (void)path;
+        return false;
+#else
+        // 检查点只记录已对比一致的 REF 状态
+        if (diff_pipe) {
+            if (!diff_pipe->finish()) {
+                return false;
+            }
+            attach_difftest(difftest);
+        } else if (difftest && !difftest->flush()) {
+            return false;
+        }
+
+        const CheckpointMeta meta{cycle_cnt, inst_cnt, vctx->time(),
+                                  static_cast<int32_t>(cpu.state), cpu.halt_ret, ff_inst_cnt};
+
+        std::vector<uint32_t> page_addrs;
+        std::vector<const uint8_t*> page_data;
+        memory::get_memory().for_each_page([&](uint32_t addr, const uint8_t* data) {
+            page_addrs.push_back(addr);
+            page_data.push_back(data);
+        });
+
+        std::vector<uint8_t> model;
+        {
+            BlobSave os(model);
+            os << *vctx;
+            os << *Top;
+        }
+
+        CheckpointRef ref{};
+        const bool has_ref = difftest && difftest->is_good();
+        if (has_ref) {
+            const utils::diff_context_t state = difftest->get_ref_state();
+            std::memcpy(ref.gpr, state.gpr, sizeof(ref.gpr));
+            ref.pc = state.pc;
+            ref.commit_cnt = difftest->get_commit_count();
+        }
+
+        std::vector<CheckpointSection> sections;
+        uint64_t off = sizeof(CheckpointHeader) + (has_ref ? 5 : 4) * sizeof(CheckpointSection);
+        auto add = [&](CheckpointSectionKind kind, uint64_t size, uint64_t align = 8) {
+            off = align_up(off, align);
+            sections.push_back({static_cast<uint32_t>(kind), 0, off, size});
+            off += size;
+        };
+        add(CheckpointSectionKind::Meta, sizeof(meta));
+        add(CheckpointSectionKind::PageIndex, page_addrs.size() * sizeof(uint32_t));
+        add(CheckpointSectionKind::Model, model.size());
+        if (has_ref) {
+            add(CheckpointSectionKind::Ref, sizeof(ref));
+        }
+        add(CheckpointSectionKind::PageData, page_addrs.size() * CKPT_PAGE_SIZE, CKPT_PAGE_SIZE);
+
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) {
+            std::cerr << "Checkpoint: cannot write " << path << std::endl;
+            return false;
+        }
+        CheckpointHeader header{};
+        std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.version = CHECKPOINT_VERSION;
+        header.n_sections = static_cast<uint32_t>(sections.size());
+        bool ok = write_at(f, 0, &header, sizeof(header)) &&
+                  write_at(f, sizeof(header), sections.data(), sections.size() * sizeof(CheckpointSection));
+        for (const CheckpointSection& sec : sections) {
+            switch (static_cast<CheckpointSectionKind>(sec.kind)) {
+                case CheckpointSectionKind::Meta: ok = ok && write_at(f, sec.offset, &meta, sizeof(meta)); break;
+                case CheckpointSectionKind::PageIndex:
+                    ok = ok && write_at(f, sec.offset, page_addrs.data(), sec.size);
+                    break;
+                case CheckpointSectionKind::Model: ok = ok && write_at(f, sec.offset, model.data(), sec.size); break;
+                case CheckpointSectionKind::Ref: ok = ok && write_at(f, sec.offset, &ref, sizeof(ref)); break;
+                case CheckpointSectionKind::PageData:
+                    ok = ok && std::fseek(f, static_cast<long>(sec.offset), SEEK_SET) == 0;
+                    for (size_t i = 0; ok && i < page_data.size(); i++) {
+                        ok = std::fwrite(page_data[i], 1, CKPT_PAGE_SIZE, f) == CKPT_PAGE_SIZE;
+                    }
+                    break;
+            }
+        }
+        ok = std::fclose(f) == 0 && ok;
+        if (!ok) {
+            std::cerr << "Checkpoint: failed writing " << path << std::endl;
+            return false;
+        }
+        std::cout << "Checkpoint saved to " << path << " (" << page_addrs.size() << " pages, cycle "
+                  << cycle_cnt << ", inst " << inst_cnt << ")" << std::endl;
+        return true;
+#endif
+    }
+
+    bool Sim_core::restore_checkpoint(const std::string& path) {
+        SimContext::Binding bind(ctx);
+#ifndef ADAPTSIM_VERILATOR_SAVABLE
+        std::cerr << "Checkpoint: the Verilator model was not built with --savable" << std::endl;
+        (void)path;
+        return false;
+#else
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) {
+            std::cerr << "Checkpoint: cannot open " << path << std::endl;
+            return false;
+        }
+        CheckpointHeader header{};
+        std::vector<CheckpointSection> sections;
+        bool ok = read_at(f, 0, &header, sizeof(header)) &&
+                  std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+                  header.version == CHECKPOINT_VERSION;
+        if (ok) {
+            sections.resize(header.n_sections);
+            ok = read_at(f, sizeof(header), sections.data(), sections.size() * sizeof(CheckpointSection));
+        }
+
+        CheckpointMeta meta{};
+        CheckpointRef ref{};
+        bool has_meta = false;
+        bool has_ref = false;
+        bool has_model = false;
+        std::vector<uint32_t> page_addrs;
+        std::vector<uint8_t> model;
+        uint64_t page_data_off = 0;
+        uint64_t page_data_size = 0;
+        for (const CheckpointSection& sec : sections) {
+            if (!ok) {
+                break;
+            }
+            switch (static_cast<CheckpointSectionKind>(sec.kind)) {
+                case CheckpointSectionKind::Meta:
+                    ok = sec.size >= offsetof(CheckpointMeta, ff_inst_cnt) && sec.size <= sizeof(meta) &&
+                         read_at(f, sec.offset, &meta, sec.size);
+                    has_meta = true;
+                    break;
+                case CheckpointSectionKind::PageIndex:
+                    page_addrs.resize(sec.size / sizeof(uint32_t));
+                    ok = read_at(f, sec.offset, page_addrs.data(), sec.size);
+                    break;
+                case CheckpointSectionKind::PageData:
+                    page_data_off = sec.offset;
+                    page_data_size = sec.size;
+                    break;
+                case CheckpointSectionKind::Model:
+                    model.resize(sec.size);
+                    ok = read_at(f, sec.offset, model.data(), sec.size);
+                    has_model = true;
+                    break;
+                case CheckpointSectionKind::Ref:
+                    ok = sec.size == sizeof(ref) && read_at(f, sec.offset, &ref, sizeof(ref));
+                    has_ref = true;
+                    break;
+                default:
+                    break; // 未知段：留给更新的版本，忽略
+            }
+        }
+        std::fclose(f);
+        if (!ok || !has_meta || !has_model || page_data_size != page_addrs.size() * CKPT_PAGE_SIZE) {
+            std::cerr << "Checkpoint: " << path << " is not a valid checkpoint" << std::endl;
+            return false;
+        }
+
+        // 先排空流水化的差分测试：后台线程仍在推进 REF，且尚未对比的指令可能已经失配
+        const bool sync_ref = difftest && difftest->is_good() && has_ref;
+        if (diff_pipe) {
+            if (!diff_pipe->finish()) {
+                return false;
+            }
+            attach_difftest(difftest);
+        }
+
+        // REF 内存与当前 DUT 内存一致，记下现有页，恢复后清零检查点中没有的那些
+        memory::VMem& mem = memory::get_memory();
+        std::vector<uint32_t> stale_pages;
+        if (sync_ref) {
+            mem.for_each_page([&](uint32_t addr, const uint8_t*) { stale_pages.push_back(addr); });
+        }
+
+        // 内存：整页以写时复制方式映射，恢复时间与检查点大小基本无关。
+        // 先映射到临时实例，映射失败时当前内存保持原样
+        {
+            memory::VMem restored;
+            if (!page_addrs.empty() &&
+                !restored.map_file_pages(path, page_addrs.data(), page_addrs.size(), page_data_off)) {
+                return false;
+            }
+            mem.take_pages(restored);
+        }
+
+        {
+            BlobRestore is(model);
+            is >> *vctx;
+            is >> *Top;
+        }
+        cycle_cnt = meta.cycle_cnt;
+        inst_cnt = meta.inst_cnt;
+        ff_inst_cnt = meta.ff_inst_cnt;
+        vctx->time(meta.sim_time);
+        cpu.state = static_cast<CPU_STATES>(meta.cpu_state);
+        cpu.halt_ret = meta.halt_ret;
+        gpr_dirty = gpr_dirty_prev = ~0u;
+        if (itrace) {
+            uint32_t gpr[32] = {};
+            gpr_group.snapshot(gpr + 1);
+            itrace->sync(gpr);
+        }
+
+        if (difftest && difftest->is_good()) {
+            if (!has_ref) {
+                std::cerr << "Checkpoint: no REF state saved, difftest will start from the REF's current state" << std::endl;
+            } else {
+                // REF 内存在保存时与 DUT 一致：逐页同步 DUT 内存，检查点之后才出现的页在 REF 中清零
+                mem.for_each_page([&](uint32_t addr, const uint8_t* data) {
+                    difftest->memcpy(addr, const_cast<uint8_t*>(data), CKPT_PAGE_SIZE, DIFFTEST_TO_REF);
+                });
+                std::sort(page_addrs.begin(), page_addrs.end());
+                std::vector<uint8_t> zero_page(CKPT_PAGE_SIZE, 0);
+                for (uint32_t addr : stale_pages) {
+                    if (!std::binary_search(page_addrs.begin(), page_addrs.end(), addr)) {
+                        difftest->memcpy(addr, zero_page.data(), CKPT_PAGE_SIZE, DIFFTEST_TO_REF);
+                    }
+                }
+                utils::diff_context_t state{};
+                std::memcpy(state.gpr, ref.gpr, sizeof(state.gpr));
+                state.pc = ref.pc;
+                difftest->restore_ref(state, ref.commit_cnt);
+            }
+        }
+        std::cout << "Checkpoint restored from " << path << " (" << page_addrs.size() << " pages, cycle "
+                  << cycle_cnt << ", inst " << inst_cnt << ")" << std::endl;
+        return true;
+#endif
+    }
+
+} // namespace multiple
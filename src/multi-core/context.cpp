@@ -0,0 +1,96 @@
+// src/multi-core/context.cpp
+
+#include "AdaptSim/multicore/context.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "verilated.h"
+#include "verilated_syms.h"
+
+namespace multiple {
+
+    static thread_local SimContext* current_ctx = nullptr;
+
+    static std::mutex model_mutex;
+    static std::unordered_map<const VerilatedContext*, SimContext*> model_ctx;
+    static std::atomic<uint64_t> model_generation{0}; // 每次登记/注销加一，使各线程缓存的查找失败结果失效
+
+    // 未绑定的线程在 DPI 回调里首次访问内存时调用。Verilator 的工作线程池属于单个
+    // VerilatedContext，因此找到后把该线程永久绑定到这个上下文，之后的回调不再查表
+    static bool bind_dpi_thread() {
+        if (!Verilated::dpiInContext()) {
+            return false;
+        }
+        const VerilatedContext* vctx = Verilated::dpiScope()->symsp()->_vm_contextp__;
+        // 未登记的模型（不带上下文的 Sim_core）每次回调都会走到这里，记住上次的失败以免反复加锁
+        thread_local const VerilatedContext* unbound_vctx = nullptr;
+        thread_local uint64_t unbound_generation = 0;
+        const uint64_t generation = model_generation.load(std::memory_order_acquire);
+        if (vctx == unbound_vctx && generation == unbound_generation) {
+            return false;
+        }
+        SimContext* ctx = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(model_mutex);
+            const auto it = model_ctx.find(vctx);
+            if (it != model_ctx.end()) {
+                ctx = it->second;
+            }
+        }
+        if (!ctx) {
+            unbound_vctx = vctx;
+            unbound_generation = generation;
+            return false;
+        }
+        current_ctx = ctx;
+        memory::bind_memory(&ctx->mem);
+        utils::bind_mem_trace(&ctx->mem_trace);
+        return true;
+    }
+
+    SimContext::SimContext(const cfg& config) : config(config) {}
+
+    utils::Difftest* SimContext::create_difftest(long img_size) {
+        Binding bind(this);
+        difftest = std::make_unique<utils::Difftest>(
+            config.diff_ref_path.empty() ? nullptr : config.diff_ref_path.c_str(), img_size);
+        return difftest.get();
+    }
+
+    SimContext* SimContext::current() {
+        return current_ctx;
+    }
+
+    void SimContext::register_model(const VerilatedContext* vctx, SimContext* ctx) {
+        std::lock_guard<std::mutex> lock(model_mutex);
+        if (ctx) {
+            model_ctx[vctx] = ctx;
+            memory::detail::bind_unbound_thread = bind_dpi_thread;
+        } else {
+            model_ctx.erase(vctx);
+        }
+        model_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    SimContext::Binding::Binding(SimContext* ctx) : ctx(ctx) {
+        if (!ctx) {
+            return;
+        }
+        prev_ctx = current_ctx;
+        current_ctx = ctx;
+        prev_mem = memory::bind_memory(&ctx->mem);
+        prev_trace = utils::bind_mem_trace(&ctx->mem_trace);
+    }
+
+    SimContext::Binding::~Binding() {
+        if (!ctx) {
+            return;
+        }
+        utils::bind_mem_trace(prev_trace);
+        memory::bind_memory(prev_mem);
+        current_ctx = prev_ctx;
+    }
+
+} // namespace multiple
@@ -5,44 +5,190 @@
 
 #include "AdaptSim/multicore/core.h"
 #include "AdaptSim/multicore/cfg.h"
+#include "AdaptSim/multicore/state.h"
+#include "AdaptSim/multicore/context.h"
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <utility>
 #include <memory>
+#include <stdexcept>
 
 #include "Vcore.h"
 #include "Vcore___024root.h"
 #include "verilated.h"
+#include "verilated_syms.h"
 #include "verilated_vcd_c.h"
+#ifdef ADAPTSIM_WAVE_FST
+#include "verilated_fst_c.h"
+#endif
 #include "utils/difftest.h"
-#include "Vcore___024root.h" // 包含Verilator生成的内部头文件
+#include "utils/memtrace.h"
+#include "utils/selfprof.h"
+#include <string>
+#include <vector>
 
 namespace multiple {
 
-    // 使用在 cfg.h 中声明并在 cfg.cpp 中定义的全局配置实例
-    extern cfg cfg_inst;
+    static constexpr uint32_t EBREAK_INST = 0x00100073;
 
-    Sim_core::Sim_core() {
-        Verilated::traceEverOn(true);
-        Top = std::make_unique<Vcore>();
+    // FST 模型写出的波形把 .vcd 后缀换成 .fst
+    static std::string wave_output(const std::string& path) {
+#ifdef ADAPTSIM_WAVE_FST
+        if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".vcd") == 0) {
+            return path.substr(0, path.size() - 4) + ".fst";
+        }
+#endif
+        return path;
+    }
+
+    const char* run_exit_name(RunExit reason) {
+        switch (reason) {
+            case RunExit::Halt: return "halt";
+            case RunExit::Mismatch: return "mismatch";
+            case RunExit::Hang: return "hang";
+            case RunExit::MaxInsts: return "max_insts";
+            case RunExit::MaxCycles: return "max_cycles";
+            case RunExit::Breakpoint: return "breakpoint";
+            case RunExit::Stopped: return "stopped";
+        }
+        return "unknown";
+    }
+
+    Sim_core::Sim_core() : Sim_core(nullptr) {}
 
+    Sim_core::Sim_core(SimContext& ctx) : Sim_core(&ctx) {}
 
+    Sim_core::Sim_core(SimContext* ctx)
+        : ctx(ctx),
+          conf(ctx ? ctx->config : cfg_inst),
+          cpu(ctx ? ctx->cpu_state : cpu_state) {
+        vctx = std::make_unique<VerilatedContext>();
+        vctx->traceEverOn(true);
+#ifdef ADAPTSIM_PGO_PROFILE
+        // 以 --prof-pgo 生成的模型在析构时把线程调度 profile 写到这里，供 ADAPTSIM_PGO=USE 的构建使用
+        vctx->profVltFilename(ADAPTSIM_PGO_PROFILE);
+#endif
+        Top = std::make_unique<Vcore>(vctx.get());
+        if (ctx) {
+            // 多线程模型的 DPI 回调只能经由 DPI scope 找回上下文，要求 RTL 以 context 方式导入 mem_read/mem_write
+            if (vctx->threads() > 1 && vctx->scopeNameMap()->empty()) {
+                throw std::runtime_error("multi-threaded model has no DPI scopes; declare mem_read/mem_write as "
+                                         "'import \"DPI-C\" context' or build with ADAPTSIM_VERILATOR_THREADS=1");
+            }
+            SimContext::register_model(vctx.get(), ctx);
+        }
 
+        signals = std::make_unique<SignalRegistry>(Top->rootp);
+        std::vector<std::string> rf_names;
+        for (int i = 1; i < 32; i++) {
+            rf_names.push_back("core__DOT__RF__DOT__rf_" + std::to_string(i));
+        }
+        gpr_group = signals->group(rf_names);
+        if (!gpr_group.complete()) {
+            std::cerr << "Signal registry: register file signals not found, GPRs will read as zero" << std::endl;
+        }
+        // RF 写端口可能被 Verilator 内联掉，依次尝试等价的信号
+        static const char* const WB_PORTS[][2] = {
+            {"core__DOT__RF__DOT__io_w2r_en", "core__DOT__RF__DOT__io_w2r_addr"},
+            {"io_inst_done", "core__DOT__dataReg_5_rd_addr"},
+        };
+        for (const auto& port : WB_PORTS) {
+            wb_en = signals->find(port[0]);
+            wb_addr = signals->find(port[1]);
+            if (wb_en && wb_addr) {
+                break;
+            }
+        }
+        if (!wb_en || !wb_addr) {
+            wb_en = wb_addr = SignalRef{};
+        }
+        debug_out = signals->find("io_debugout1");
+        debug_mem_addr = signals->find("io_debugmemaddr");
+        debug_mem_data = signals->find("io_debugmemdata");
     }
 
     Sim_core::~Sim_core() {
+        SimContext::Binding bind(ctx);
+        // 差分测试失配或异常终止时留下最后一段波形和访存记录
+        if (!finish_difftest() || cpu.state == CPU_STATES::CPU_ABORT) {
+            if (!wave_dumped) {
+                dump_wave();
+            }
+            dump_mem_trace();
+        }
+        if (perf) {
+            dump_perf();
+        }
+        if (profiler) {
+            dump_profile();
+        }
         // unique_ptr 会自动管理内存，但我们需要确保波形文件被正确关闭
-        if (tfp) {
+        if (tfp && tfp->isOpen()) {
             tfp->close();
         }
+        if (wave_sink && wave_sink->stall_count()) {
+            std::cout << "Async wave writer stalled the simulation " << wave_sink->stall_count()
+                      << " time(s); consider a larger wave_async_buffer_kb" << std::endl;
+        }
+        utils::get_mem_trace().close();
+        if (itrace) {
+            itrace->close();
+        }
+        if (ctx) {
+            SimContext::register_model(vctx.get(), nullptr);
+        }
     }
 
     void Sim_core::sim_init()
     {
+        SimContext::Binding bind(ctx);
         // 根据全局配置初始化仿真环境，例如开启波形追踪
-        if (cfg_inst.trace_enabled) {
-            tfp = std::make_unique<VerilatedVcdC>();
-            Top->trace(tfp.get(), 99);
-            tfp->open(cfg_inst.wave_file.c_str());
-            std::cout << "Wave trace enabled, output file: " << cfg_inst.wave_file << std::endl;
+        if (conf.trace_enabled && conf.wave_flight) {
+#ifdef ADAPTSIM_WAVE_FST
+            // 飞行记录器基于分段的 VCD 环形文件，无法挂接到 FST 模型
+            std::cerr << "Wave flight recorder needs a VCD-traced model, wave tracing disabled" << std::endl;
+#else
+            wave_rec = std::make_unique<utils::WaveRecorder>(conf.wave_flight_cycles);
+            Top->trace(wave_rec->vcd(), 99);
+            wave_rec->open();
+            std::cout << "Wave flight recorder enabled, keeping the last " << wave_rec->window()
+                      << " cycles for " << conf.wave_file << std::endl;
+#endif
+        } else if (conf.trace_enabled && !conf.wave_windows.empty()) {
+            std::vector<utils::WaveWindow> windows;
+            for (const std::string& spec : conf.wave_windows) {
+                utils::WaveWindow w{};
+                if (utils::parse_wave_window(spec, w)) {
+                    windows.push_back(w);
+                } else {
+                    std::cerr << "Ignoring invalid wave window: " << spec << std::endl;
+                }
+            }
+            wave_trig = std::make_unique<utils::WaveTrigger>(std::move(windows), conf.wave_window_max_files);
+            wave_next_cycle = wave_trig->next_cycle_event();
+            std::cout << "Triggered wave trace enabled, " << conf.wave_windows.size() << " window(s)" << std::endl;
+        } else if (conf.trace_enabled) {
+            attach_wave();
+            const std::string path = wave_output(conf.wave_file);
+            tfp->open(path.c_str());
+            std::cout << "Wave trace enabled, output file: " << path
+                      << (wave_sink ? " (async writer)" : "") << std::endl;
+        }
+        if (conf.inst_trace_enabled) {
+            itrace = std::make_unique<utils::InstTraceWriter>();
+            if (!itrace->open(conf.inst_trace_file, utils::parse_inst_trace_codec(conf.inst_trace_codec))) {
+                itrace.reset();
+            }
+        }
+        if (conf.mem_trace_enabled) {
+            utils::MemTrace& mem_trace = utils::get_mem_trace();
+            mem_trace.set_cycle_source(&cycle_cnt);
+            if (conf.mem_trace_file.empty()) {
+                mem_trace.start();
+            } else {
+                mem_trace.open(conf.mem_trace_file);
+            }
         }
         // 执行复位序列
         Top->clock = 0;
@@ -51,7 +197,44 @@ namespace multiple {
             toggle_clock();
         }
         Top->reset = 0;
+        // 复位之后才开始统计
+        if (conf.perf_enabled) {
+            perf = std::make_unique<PerfCounters>(*signals);
+        }
+        if (conf.prof_enabled) {
+            profiler = std::make_unique<utils::Profiler>(
+                utils::Profiler::Options{conf.prof_sample_cycles, conf.prof_bbv_interval, conf.prof_output});
+        }
+        gpr_dirty = gpr_dirty_prev = ~0u;
+        cpu.state = CPU_STATES::CPU_RUNNING;
+        cpu.halt_ret = 0;
+    }
+
+    void Sim_core::attach_difftest(utils::Difftest* dt) {
+        SimContext::Binding bind(ctx);
+        finish_difftest();
+        diff_pipe.reset();
+        difftest = dt;
+        if (!difftest) {
+            return;
+        }
+        difftest->set_ref_memory(conf.ff_mem_base, conf.ff_mem_size);
+        difftest->set_batch(conf.diff_batch, conf.diff_batch_adaptive);
+        if (conf.diff_async) {
+            diff_pipe = std::make_unique<utils::DifftestPipeline>(*difftest);
+            diff_pipe->set_cycle_source(&cycle_cnt);
+            diff_pipe->start();
+        } else {
+            difftest->set_cycle_source(&cycle_cnt);
+            difftest->observe_dut_stores();
+        }
+    }
 
+    bool Sim_core::finish_difftest() {
+        if (diff_pipe) {
+            return diff_pipe->finish();
+        }
+        return difftest ? difftest->flush() : true;
     }
 
     CoreDebugInfo Sim_core::get_debug_info() const {
@@ -60,86 +243,349 @@ namespace multiple {
         info.inst = Top->io_debugInst;
         info.in1 = Top->io_debugin1;
         info.in2 = Top->io_debugin2;
-        // info.out = Top->io_debugout1;
-        // info.mem_addr = Top->io_debugmemaddr;
-        // info.mem_data = Top->io_debugmemdata;
-        // 如果 Verilog 模块提供了 GPR 的调试接口，可以取消下面的注释
-        // for (int i = 0; i < 32; ++i) {
-        //     info.gpr[i] = Top->io_debugGPR[i];
-        // }
+        // 这些端口不一定存在于每一版 RTL 中，经注册表按名称取
+        info.out = debug_out ? static_cast<uint32_t>(debug_out.value()) : 0;
+        info.mem_addr = debug_mem_addr ? static_cast<uint32_t>(debug_mem_addr.value()) : 0;
+        info.mem_data = debug_mem_data ? static_cast<uint32_t>(debug_mem_data.value()) : 0;
+        gpr_group.snapshot(info.gpr + 1);
+        info.inst_cnt = inst_cnt;
+        info.cycle_cnt = cycle_cnt;
         return info;
     }
 
-    void Sim_core::toggle_clock() {
+    bool Sim_core::dump_wave(const std::string& path) {
+        if (!wave_rec) {
+            return false;
+        }
+        wave_dumped = wave_rec->save(path.empty() ? conf.wave_file : path);
+        return wave_dumped;
+    }
+
+    bool Sim_core::dump_mem_trace(const std::string& path) const {
+        // 落盘方式下记录已经在文件里了
+        if (!conf.mem_trace_enabled || !conf.mem_trace_file.empty()) {
+            return false;
+        }
+        const std::string& out = path.empty() ? conf.mem_trace_dump_file : path;
+        if (out.empty() || !utils::get_mem_trace().dump(out)) {
+            return false;
+        }
+        std::cout << "Memory trace flight recorder dumped to " << out << " (decode with memtrace_decode)" << std::endl;
+        return true;
+    }
+
+    bool Sim_core::dump_perf(const std::string& path) const {
+        if (!perf) {
+            return false;
+        }
+        return perf->write_json(path.empty() ? conf.perf_file : path, inst_cnt);
+    }
+
+    bool Sim_core::dump_profile() {
+        if (!profiler) {
+            return false;
+        }
+        utils::SymbolTable syms;
+        if (!conf.img_path.empty() && !syms.load_elf(conf.img_path)) {
+            std::cerr << "Profiler: no ELF symbols in " << conf.img_path << ", reporting raw addresses" << std::endl;
+        }
+        return profiler->write(syms);
+    }
+
+    void Sim_core::attach_wave() {
+#ifdef ADAPTSIM_WAVE_FST
+        // 编码与压缩已经在 Verilator 的追踪线程上完成，wave_async 的写线程没有必要
+        tfp = std::make_unique<VerilatedFstC>();
+#else
+        if (conf.wave_async) {
+            utils::WaveCompression comp = utils::WaveCompression::None;
+            if (!utils::parse_wave_compression(conf.wave_compress, comp)) {
+                std::cerr << "Unsupported wave compression '" << conf.wave_compress << "', writing plain VCD" << std::endl;
+            }
+            wave_sink = std::make_unique<utils::AsyncWaveSink>(size_t(conf.wave_async_buffer_kb) << 10, comp);
+            tfp = std::make_unique<VerilatedVcdC>(wave_sink->file());
+        } else {
+            tfp = std::make_unique<VerilatedVcdC>();
+        }
+#endif
+        Top->trace(tfp.get(), 99);
+    }
+
+    void Sim_core::poll_wave_windows(bool at_commit) {
+        const utils::WaveTriggerEvent ev = wave_trig->poll(Top->io_debugPC, inst_cnt, cycle_cnt, at_commit);
+        if (ev.close) {
+            tfp->close();
+        }
+        if (ev.open >= 0) {
+            if (!tfp) {
+                // 第一次触发时才挂接波形，之前模型不承担追踪开销
+                attach_wave();
+            }
+            std::string name = wave_output(conf.wave_file);
+            const size_t dot = name.rfind('.');
+            name.insert(dot == std::string::npos ? name.size() : dot, "_w" + std::to_string(wave_files++));
+            tfp->open(name.c_str());
+            std::cout << "Wave window " << ev.open << " opened at cycle " << cycle_cnt
+                      << ", inst " << inst_cnt << ": " << name << std::endl;
+        }
+        wave_next_cycle = wave_trig->next_cycle_event();
+    }
+
+    unsigned Sim_core::loop_features(bool bounded) const {
+        if (!conf.specialize_loop) {
+            return loop_feature::ALL;
+        }
+        unsigned f = 0;
+        if (tfp || wave_rec || wave_trig) {
+            f |= loop_feature::WAVE;
+        }
+        if (itrace) {
+            f |= loop_feature::ITRACE;
+        }
+        if (difftest) {
+            f |= loop_feature::DIFFTEST;
+        }
+        if (bounded) {
+            f |= loop_feature::WATCHDOG;
+        }
+        if (perf) {
+            f |= loop_feature::PERF;
+        }
+        if (profiler) {
+            f |= loop_feature::PROFILE;
+        }
+        return f;
+    }
+
+    template <unsigned F>
+    void Sim_core::toggle_clock_t() {
         Top->clock = !Top->clock;
-        Top->eval();
-        if (tfp) {
-            // 使用 Verilated 的全局时间戳来记录波形
-            tfp->dump(Verilated::time());
+        cycle_cnt += Top->clock;
+        {
+            SELFPROF_SCOPE(Eval);
+            Top->eval();
+        }
+        if constexpr (F & loop_feature::PERF) {
+            if (perf && Top->clock) {
+                perf->sample(cycle_cnt, inst_cnt);
+            }
+        }
+        if constexpr (F & loop_feature::WAVE) {
+            if (cycle_cnt >= wave_next_cycle) [[unlikely]] {
+                poll_wave_windows(false);
+            }
+            if (tfp && tfp->isOpen()) {
+                SELFPROF_SCOPE(Wave);
+                // 使用 Verilated 的全局时间戳来记录波形
+                tfp->dump(vctx->time());
+            } else if (wave_rec) {
+                SELFPROF_SCOPE(Wave);
+                wave_rec->dump(vctx->time(), cycle_cnt);
+            }
         }
-        Verilated::timeInc(1); // 增加仿真时间
+        vctx->timeInc(1); // 增加仿真时间
+    }
+
+    void Sim_core::toggle_clock() {
+        toggle_clock_t<loop_feature::ALL>();
     }
 
-    void Sim_core::run_inst_once() {
+    template <unsigned F>
+    bool Sim_core::clock_until_commit(uint64_t deadline) {
         // 持续翻转时钟直到指令完成信号 `io_inst_done` 为高
         do {
-            toggle_clock();
+            toggle_clock_t<F>();
+            if constexpr (F & loop_feature::WATCHDOG) {
+                if (cycle_cnt >= deadline) [[unlikely]] {
+                    break;
+                }
+            }
         } while (!Top->io_inst_done);
+        return Top->io_inst_done;
+    }
+
+    bool Sim_core::run_inst_once() {
+        SimContext::Binding bind(ctx);
+        if (conf.hang_cycles == 0) {
+            return clock_until_commit<loop_feature::ALL & ~loop_feature::WATCHDOG>(UINT64_MAX);
+        }
+        return clock_until_commit<loop_feature::ALL>(cycle_cnt + conf.hang_cycles);
+    }
+
+    void Sim_core::note_writeback() {
+        if (!wb_en) {
+            gpr_dirty = ~0u;
+        } else if (wb_en.value()) {
+            gpr_dirty |= 1u << (wb_addr.value() & 31);
+        }
+    }
+
+    template <unsigned F>
+    bool Sim_core::on_commit() {
+        inst_cnt++;
+        if constexpr ((F & (loop_feature::ITRACE | loop_feature::DIFFTEST)) != 0) {
+            note_writeback();
+        }
+        if constexpr (F & loop_feature::WAVE) {
+            if (wave_trig) {
+                poll_wave_windows(true);
+            }
+        }
+        if constexpr (F & loop_feature::PROFILE) {
+            if (profiler) {
+                profiler->commit(Top->io_debugPC, Top->io_debugInst, cycle_cnt);
+            }
+        }
+        if constexpr ((F & (loop_feature::ITRACE | loop_feature::DIFFTEST)) != 0) {
+            if (itrace || difftest) {
+                const utils::diff_context_t dut = get_diff_info();
+                if constexpr (F & loop_feature::ITRACE) {
+                    if (itrace) {
+                        SELFPROF_SCOPE(ITrace);
+                        // 只追加二进制记录，反汇编留给离线的 itrace_view
+                        itrace->commit(dut.pc, Top->io_debugInst, dut.gpr);
+                    }
+                }
+                if constexpr (F & loop_feature::DIFFTEST) {
+                    const bool ok = diff_pipe ? diff_pipe->commit(cycle_cnt, dut, Top->io_debugInst)
+                                              : !difftest || difftest->commit(dut);
+                    if (!ok) {
+                        cpu.state = CPU_STATES::CPU_ABORT;
+                        dump_wave();
+                        return false;
+                    }
+                }
+            }
+        }
+        // 与 NEMU 约定一致：ebreak 结束程序，a0 为返回值
+        if (Top->io_debugInst == EBREAK_INST) [[unlikely]] {
+            cpu.state = CPU_STATES::CPU_END;
+            cpu.halt_ret = gpr_group[9] ? static_cast<int>(gpr_group[9].value()) : 0;
+            return false;
+        }
+        return true;
     }
 
     int Sim_core::run_inst(int num_inst) {
-        int i = 0;
-        for (; i < num_inst; i++) {
-            run_inst_once();
+        if (num_inst <= 0) {
+            return 0;
         }
-        return i; // 返回实际执行的指令数
+        StopConditions stop;
+        stop.max_insts = static_cast<uint64_t>(num_inst);
+        const RunResult r = run(stop);
+        if (r.reason == RunExit::MaxInsts) {
+            cpu.state = CPU_STATES::CPU_RUNNING; // 逐段推进时保持运行态
+        }
+        return static_cast<int>(r.insts); // 返回实际执行的指令数
     }
+
+    RunResult Sim_core::run(const StopConditions& stop) {
+        using RunLoop = RunResult (Sim_core::*)(const StopConditions&);
+        // 每种特性组合一个实例，运行开始时按当前配置挑选一次
+        static constexpr auto LOOPS = []<unsigned... I>(std::integer_sequence<unsigned, I...>) {
+            return std::array<RunLoop, sizeof...(I)>{&Sim_core::run_loop<I>...};
+        }(std::make_integer_sequence<unsigned, loop_feature::ALL + 1>{});
+
+        SimContext::Binding bind(ctx);
+        const uint64_t hang = stop.hang_cycles ? stop.hang_cycles : conf.hang_cycles;
+        return (this->*LOOPS[loop_features(hang != 0 || stop.max_cycles != 0)])(stop);
+    }
+
+    template <unsigned F>
+    RunResult Sim_core::run_loop(const StopConditions& stop) {
+        const uint64_t inst_begin = inst_cnt;
+        const uint64_t cycle_begin = cycle_cnt;
+        auto result = [&](RunExit reason) {
+            if constexpr ((F & (loop_feature::ITRACE | loop_feature::DIFFTEST)) == 0) {
+                gpr_dirty = ~0u; // 未跟踪写端口，下次全部重新读取
+            }
+            return RunResult{reason, inst_cnt - inst_begin, cycle_cnt - cycle_begin, Top->io_debugPC};
+        };
+        switch (cpu.state) {
+            case CPU_STATES::CPU_END: return result(RunExit::Halt);
+            case CPU_STATES::CPU_ABORT: return result(RunExit::Mismatch);
+            default: break;
+        }
+        cpu.state = CPU_STATES::CPU_RUNNING;
+
+        const uint64_t hang_cfg = stop.hang_cycles ? stop.hang_cycles : conf.hang_cycles;
+        const uint64_t hang = hang_cfg ? hang_cfg : UINT64_MAX;
+        const uint64_t inst_end = stop.max_insts ? inst_begin + stop.max_insts : UINT64_MAX;
+        const uint64_t cycle_end = stop.max_cycles ? cycle_begin + stop.max_cycles : UINT64_MAX;
+        // 断点通常只有几个，排序后二分查找；没有断点时只多一次分支
+        std::vector<uint32_t> bps = stop.breakpoints;
+        std::sort(bps.begin(), bps.end());
+#ifdef ADAPTSIM_SELF_PROFILE
+        utils::selfprof::Progress progress(inst_cnt, cycle_cnt, stop.max_insts, conf.selfprof_progress_ms);
+#endif
+
+        while (true) {
+            if (inst_cnt >= inst_end) {
+                cpu.state = CPU_STATES::CPU_STOP;
+                return result(RunExit::MaxInsts);
+            }
+            if (stop.stop && stop.stop->load(std::memory_order_relaxed)) [[unlikely]] {
+                cpu.state = CPU_STATES::CPU_STOP;
+                return result(RunExit::Stopped);
+            }
+            if constexpr (F & loop_feature::WATCHDOG) {
+                if (cycle_cnt >= cycle_end) {
+                    cpu.state = CPU_STATES::CPU_STOP;
+                    return result(RunExit::MaxCycles);
+                }
+            }
+            // 周期上限与看门狗共用一个截止周期，取先到者
+            if (!clock_until_commit<F>(cycle_cnt + std::min(hang, cycle_end - cycle_cnt))) [[unlikely]] {
+                if (cycle_cnt >= cycle_end) {
+                    cpu.state = CPU_STATES::CPU_STOP;
+                    return result(RunExit::MaxCycles);
+                }
+                std::cerr << "No instruction committed for " << hang << " cycles at pc 0x" << std::hex
+                          << Top->io_debugPC << std::dec << ", core is hung" << std::endl;
+                cpu.state = CPU_STATES::CPU_ABORT;
+                dump_wave();
+                return result(RunExit::Hang);
+            }
+#ifdef ADAPTSIM_SELF_PROFILE
+            progress.tick(inst_cnt + 1, cycle_cnt);
+#endif
+            if (!on_commit<F>()) {
+                return result(cpu.state == CPU_STATES::CPU_END ? RunExit::Halt : RunExit::Mismatch);
+            }
+            if (!bps.empty() && std::binary_search(bps.begin(), bps.end(), Top->io_debugPC)) [[unlikely]] {
+                cpu.state = CPU_STATES::CPU_STOP;
+                return result(RunExit::Breakpoint);
+            }
+        }
+    }
+
     int Sim_core::run_cycle(int num_cycle) {
+        SimContext::Binding bind(ctx);
         int i = 0;
         for (; i < num_cycle; i++) {
             toggle_clock();
         }
+        // 逐周期推进时不跟踪写端口，下次全部重新读取
+        gpr_dirty = ~0u;
         return i; // 返回实际执行的周期数
     }
-    utils::diff_context_t Sim_core::get_diff_info() { // 建议设为 const 函数
+    utils::diff_context_t Sim_core::get_diff_info() {
         utils::diff_context_t context{};
         context.pc = Top->io_debugPC;
 
-        // 从Verilator内部信号逐一读取GPRs
-        // 注意：x0/rf_0 物理上可能不存在，但为保持接口一致性，通常会赋值为0
-        context.gpr[0]  = 0; // RISC-V x0 is always zero
-        context.gpr[1]  = Top->rootp->core__DOT__RF__DOT__rf_1;
-        context.gpr[2]  = Top->rootp->core__DOT__RF__DOT__rf_2;
-        context.gpr[3]  = Top->rootp->core__DOT__RF__DOT__rf_3;
-        context.gpr[4]  = Top->rootp->core__DOT__RF__DOT__rf_4;
-        context.gpr[5]  = Top->rootp->core__DOT__RF__DOT__rf_5;
-        context.gpr[6]  = Top->rootp->core__DOT__RF__DOT__rf_6;
-        context.gpr[7]  = Top->rootp->core__DOT__RF__DOT__rf_7;
-        context.gpr[8]  = Top->rootp->core__DOT__RF__DOT__rf_8;
-        context.gpr[9]  = Top->rootp->core__DOT__RF__DOT__rf_9;
-        context.gpr[10] = Top->rootp->core__DOT__RF__DOT__rf_10;
-        context.gpr[11] = Top->rootp->core__DOT__RF__DOT__rf_11;
-        context.gpr[12] = Top->rootp->core__DOT__RF__DOT__rf_12;
-        context.gpr[13] = Top->rootp->core__DOT__RF__DOT__rf_13;
-        context.gpr[14] = Top->rootp->core__DOT__RF__DOT__rf_14;
-        context.gpr[15] = Top->rootp->core__DOT__RF__DOT__rf_15;
-        context.gpr[16] = Top->rootp->core__DOT__RF__DOT__rf_16;
-        context.gpr[17] = Top->rootp->core__DOT__RF__DOT__rf_17;
-        context.gpr[18] = Top->rootp->core__DOT__RF__DOT__rf_18;
-        context.gpr[19] = Top->rootp->core__DOT__RF__DOT__rf_19;
-        context.gpr[20] = Top->rootp->core__DOT__RF__DOT__rf_20;
-        context.gpr[21] = Top->rootp->core__DOT__RF__DOT__rf_21;
-        context.gpr[22] = Top->rootp->core__DOT__RF__DOT__rf_22;
-        context.gpr[23] = Top->rootp->core__DOT__RF__DOT__rf_23;
-        context.gpr[24] = Top->rootp->core__DOT__RF__DOT__rf_24;
-        context.gpr[25] = Top->rootp->core__DOT__RF__DOT__rf_25;
-        context.gpr[26] = Top->rootp->core__DOT__RF__DOT__rf_26;
-        context.gpr[27] = Top->rootp->core__DOT__RF__DOT__rf_27;
-        context.gpr[28] = Top->rootp->core__DOT__RF__DOT__rf_28;
-        context.gpr[29] = Top->rootp->core__DOT__RF__DOT__rf_29;
-        context.gpr[30] = Top->rootp->core__DOT__RF__DOT__rf_30;
-        context.gpr[31] = Top->rootp->core__DOT__RF__DOT__rf_31;
-
+        // 只重新读取脏寄存器；x0 恒为 0，不在组内
+        const uint32_t mask = gpr_dirty | gpr_dirty_prev;
+        if (mask == ~0u) {
+            gpr_group.snapshot(gpr_shadow + 1);
+        } else if (mask >> 1) {
+            gpr_group.snapshot(gpr_shadow + 1, mask >> 1);
+        }
+        gpr_dirty_prev = gpr_dirty;
+        gpr_dirty = 0;
+        // difftest 仍对比全部 32 个寄存器：影子副本中未写的寄存器保持原值，REF 多写也能发现
+        for (int i = 0; i < 32; i++) {
+            context.gpr[i] = gpr_shadow[i];
+        }
         return context;
     }
-} // namespace multiple
\ No newline at end of file
+} // namespace multiple
@@ -0,0 +1,181 @@
+// src/multi-core/fastforward.cpp
+//
+// 在 REF 上功能快进，再把体系结构状态装入 RTL 继续周期精确仿真
+//
+
+#include "AdaptSim/multicore/core.h"
+#include "AdaptSim/multicore/context.h"
+#include "AdaptSim/vmemory.h"
+#include "AdaptSim/utils/decode.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "Vcore.h"
+#include "verilated.h"
+
+namespace multiple {
+
+    namespace {
+        constexpr uint64_t FF_EXEC_CHUNK = uint64_t{1} << 24; // 按指令数快进时每次 exec 的条数
+
+        // REF 停机 (ebreak) 或陷入自环后 exec 不再改变任何状态
+        bool same_state(const utils::diff_context_t& a, const utils::diff_context_t& b) {
+            return a.pc == b.pc && std::equal(std::begin(a.gpr), std::end(a.gpr), std::begin(b.gpr));
+        }
+
+        utils::DecodedInst ref_inst(utils::Difftest& ref, paddr_t pc) {
+            uint32_t inst = 0;
+            ref.memcpy(pc, &inst, sizeof(inst), DIFFTEST_TO_DUT);
+            return utils::rv32_decode(inst);
+        }
+
+        // 状态不再变化时区分停机与自环 (j . / beq x0, x0, .)。NEMU 停机后 PC 停在 ebreak 的下一条，
+        // 而 AM 的 halt() 在 ebreak 之后正好是 while (1)，所以先看前一条是否为 ebreak
+        bool ref_halted(utils::Difftest& ref, const utils::diff_context_t& s) {
+            const utils::DecodedInst cur = ref_inst(ref, s.pc);
+            if (cur.op == utils::RvOp::EBREAK || ref_inst(ref, s.pc - 4).op == utils::RvOp::EBREAK) {
+                return true;
+            }
+            return !cur.is_jump() && !cur.is_branch();
+        }
+    }
+
+    uint64_t Sim_core::fast_forward(utils::Difftest& ref) {
+        SimContext::Binding bind(ctx);
+        if (!ref.is_good() || (conf.ff_insts == 0 && conf.ff_pc == 0)) {
+            return 0;
+        }
+        const SignalRef pc_reg = signals->find(conf.ff_pc_signal);
+        if (!pc_reg || !gpr_group.complete()) {
+            std::cerr << "Fast-forward: cannot find PC register '" << conf.ff_pc_signal
+                      << "' or the register file in the model" << std::endl;
+            return 0;
+        }
+        // 批量/流水模式下可能还有未对比的提交
+        if (!finish_difftest()) {
+            return 0;
+        }
+
+        // 1. REF 快进
+        utils::diff_context_t state = ref.get_ref_state();
+        uint64_t done = 0;
+        uint64_t halt_window = 0; // 停机发生在 (done, done + halt_window] 内的某条指令
+        bool halted = false;
+        bool spinning = false;
+        const uint64_t limit = conf.ff_insts ? conf.ff_insts : UINT64_MAX;
+        if (conf.ff_pc == 0) {
+            // 每段之后检查 REF 是否还在前进，最后一段之后再单步探测一次。NEMU 在停机的那一段里状态仍有变化，
+            // 要到下一段才发现不再前进，而 difftest 接口不报告实际执行的条数，所以停机点只能确定在上一段内
+            uint64_t last = 0; // 最近一次有进展的那一段的条数
+            bool stuck = false;
+            auto run = [&](uint64_t n) {
+                ref.exec(n);
+                const utils::diff_context_t prev = state;
+                state = ref.get_ref_state();
+                return !same_state(state, prev);
+            };
+            while (done < limit) {
+                const uint64_t n = std::min(FF_EXEC_CHUNK, limit - done);
+                if (!run(n)) {
+                    stuck = true;
+                    break;
+                }
+                done += n;
+                last = n;
+            }
+            if (!stuck) {
+                const paddr_t probe_pc = state.pc;
+                if (run(1)) {
+                    done++;
+                    // 探测的这一条恰好是 ebreak：停机点是精确的
+                    halted = ref_inst(ref, probe_pc).op == utils::RvOp::EBREAK;
+                } else {
+                    stuck = true;
+                }
+            }
+            if (stuck) {
+                spinning = !ref_halted(ref, state);
+                halted = !spinning;
+                if (halted) {
+                    // 停在 ebreak 上不动的 REF（如 stub_ref）可能到卡住的这一段才执行到 ebreak
+                    done -= last;
+                    halt_window = last + (ref_inst(ref, state.pc).op == utils::RvOp::EBREAK);
+                } else {
+                    done = std::max(done, limit); // 自环到快进结束，其余各段都不会改变状态
+                }
+            }
+        } else {
+            // 按 PC 停下只能逐条执行，但仍比 RTL 快几个数量级
+            while (state.pc != conf.ff_pc && done < limit) {
+                ref.exec(1);
+                const utils::diff_context_t prev = state;
+                state = ref.get_ref_state();
+                if (same_state(state, prev)) {
+                    spinning = !ref_halted(ref, state);
+                    halted = !spinning;
+                    break;
+                }
+                done++;
+            }
+        }
+        ff_inst_cnt = done;
+        if (halted) {
+            // 程序在快进范围内就已结束，RTL 不必再从停机点继续
+            std::cerr << "Fast-forward: REF stopped at 0x" << std::hex << state.pc << std::dec << " after ";
+            if (halt_window > 0) {
+                std::cerr << done + 1 << "-" << done + halt_window;
+            } else {
+                std::cerr << done;
+            }
+            std::cerr << " instructions" << std::endl;
+            cpu.state = CPU_STATES::CPU_END;
+            cpu.halt_ret = static_cast<int>(state.gpr[10]);
+            return done;
+        }
+        if (spinning) {
+            // 自环并非停机：照常装入 RTL，由运行条件（看门狗、最大周期数）决定何时结束
+            std::cerr << "Fast-forward: REF is spinning at 0x" << std::hex << state.pc << std::dec
+                      << (conf.ff_pc ? ", target PC is unreachable" : "") << std::endl;
+        }
+
+        // 2. 内存：逐页拷贝，全零页不在 DUT 中分配
+        memory::VMem& mem = memory::get_memory();
+        std::vector<uint8_t> page(memory::VMem::PAGE_SIZE);
+        const uint64_t mem_end = uint64_t{conf.ff_mem_base} + conf.ff_mem_size;
+        for (uint64_t addr = conf.ff_mem_base; addr < mem_end; addr += page.size()) {
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(page.size(), mem_end - addr));
+            ref.memcpy(static_cast<paddr_t>(addr), page.data(), n, DIFFTEST_TO_DUT);
+            const bool zero = std::all_of(page.begin(), page.begin() + static_cast<std::ptrdiff_t>(n),
+                                          [](uint8_t b) { return b == 0; });
+            if (zero) {
+                mem.zero_range(static_cast<uint32_t>(addr), n);
+            } else {
+                mem.write_bytes(static_cast<uint32_t>(addr), page.data(), n);
+            }
+        }
+
+        // 3. 装入 RTL：寄存器堆与取指 PC，随后求值一次使组合逻辑跟上
+        for (size_t i = 0; i < gpr_group.size(); i++) {
+            gpr_group[i].set(state.gpr[i + 1]);
+        }
+        pc_reg.set(state.pc);
+        Top->eval();
+        if (itrace) {
+            itrace->sync(state.gpr);
+        }
+
+        gpr_dirty = gpr_dirty_prev = ~0u;
+        // 差分测试从快进后的状态继续逐条对比
+        ref.restore_ref(state, done);
+        if (difftest == &ref) {
+            attach_difftest(difftest);
+        }
+        std::cout << "Fast-forwarded " << done << " instructions on the REF, resuming RTL at pc 0x"
+                  << std::hex << state.pc << std::dec << std::endl;
+        return done;
+    }
+
+} // namespace multiple
@@ -0,0 +1,141 @@
+// src/multi-core/perf.cpp
+
+#include "AdaptSim/multicore/perf.h"
+
+#include <cstdio>
+#include <iostream>
+
+namespace multiple {
+
+    namespace {
+
+        // 流水寄存器：名称、有效位、出队握手
+        struct StageDef {
+            const char* name;
+            const char* valid;
+            const char* fire;
+        };
+
+        constexpr StageDef STAGES[] = {
+            {"next_pc",       "core__DOT__validReg_8", "core__DOT__consumerFire_8"}, // WBU -> IFU
+            {"ifu_sram_req",  "core__DOT__validReg_1", "core__DOT__consumerFire_1"},
+            {"ifu_sram_resp", "core__DOT__validReg_2", "core__DOT__consumerFire_2"},
+            {"decode",        "core__DOT__validReg",   "core__DOT__consumerFire"},   // IFU -> IDU
+            {"execute",       "core__DOT__validReg_3", "core__DOT__consumerFire_3"}, // IDU -> EXU
+            {"lsu",           "core__DOT__validReg_4", "core__DOT__consumerFire_4"}, // EXU -> LSU
+            {"writeback",     "core__DOT__validReg_5", "core__DOT__consumerFire_5"}, // LSU -> WBU
+            {"lsu_sram_req",  "core__DOT__validReg_6", "core__DOT__consumerFire_6"},
+            {"lsu_sram_resp", "core__DOT__validReg_7", "core__DOT__consumerFire_7"},
+        };
+
+        // 访存端口：请求/响应寄存器的有效位与入队握手，以及写使能；
+        // store_name 为空时不区分读写
+        struct MemDef {
+            const char* load_name;
+            const char* store_name;
+            const char* req_valid;
+            const char* req_fire;
+            const char* resp_valid;
+            const char* resp_fire;
+            const char* wen;
+        };
+
+        constexpr MemDef MEM_PORTS[] = {
+            {"ifetch", nullptr,
+             "core__DOT__validReg_1", "core__DOT__producerFire_1",
+             "core__DOT__validReg_2", "core__DOT__producerFire_2", nullptr},
+            {"lsu_load", "lsu_store",
+             "core__DOT__validReg_6", "core__DOT__producerFire_6",
+             "core__DOT__validReg_7", "core__DOT__producerFire_7", "core__DOT__dataReg_6_wen"},
+        };
+
+        // 单比特信号在 Verilator 中都是 CData，直接按字节读取
+        const uint8_t* find_bit(const SignalRegistry& signals, const char* name) {
+            if (!name) {
+                return nullptr;
+            }
+            const SignalRef ref = signals.find(name);
+            return ref && ref.bytes == 1 ? static_cast<const uint8_t*>(ref.ptr) : nullptr;
+        }
+
+    } // namespace
+
+    PerfCounters::PerfCounters(const SignalRegistry& signals) {
+        for (const StageDef& def : STAGES) {
+            const uint8_t* valid = find_bit(signals, def.valid);
+            if (!valid) {
+                continue;
+            }
+            stage_sigs.push_back({stages_.size(), valid, find_bit(signals, def.fire)});
+            stages_.push_back({def.name});
+        }
+        for (const MemDef& def : MEM_PORTS) {
+            const uint8_t* req_valid = find_bit(signals, def.req_valid);
+            const uint8_t* resp_valid = find_bit(signals, def.resp_valid);
+            if (!req_valid || !resp_valid) {
+                continue;
+            }
+            MemPort port{};
+            port.load_index = latency_.size();
+            latency_.push_back({def.load_name});
+            port.store_index = port.load_index;
+            if (def.store_name) {
+                port.store_index = latency_.size();
+                latency_.push_back({def.store_name});
+            }
+            port.req_valid = req_valid;
+            port.req_fire = find_bit(signals, def.req_fire);
+            port.resp_valid = resp_valid;
+            port.resp_fire = find_bit(signals, def.resp_fire);
+            port.wen = find_bit(signals, def.wen);
+            mem_sigs.push_back(port);
+        }
+        if (resolved() == 0) {
+            std::cerr << "Perf counters: no pipeline handshake signals found in the model" << std::endl;
+        }
+    }
+
+    bool PerfCounters::write_json(const std::string& path, uint64_t inst_cnt) const {
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) {
+            std::cerr << "Perf counters: cannot write " << path << std::endl;
+            return false;
+        }
+        const auto u = [](uint64_t v) { return static_cast<unsigned long long>(v); };
+        const uint64_t n_insts = insts(inst_cnt);
+        std::fprintf(f, "{\n  \"cycles\": %llu,\n  \"insts\": %llu,\n  \"ipc\": %.6f,\n  \"stages\": [",
+                     u(cycles_), u(n_insts), cycles_ ? static_cast<double>(n_insts) / cycles_ : 0.0);
+        for (size_t i = 0; i < stages_.size(); i++) {
+            const StageCounters& s = stages_[i];
+            const uint64_t total = s.valid + s.bubble;
+            std::fprintf(f,
+                         "%s\n    {\"name\": \"%s\", \"valid\": %llu, \"fire\": %llu, \"stall\": %llu, "
+                         "\"bubble\": %llu, \"occupancy\": %.6f}",
+                         i ? "," : "", s.name, u(s.valid), u(s.fire), u(s.stall), u(s.bubble),
+                         total ? static_cast<double>(s.valid) / total : 0.0);
+        }
+        std::fprintf(f, "\n  ],\n  \"latency\": [");
+        for (size_t i = 0; i < latency_.size(); i++) {
+            const LatencyCounters& l = latency_[i];
+            std::fprintf(f,
+                         "%s\n    {\"name\": \"%s\", \"count\": %llu, \"mean\": %.3f, \"min\": %llu, \"max\": %llu, "
+                         "\"hist\": {",
+                         i ? "," : "", l.name, u(l.count), l.count ? static_cast<double>(l.sum) / l.count : 0.0,
+                         u(l.count ? l.min : 0), u(l.max));
+            // 只写非零格；最后一格的键为 "63+"
+            bool first = true;
+            for (size_t b = 0; b < LatencyCounters::BUCKETS; b++) {
+                if (!l.hist[b]) {
+                    continue;
+                }
+                std::fprintf(f, "%s\"%zu%s\": %llu", first ? "" : ", ", b,
+                             b == LatencyCounters::BUCKETS - 1 ? "+" : "", u(l.hist[b]));
+                first = false;
+            }
+            std::fprintf(f, "}}");
+        }
+        std::fprintf(f, "\n  ]\n}\n");
+        return std::fclose(f) == 0;
+    }
+
+} // namespace multiple
@@ -0,0 +1,87 @@
+// src/multi-core/signals.cpp
+
+#include "AdaptSim/multicore/signals.h"
+#include <cstring>
+
+namespace multiple {
+
+    SignalRegistry::SignalRegistry(Vcore___024root* root) {
+        signals.reserve(detail::SIGNAL_TABLE_SIZE);
+        index.reserve(detail::SIGNAL_TABLE_SIZE);
+        for (size_t i = 0; i < detail::SIGNAL_TABLE_SIZE; i++) {
+            const SignalDesc& desc = detail::SIGNAL_TABLE[i];
+            signals.push_back({desc.name, desc.addr(root), desc.width, desc.bytes});
+            index.emplace(desc.name, i);
+        }
+    }
+
+    SignalRef SignalRegistry::find(std::string_view name) const {
+        const auto it = index.find(name);
+        return it == index.end() ? SignalRef{} : signals[it->second];
+    }
+
+    SignalGroup SignalRegistry::group(const std::vector<std::string>& names) const {
+        SignalGroup g;
+        g.refs.reserve(names.size());
+        for (const std::string& name : names) {
+            const SignalRef ref = find(name);
+            if (!ref) {
+                g.missing++;
+            }
+            if (g.refs.empty()) {
+                g.uniform_bytes = ref.bytes;
+            } else if (g.uniform_bytes != ref.bytes) {
+                g.uniform_bytes = 0;
+            }
+            g.raw_bytes += ref.bytes;
+            g.refs.push_back(ref);
+        }
+        if (g.missing) {
+            g.uniform_bytes = 0;
+        }
+        return g;
+    }
+
+    template <typename T>
+    static void snapshot_as(const std::vector<SignalRef>& refs, uint32_t* out) {
+        for (size_t i = 0; i < refs.size(); i++) {
+            out[i] = static_cast<uint32_t>(*static_cast<const T*>(refs[i].ptr));
+        }
+    }
+
+    void SignalGroup::snapshot(uint32_t* out) const {
+        switch (uniform_bytes) {
+            case 1: snapshot_as<uint8_t>(refs, out); return;
+            case 2: snapshot_as<uint16_t>(refs, out); return;
+            case 4: snapshot_as<uint32_t>(refs, out); return;
+            case 8: snapshot_as<uint64_t>(refs, out); return;
+            default: break;
+        }
+        for (size_t i = 0; i < refs.size(); i++) {
+            out[i] = refs[i] ? static_cast<uint32_t>(refs[i].value()) : 0;
+        }
+    }
+
+    void SignalGroup::snapshot(uint32_t* out, uint32_t mask) const {
+        if (refs.size() < 32) {
+            mask &= (1u << refs.size()) - 1;
+        }
+        while (mask) {
+            const unsigned i = __builtin_ctz(mask);
+            mask &= mask - 1;
+            out[i] = refs[i] ? static_cast<uint32_t>(refs[i].value()) : 0;
+        }
+    }
+
+    size_t SignalGroup::snapshot_raw(uint8_t* out) const {
+        size_t off = 0;
+        for (const SignalRef& ref : refs) {
+            if (ref) {
+                std::memcpy(out + off, ref.ptr, ref.bytes);
+            }
+            off += ref.bytes;
+        }
+        return off;
+    }
+
+} // namespace multiple
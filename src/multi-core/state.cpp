@@ -4,27 +4,17 @@
 
 #include "../../include/AdaptSim/multicore/state.h"
 namespace multiple {
-enum class CPU_STATES
-{
-    CPU_RUNNING,
-    CPU_STOP,
-    CPU_END,
-    CPU_ABORT,
-    CPU_QUIT
-};
-
-// 创建一个结构体来保存CPU状态和返回值
-struct CPU_State {
-    CPU_STATES state;
-    int halt_ret;
-};
-
 CPU_State cpu_state;
 
 int is_exit_status_bad()
 {
-    int good = (cpu_state.state == CPU_STATES::CPU_END && cpu_state.halt_ret == 0) ||
-               (cpu_state.state == CPU_STATES::CPU_QUIT);
+    return is_exit_status_bad(cpu_state);
+}
+
+int is_exit_status_bad(const CPU_State& state)
+{
+    int good = (state.state == CPU_STATES::CPU_END && state.halt_ret == 0) ||
+               (state.state == CPU_STATES::CPU_QUIT);
     return !good;
 }
 
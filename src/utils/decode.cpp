@@ -0,0 +1,62 @@
+// src/utils/decode.cpp
+
+#include "AdaptSim/utils/decode.h"
+
+namespace utils {
+
+    DecodeCache::DecodeCache(unsigned log2_entries)
+        : entries(std::make_unique<DecodedInst[]>(size_t{1} << log2_entries)),
+          shift(32 - log2_entries) {
+        const DecodedInst zero = rv32_decode(0);
+        for (size_t i = 0; i < (size_t{1} << log2_entries); ++i) {
+            entries[i] = zero;
+        }
+    }
+
+    const DecodedInst& decode_cached(uint32_t inst) {
+        thread_local DecodeCache cache;
+        return cache.decode(inst);
+    }
+
+    const char* rv_op_name(RvOp op) {
+        static constexpr const char* names[] = {
+            "invalid",
+            "lui", "auipc", "jal", "jalr",
+            "beq", "bne", "blt", "bge", "bltu", "bgeu",
+            "lb", "lh", "lw", "lbu", "lhu",
+            "sb", "sh", "sw",
+            "addi", "slti", "sltiu", "xori", "ori", "andi", "slli", "srli", "srai",
+            "add", "sub", "sll", "slt", "sltu", "xor", "srl", "sra", "or", "and",
+            "mul", "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu",
+            "fence", "fence.i",
+            "ecall", "ebreak", "mret",
+            "csrrw", "csrrs", "csrrc", "csrrwi", "csrrsi", "csrrci",
+        };
+        static_assert(std::size(names) == static_cast<size_t>(RvOp::COUNT));
+        const auto i = static_cast<size_t>(op);
+        return i < std::size(names) ? names[i] : "invalid";
+    }
+
+    const char* instruction_type_name(const DecodedInst& d) {
+        switch (d.cls) {
+        case InstClass::Invalid:
+            return "INVALID";
+        case InstClass::Alu:
+            return "R-type";
+        case InstClass::AluImm:
+        case InstClass::Load:
+            return "I-type";
+        case InstClass::Store:
+            return "S-type";
+        case InstClass::Branch:
+            return "B-type";
+        case InstClass::Upper:
+            return "U-type";
+        case InstClass::Jump:
+            return d.op == RvOp::JAL ? "J-type" : "I-type";
+        default:
+            return "Other";
+        }
+    }
+
+} // namespace utils
@@ -3,11 +3,16 @@
 //
 
 #include "AdaptSim/utils/difftest.h"
+#include "AdaptSim/vmemory.h"
+#include "AdaptSim/utils/selfprof.h"
 // difftest.cpp
 
 
 #include <dlfcn.h>
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <vector>
 
 // 宏，用于简化 dlsym 的调用和错误处理
@@ -31,7 +36,13 @@ Difftest::Difftest(const char* ref_so_file, long img_size) {
     }
 
     // 1. 加载 (Load)
-    handle = dlopen(ref_so_file, RTLD_LAZY);
+    // 放进独立的链接命名空间，使同一进程中的多个 Difftest 各有一份 REF 全局状态；
+    // 命名空间数量有限 (glibc 约 16 个)，用尽时退回共享的 dlopen
+    handle = dlmopen(LM_ID_NEWLM, ref_so_file, RTLD_LAZY | RTLD_LOCAL);
+    if (!handle) {
+        std::cerr << "[Difftest] dlmopen failed (" << dlerror() << "), REF state will be shared with other instances" << std::endl;
+        handle = dlopen(ref_so_file, RTLD_LAZY);
+    }
     if (!handle) {
         std::cerr << "[Difftest] Failed to load shared library '" << ref_so_file << "'." << std::endl;
         std::cerr << "  dlerror: " << dlerror() << std::endl;
@@ -49,6 +60,9 @@ Difftest::Difftest(const char* ref_so_file, long img_size) {
 
     // 初始化REF
     this->init();
+    regcpy(&last_good, DIFFTEST_TO_DUT);
+    ref_pc = last_good.pc;
+    store_queue.reserve(STORE_QUEUE_CAP);
 
     // 将REF的初始内存镜像拷贝到DUT的内存中
     // 假设DUT的内存起始地址是0x80000000
@@ -64,6 +78,9 @@ Difftest::Difftest(const char* ref_so_file, long img_size) {
 }
 
 Difftest::~Difftest() {
+    if (observed_mem) {
+        observed_mem->set_store_observer(nullptr, nullptr);
+    }
     if (handle) {
         dlclose(handle);
     }
@@ -90,64 +107,353 @@ void Difftest::raise_intr(uint64_t NO) {
     if (good) func_raise_intr(NO);
 }
 
+diff_context_t Difftest::get_ref_state() {
+    diff_context_t ref{};
+    regcpy(&ref, DIFFTEST_TO_DUT);
+    return ref;
+}
+
+void Difftest::restore_ref(const diff_context_t& ref, uint64_t commit_count) {
+    if (!good) return;
+    last_good = ref;
+    regcpy(&last_good, DIFFTEST_TO_REF);
+    ref_pc = ref.pc;
+    commit_cnt = commit_count;
+    is_skip = false;
+    pending.clear();
+    pending_stores.clear();
+    undo_log.clear();
+    undo_committed = 0;
+    store_queue.clear();
+    store_committed = 0;
+}
+
 // --- 辅助函数实现 ---
 void Difftest::skip_dut_once() {
     if (good) this->is_skip = true;
 }
 
-void Difftest::store_commit(paddr_t addr, word_t data, int len) {
-    // 商业级的Difftest通常会在这里缓存store操作，
-    // 在下一次step对比寄存器之前，先对比这些缓存的store操作是否一致。
-    // 这里简化处理，可以暂时为空。
+void Difftest::store_commit(paddr_t addr, word_t data, int len, word_t old_data) {
+    // 缓存store操作，在下一个对比点对比寄存器之后，再与REF内存核对
+    if (!good) return;
+    if (store_queue.size() < STORE_QUEUE_CAP) {
+        store_queue.push_back({addr, static_cast<uint32_t>(len), data, cycle_src ? *cycle_src : 0});
+    } else {
+        ++store_dropped;
+    }
+    if (batch_max > 1) {
+        undo_log.push_back({addr, static_cast<uint32_t>(len), old_data});
+    }
 }
 
+bool Difftest::check_store_range(size_t begin, size_t end, bool report) {
+    const size_t n = end - begin;
+    if (n == 0) {
+        return true;
+    }
+
+    sq_order.resize(n);
+    std::iota(sq_order.begin(), sq_order.end(), static_cast<uint32_t>(begin));
+    std::stable_sort(sq_order.begin(), sq_order.end(),
+                     [&](uint32_t a, uint32_t b) { return store_queue[a].addr < store_queue[b].addr; });
+
+    bool ok = true;
+    for (size_t i = 0; i < n;) {
+        const uint64_t lo = store_queue[sq_order[i]].addr;
+        uint64_t hi = lo + store_queue[sq_order[i]].len;
+        size_t j = i + 1;
+        for (; j < n; ++j) {
+            const StoreEntry& e = store_queue[sq_order[j]];
+            const uint64_t e_hi = static_cast<uint64_t>(e.addr) + e.len;
+            // 与当前区间重叠的store必须留在同一区间，才能决定每个字节的最后写入者，因此长度上限只在不重叠处切分
+            if (e.addr > hi + STORE_COALESCE_GAP || (e.addr >= hi && e_hi - lo > STORE_RANGE_MAX)) {
+                break;
+            }
+            hi = std::max(hi, e_hi);
+        }
+
+        // 一个区间只读一次REF内存
+        const size_t span = hi - lo;
+        sq_ref.resize(span);
+        memcpy(static_cast<paddr_t>(lo), sq_ref.data(), span, DIFFTEST_TO_DUT);
+
+        // 同一字节被多次写时只核对程序顺序中最后一次写入
+        sq_owner.assign(span, -1);
+        for (size_t k = i; k < j; ++k) {
+            const uint32_t idx = sq_order[k];
+            const StoreEntry& e = store_queue[idx];
+            for (uint32_t b = 0; b < e.len; ++b) {
+                int32_t& owner = sq_owner[e.addr - lo + b];
+                owner = std::max(owner, static_cast<int32_t>(idx));
+            }
+        }
+        for (size_t k = i; k < j; ++k) {
+            const uint32_t idx = sq_order[k];
+            const StoreEntry& e = store_queue[idx];
+            word_t ref_val = 0;
+            bool differs = false;
+            for (uint32_t b = 0; b < e.len; ++b) {
+                const uint8_t ref_byte = sq_ref[e.addr - lo + b];
+                ref_val |= static_cast<word_t>(ref_byte) << (8 * b);
+                if (sq_owner[e.addr - lo + b] == static_cast<int32_t>(idx) &&
+                    ref_byte != static_cast<uint8_t>(e.data >> (8 * b))) {
+                    differs = true;
+                }
+            }
+            if (differs) {
+                if (!report) {
+                    return false;
+                }
+                ok = false;
+                std::cerr << "[Difftest] Store mismatch at 0x" << std::hex << std::setw(8) << std::setfill('0')
+                          << e.addr << std::dec << " (" << e.len << " bytes), DUT cycle " << e.cycle << std::endl;
+                std::cerr << "  REF value = 0x" << std::hex << ref_val << std::endl;
+                std::cerr << "  DUT value = 0x" << std::hex << e.data << std::dec << std::setfill(' ') << std::endl;
+            }
+        }
+        i = j;
+    }
+    return ok;
+}
+
+bool Difftest::check_stores() {
+    const bool ok = check_store_range(0, store_committed, true);
+    // 尚未提交的指令产生的store留到下一个对比点
+    store_queue.erase(store_queue.begin(), store_queue.begin() + static_cast<std::ptrdiff_t>(store_committed));
+    store_committed = 0;
+    if (store_dropped) {
+        std::cerr << "[Difftest] Store queue overflowed, " << store_dropped << " stores were not checked" << std::endl;
+        store_dropped = 0;
+    }
+    return ok;
+}
+
+void Difftest::observe_dut_stores() {
+    if (!good) return;
+    observed_mem = &memory::get_memory();
+    observed_mem->set_store_observer(&Difftest::on_dut_store, this);
+}
+
+
+bool Difftest::check(paddr_t ref_pc_before, const diff_context_t& ref, const diff_context_t& dut, bool report) {
+    bool regs_match = true;
+    if (ref_pc_before != dut.pc) {
+        regs_match = false;
+        if (report) {
+            std::cerr << "[Difftest] PC mismatch!" << std::endl;
+            std::cerr << "  REF PC = 0x" << std::hex << ref_pc_before << std::endl;
+            std::cerr << "  DUT PC = 0x" << std::hex << dut.pc << std::dec << std::endl;
+        }
+    }
+    for (int i = 0; i < 32; ++i) {
+        if (ref.gpr[i] != dut.gpr[i]) {
+            regs_match = false;
+            if (report) {
+                std::cerr << "[Difftest] GPR x" << i << " mismatch!" << std::endl;
+                std::cerr << "  REF value = 0x" << std::hex << ref.gpr[i] << std::endl;
+                std::cerr << "  DUT value = 0x" << std::hex << dut.gpr[i] << std::dec << std::endl;
+            }
+        }
+    }
+    return regs_match;
+}
+
+void Difftest::sync_ref_to(const diff_context_t& dut) {
+    // 被跳过的指令（MMIO访存、CSR等）不改变控制流，REF从下一条继续
+    diff_context_t ctx = dut;
+    ctx.pc = dut.pc + 4;
+    regcpy(&ctx, DIFFTEST_TO_REF);
+    last_good = ctx;
+    ref_pc = ctx.pc;
+    ++commit_cnt;
+    // 被跳过指令的store REF不会执行，不参与核对。之后的undo项留着：REF没有执行的写入按旧值回滚也正好是REF的内容
+    store_queue.resize(store_committed);
+    trim_undo_log();
+}
 
-bool Difftest::step(diff_context_t *dut) {
+bool Difftest::step(const diff_context_t& dut) {
     if (!good) return true; // Difftest未启用，默认通过
+    SELFPROF_SCOPE(Difftest);
     if (is_skip) {
         is_skip = false;
+        sync_ref_to(dut);
         return true;
     }
+    store_committed = store_queue.size();
 
-    // 1. 获取REF执行前的寄存器状态 (用于对比)
-    diff_context_t ref_context_before;
-    regcpy(&ref_context_before, DIFFTEST_TO_DUT);
+    // REF执行一步；执行前的PC已在上一次regcpy时记录，每步只需一次regcpy
+    exec(1);
+    diff_context_t ref_context_after{};
+    regcpy(&ref_context_after, DIFFTEST_TO_DUT);
 
-    // 2. 检查PC是否一致
-    if (ref_context_before.pc != dut_pc) {
-        std::cerr << "[Difftest] PC mismatch before execution!" << std::endl;
-        std::cerr << "  REF PC = 0x" << std::hex << ref_context_before.pc << std::endl;
-        std::cerr << "  DUT PC = 0x" << std::hex << dut_pc << std::endl;
+    if (!check(ref_pc, ref_context_after, dut, true)) {
+        std::cerr << "[Difftest] Mismatch at instruction #" << commit_cnt << std::endl;
         return false;
     }
+    ref_pc = ref_context_after.pc;
+    if (!check_stores()) {
+        std::cerr << "[Difftest] Mismatch at instruction #" << commit_cnt << std::endl;
+        return false;
+    }
+    ++commit_cnt;
+    return true;
+}
+
+// --- 批量模式 ---
+void Difftest::set_batch(uint32_t n, bool adaptive) {
+    if (!good) return;
+    flush();
+    batch_max = std::max(n, 1u);
+    // 自适应时从逐条对比起步，批次一致后逐步放大到 batch_max
+    batch_cur = adaptive ? 1u : batch_max;
+    batch_adaptive = adaptive;
+    pending.reserve(batch_max);
+    pending_stores.reserve(batch_max);
+    // 逐条模式不需要回滚；批量模式下flush之后剩下的是尚未提交指令的旧值，仍然需要
+    if (batch_max <= 1) {
+        undo_log.clear();
+        undo_committed = 0;
+    }
+}
+
+void Difftest::on_dut_store(void* self, uint32_t addr, uint32_t len, uint32_t old_data, uint32_t new_data) {
+    static_cast<Difftest*>(self)->store_commit(addr, new_data, static_cast<int>(len), old_data);
+}
+
+bool Difftest::commit(const diff_context_t& dut) {
+    if (!good) return true;
+    // 逐条模式直接交给step，由它计时，避免同一次提交被计两次
+    if (batch_max <= 1) return step(dut);
+    SELFPROF_SCOPE(Difftest);
+
+    if (is_skip) {
+        // 跳过的指令打断批次：先检查之前的提交（不含被跳过指令的store），再用DUT状态覆盖REF
+        store_queue.resize(store_committed);
+        if (!flush()) return false;
+        is_skip = false;
+        sync_ref_to(dut);
+        return true;
+    }
+
+    pending.push_back(dut);
+    store_committed = store_queue.size();
+    undo_committed = undo_log.size();
+    pending_stores.push_back(static_cast<uint32_t>(store_committed));
+    // store队列快满时提前结束本批次
+    if (pending.size() < batch_cur && store_committed < STORE_QUEUE_CAP / 2) return true;
+    return flush();
+}
+
+bool Difftest::flush() {
+    if (!good || pending.empty()) return true;
 
-    // 3. 让REF执行一步
+    // 最后一条指令执行前的PC需要单独取一次，其余只在批次边界对比
+    const size_t n = pending.size();
+    diff_context_t ref{};
+    paddr_t pc_before_last = ref_pc;
+    if (n > 1) {
+        exec(n - 1);
+        regcpy(&ref, DIFFTEST_TO_DUT);
+        pc_before_last = ref.pc;
+    }
     exec(1);
+    regcpy(&ref, DIFFTEST_TO_DUT);
 
-    // 4. 获取REF执行后的寄存器状态
-    diff_context_t ref_context_after;
-    regcpy(&ref_context_after, DIFFTEST_TO_DUT);
+    // 寄存器和store任一不一致都逐条重放定位；批次内不打印，留给重放报告第一条分歧指令
+    if (!check(pc_before_last, ref, pending.back(), false) || !check_store_range(0, store_committed, false)) {
+        return bisect();
+    }
+
+    last_good = ref;
+    ref_pc = ref.pc;
+    check_stores();
+    trim_undo_log();
+    commit_cnt += n;
+    pending.clear();
+    pending_stores.clear();
+    if (batch_adaptive) {
+        batch_cur = std::min(batch_cur * 2, batch_max);
+    }
+    return true;
+}
 
-    // 5. 获取DUT执行后的寄存器状态
-    diff_context_t dut_context_after;
+void Difftest::trim_undo_log() {
+    // 一致点之前的旧值不再需要，尚未提交指令的旧值留到下一次回滚
+    undo_log.erase(undo_log.begin(), undo_log.begin() + static_cast<std::ptrdiff_t>(undo_committed));
+    undo_committed = 0;
+}
 
-    bool regs_match = true;
-    if (ref_context_after.pc != dut_context_after.pc) {
-        regs_match = false;
-        std::cerr << "[Difftest] PC mismatch after execution!" << std::endl;
-        std::cerr << "  REF next_PC = 0x" << std::hex << ref_context_after.pc << std::endl;
-        std::cerr << "  DUT next_PC = 0x" << std::hex << dut_context_after.pc << std::endl;
+void Difftest::sync_ref_memory() {
+    // 按地址顺序遍历DUT已分配的页：窗口内有页的整页拷贝，没有页的部分（DUT读为0）清零
+    static const std::vector<uint8_t> zero(memory::VMem::PAGE_SIZE);
+    const uint64_t end = uint64_t{ref_mem_base} + ref_mem_size;
+    uint64_t cursor = ref_mem_base;
+    auto fill_zero = [&](uint64_t to) {
+        for (; cursor < to; cursor += memory::VMem::PAGE_SIZE) {
+            const size_t len = static_cast<size_t>(std::min<uint64_t>(memory::VMem::PAGE_SIZE, to - cursor));
+            memcpy(static_cast<paddr_t>(cursor), const_cast<uint8_t*>(zero.data()), len, DIFFTEST_TO_REF);
+        }
+        cursor = to;
+    };
+    observed_mem->for_each_page([&](uint32_t addr, const uint8_t* data) {
+        const uint64_t lo = std::max<uint64_t>(addr, ref_mem_base);
+        const uint64_t hi = std::min<uint64_t>(uint64_t{addr} + memory::VMem::PAGE_SIZE, end);
+        if (lo >= hi) {
+            return;
+        }
+        fill_zero(lo);
+        memcpy(static_cast<paddr_t>(lo), const_cast<uint8_t*>(data + (lo - addr)), hi - lo, DIFFTEST_TO_REF);
+        cursor = hi;
+    });
+    fill_zero(end);
+}
+
+bool Difftest::bisect() {
+    // 1. 回滚REF内存。分歧之后REF的store地址可能与DUT不同，只按DUT的store回滚会把这些写入留在REF里，
+    //    因此先用DUT当前内存覆盖REF的内存区间，再按相反顺序写回一致点之后DUT写内存之前的旧值
+    //    （一致点时两侧内存相同，因此这就是REF在一致点的内容）。整段同步只在失配时发生一次。
+    //    没有观察DUT内存时（例如只驱动REF的基准测试）只能按undo_log回滚
+    if (observed_mem) {
+        sync_ref_memory();
     }
-    for (int i = 0; i < 32; ++i) {
-        if (ref_context_after.gpr[i] != dut_context_after.gpr[i]) {
-            regs_match = false;
-            std::cerr << "[Difftest] GPR x" << i << " mismatch!" << std::endl;
-            std::cerr << "  REF value = 0x" << std::hex << ref_context_after.gpr[i] << std::endl;
-            std::cerr << "  DUT value = 0x" << std::hex << dut_context_after.gpr[i] << std::endl;
+    for (auto it = undo_log.rbegin(); it != undo_log.rend(); ++it) {
+        word_t old_data = it->old_data;
+        memcpy(it->addr, &old_data, it->len, DIFFTEST_TO_REF);
+    }
+    // 2. 回滚REF寄存器
+    diff_context_t ctx = last_good;
+    regcpy(&ctx, DIFFTEST_TO_REF);
+
+    // 3. 逐条重放，对照记录下来的DUT提交及其store找出第一条分歧指令
+    paddr_t pc_before = last_good.pc;
+    size_t store_begin = 0;
+    bool found = false;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        exec(1);
+        diff_context_t ref{};
+        regcpy(&ref, DIFFTEST_TO_DUT);
+        if (!check(pc_before, ref, pending[i], true) || !check_store_range(store_begin, pending_stores[i], true)) {
+            commit_cnt += i;
+            found = true;
+            break;
         }
+        pc_before = ref.pc;
+        store_begin = pending_stores[i];
     }
+    if (!found) {
+        std::cerr << "[Difftest] Batch mismatch could not be reproduced step by step" << std::endl;
+        commit_cnt += pending.size() - 1;
+    }
+    std::cerr << "[Difftest] Mismatch at instruction #" << commit_cnt
+              << " (batch size " << batch_cur << ")" << std::endl;
 
-    return regs_match;
+    pending.clear();
+    pending_stores.clear();
+    undo_log.clear();
+    undo_committed = 0;
+    store_queue.clear();
+    store_committed = 0;
+    return false;
 }
 
 } // namespace utils
\ No newline at end of file
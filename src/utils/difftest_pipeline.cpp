@@ -0,0 +1,133 @@
+// src/utils/difftest_pipeline.cpp
+
+#include "AdaptSim/utils/difftest_pipeline.h"
+#include "AdaptSim/vmemory.h"
+
+#include <iostream>
+
+namespace utils {
+
+    DifftestPipeline::DifftestPipeline(Difftest& dt, size_t capacity)
+        : difftest(dt), ring(capacity) {}
+
+    DifftestPipeline::~DifftestPipeline() {
+        finish();
+    }
+
+    void DifftestPipeline::start() {
+        if (checker.joinable() || !difftest.is_good()) {
+            return;
+        }
+        if (difftest.get_batch() > 1) {
+            // 批量失配要用一致点的DUT内存回滚REF，而DUT线程此时已经跑到前面，拿不到这份内存
+            std::cerr << "[Difftest] Batched comparison is not supported by the async pipeline, "
+                         "comparing every instruction" << std::endl;
+            difftest.set_batch(1);
+        }
+        done.store(false, std::memory_order_relaxed);
+        observed_mem = &memory::get_memory();
+        observed_mem->set_store_observer(&DifftestPipeline::on_dut_store, this);
+        difftest.set_cycle_source(&checker_cycle);
+        checker = std::thread(&DifftestPipeline::checker_loop, this);
+    }
+
+    bool DifftestPipeline::finish() {
+        if (checker.joinable()) {
+            done.store(true, std::memory_order_release);
+            checker.join();
+            observed_mem->set_store_observer(nullptr, nullptr);
+            observed_mem = nullptr;
+        }
+        return !failed();
+    }
+
+    void DifftestPipeline::on_dut_store(void* self, uint32_t addr, uint32_t len, uint32_t old_data, uint32_t new_data) {
+        auto* p = static_cast<DifftestPipeline*>(self);
+        const uint64_t cycle = p->dut_cycle_src ? *p->dut_cycle_src : p->last_cycle;
+        p->ring.push({Record::STORE, static_cast<uint8_t>(len), cycle, addr, new_data, old_data});
+    }
+
+    bool DifftestPipeline::commit(uint64_t cycle, const diff_context_t& dut, word_t inst) {
+        if (has_failed.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        last_cycle = cycle;
+
+        // 只传送相对上一次提交变化的寄存器；通常只有一个，多出来的（例如跳过指令后）用 REG 记录先发送
+        Record r{skip_next ? Record::COMMIT_SKIP : Record::COMMIT, 0, cycle, dut.pc, 0, inst};
+        skip_next = false;
+        for (uint8_t i = 1; i < 32; ++i) {
+            if (dut.gpr[i] == dut_gpr[i]) {
+                continue;
+            }
+            dut_gpr[i] = dut.gpr[i];
+            if (r.rd == 0) {
+                r.rd = i;
+                r.data = dut.gpr[i];
+            } else {
+                ring.push({Record::REG, i, cycle, 0, dut.gpr[i], 0});
+            }
+        }
+        ring.push(r);
+        return true;
+    }
+
+    void DifftestPipeline::checker_loop() {
+        diff_context_t ctx{};
+        // 逐条对比，失配的总是最近一条提交
+        uint64_t commit_cycle = 0;
+
+        auto fail = [&] {
+            fail_index = difftest.get_commit_count();
+            fail_cycle = commit_cycle;
+            has_failed.store(true, std::memory_order_release);
+            std::cerr << "[Difftest] First mismatch at instruction #" << fail_index
+                      << ", DUT cycle " << fail_cycle << std::endl;
+        };
+
+        Record r{};
+        for (;;) {
+            if (!ring.try_pop(r)) {
+                // 生产者先推完记录再置 done，因此看到 done 后再试一次即可确定队列已空
+                if (!done.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (!ring.try_pop(r)) {
+                    break;
+                }
+            }
+            if (failed()) {
+                continue; // 已失配：只排空队列，让 DUT 线程不被反压卡住
+            }
+
+            switch (r.kind) {
+            case Record::STORE:
+                checker_cycle = r.cycle;
+                difftest.store_commit(r.addr, r.data, r.rd, r.extra);
+                break;
+            case Record::REG:
+                ctx.gpr[r.rd] = r.data;
+                break;
+            case Record::COMMIT:
+            case Record::COMMIT_SKIP:
+                if (r.rd) {
+                    ctx.gpr[r.rd] = r.data;
+                }
+                ctx.pc = r.addr;
+                commit_cycle = r.cycle;
+                if (r.kind == Record::COMMIT_SKIP) {
+                    difftest.skip_dut_once();
+                }
+                if (!difftest.commit(ctx)) {
+                    fail();
+                }
+                break;
+            }
+        }
+        if (!failed() && !difftest.flush()) {
+            fail();
+        }
+    }
+
+} // namespace utils
@@ -9,6 +9,7 @@
 #include <iomanip>
 #include <sstream>
 #include <AdaptSim/utils/disasm.h>
+#include <AdaptSim/utils/decode.h>
 // 颜色定义
 #define ANSI_FG_RED     "\33[1;31m"
 #define ANSI_FG_GREEN   "\33[1;32m"
@@ -154,97 +155,9 @@ namespace utils
             return results;
         }
 
-        // 获取指令类型信息
+        // 获取指令类型信息：由表驱动解码器分类，不经过 Capstone
         std::string get_instruction_type(uint32_t instruction) {
-            if (!initialized) {
-                return "UNKNOWN";
-            }
-
-            uint8_t code[4];
-            code[0] = instruction & 0xFF;
-            code[1] = (instruction >> 8) & 0xFF;
-            code[2] = (instruction >> 16) & 0xFF;
-            code[3] = (instruction >> 24) & 0xFF;
-
-            cs_insn *insn;
-            size_t count = cs_disasm(handle, code, 4, 0, 0, &insn);
-
-            if (count > 0) {
-                std::string type;
-
-                // 根据指令ID判断类型
-                switch (insn[0].id) {
-                    // R-type instructions
-                case RISCV_INS_ADD:
-                case RISCV_INS_SUB:
-                case RISCV_INS_SLL:
-                case RISCV_INS_SLT:
-                case RISCV_INS_SLTU:
-                case RISCV_INS_XOR:
-                case RISCV_INS_SRL:
-                case RISCV_INS_SRA:
-                case RISCV_INS_OR:
-                case RISCV_INS_AND:
-                    type = "R-type";
-                    break;
-
-                    // I-type instructions
-                case RISCV_INS_ADDI:
-                case RISCV_INS_SLTI:
-                case RISCV_INS_SLTIU:
-                case RISCV_INS_XORI:
-                case RISCV_INS_ORI:
-                case RISCV_INS_ANDI:
-                case RISCV_INS_SLLI:
-                case RISCV_INS_SRLI:
-                case RISCV_INS_SRAI:
-                case RISCV_INS_LB:
-                case RISCV_INS_LH:
-                case RISCV_INS_LW:
-                case RISCV_INS_LBU:
-                case RISCV_INS_LHU:
-                case RISCV_INS_JALR:
-                    type = "I-type";
-                    break;
-
-                    // S-type instructions
-                case RISCV_INS_SB:
-                case RISCV_INS_SH:
-                case RISCV_INS_SW:
-                    type = "S-type";
-                    break;
-
-                    // B-type instructions
-                case RISCV_INS_BEQ:
-                case RISCV_INS_BNE:
-                case RISCV_INS_BLT:
-                case RISCV_INS_BGE:
-                case RISCV_INS_BLTU:
-                case RISCV_INS_BGEU:
-                    type = "B-type";
-                    break;
-
-                    // U-type instructions
-                case RISCV_INS_LUI:
-                case RISCV_INS_AUIPC:
-                    type = "U-type";
-                    break;
-
-                    // J-type instructions
-                case RISCV_INS_JAL:
-                    type = "J-type";
-                    break;
-
-                default:
-                    type = "Other";
-                    break;
-                }
-
-                cs_free(insn, count);
-                return type;
-            }
-
-            return "INVALID";
+            return instruction_type_name(decode_cached(instruction));
         }
 
         bool is_initialized() const {
@@ -252,8 +165,8 @@ namespace utils
         }
     };
 
-    // 全局反汇编器实例
-    static RiscVDisassembler global_disassembler;
+    // 每个线程一个反汇编器实例：Capstone 句柄不能在线程间并发使用
+    static thread_local RiscVDisassembler global_disassembler;
 
     // C风格接口函数
     extern "C" {
@@ -264,16 +177,14 @@ namespace utils
 
         // 反汇编单条指令
         const char* disasm_instruction(uint32_t addr, uint32_t instruction) {
-            static std::string result;
+            static thread_local std::string result;
             result = global_disassembler.disassemble_instruction(addr, instruction);
             return result.c_str();
         }
 
         // 获取指令类型
         const char* disasm_get_type(uint32_t instruction) {
-            static std::string result;
-            result = global_disassembler.get_instruction_type(instruction);
-            return result.c_str();
+            return instruction_type_name(decode_cached(instruction));
         }
     }
 
@@ -293,7 +204,7 @@ namespace utils
             if (!result.operands.empty()) {
                 ss << " " << ANSI_FG_WHITE << result.operands << ANSI_RESET;
             }
-            ss << "\n│ " ANSI_FG_YELLOW "类型:" ANSI_RESET " " << global_disassembler.get_instruction_type(instruction) << "\n";
+            ss << "\n│ " ANSI_FG_YELLOW "类型:" ANSI_RESET " " << instruction_type_name(decode_cached(instruction)) << "\n";
             ss << "└────────────────────────────────────────┘";
             return ss.str();
         } else {
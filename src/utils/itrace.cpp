@@ -0,0 +1,355 @@
+// src/utils/itrace.cpp
+
+#include "AdaptSim/utils/itrace.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef ADAPTSIM_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef ADAPTSIM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace utils {
+
+    namespace {
+        constexpr uint8_t FLAG_PC_JUMP   = 1u << 0;
+        constexpr uint8_t FLAG_REG_WRITE = 1u << 1;
+
+        uint32_t zigzag(int32_t v) {
+            return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+        }
+
+        int32_t unzigzag(uint32_t v) {
+            return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+        }
+
+        uint8_t* put_varint(uint8_t* p, uint32_t v) {
+            while (v >= 0x80) {
+                *p++ = static_cast<uint8_t>(v | 0x80);
+                v >>= 7;
+            }
+            *p++ = static_cast<uint8_t>(v);
+            return p;
+        }
+
+        bool get_varint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+            v = 0;
+            for (int shift = 0; shift < 35 && p < end; shift += 7) {
+                const uint8_t b = *p++;
+                v |= static_cast<uint32_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 压缩失败或压缩后不更小时返回 0，调用方改为原样存储
+        size_t compress_block(InstTraceCodec codec, [[maybe_unused]] const uint8_t* src, [[maybe_unused]] size_t n,
+                              [[maybe_unused]] std::vector<uint8_t>& dst) {
+            switch (codec) {
+#ifdef ADAPTSIM_HAVE_LZ4
+            case InstTraceCodec::LZ4: {
+                dst.resize(LZ4_compressBound(static_cast<int>(n)));
+                int r = LZ4_compress_default(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst.data()),
+                                             static_cast<int>(n), static_cast<int>(dst.size()));
+                return r > 0 && static_cast<size_t>(r) < n ? static_cast<size_t>(r) : 0;
+            }
+#endif
+#ifdef ADAPTSIM_HAVE_ZSTD
+            case InstTraceCodec::Zstd: {
+                dst.resize(ZSTD_compressBound(n));
+                size_t r = ZSTD_compress(dst.data(), dst.size(), src, n, 1);
+                return !ZSTD_isError(r) && r < n ? r : 0;
+            }
+#endif
+            default:
+                return 0;
+            }
+        }
+
+        bool decompress_block(InstTraceCodec codec, const uint8_t* src, size_t n, uint8_t* dst, size_t raw_size) {
+            switch (codec) {
+            case InstTraceCodec::None:
+                if (n != raw_size) {
+                    return false;
+                }
+                std::memcpy(dst, src, n);
+                return true;
+#ifdef ADAPTSIM_HAVE_LZ4
+            case InstTraceCodec::LZ4:
+                return LZ4_decompress_safe(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+                                           static_cast<int>(n), static_cast<int>(raw_size)) == static_cast<int>(raw_size);
+#endif
+#ifdef ADAPTSIM_HAVE_ZSTD
+            case InstTraceCodec::Zstd:
+                return ZSTD_decompress(dst, raw_size, src, n) == raw_size;
+#endif
+            default:
+                std::cerr << "[InstTrace] Block uses codec " << static_cast<int>(codec)
+                          << " which this build does not support" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    InstTraceCodec parse_inst_trace_codec(const std::string& name) {
+        if (name == "lz4") return InstTraceCodec::LZ4;
+        if (name == "zstd") return InstTraceCodec::Zstd;
+        return InstTraceCodec::None;
+    }
+
+    bool inst_trace_codec_available(InstTraceCodec codec) {
+        switch (codec) {
+        case InstTraceCodec::None:
+            return true;
+        case InstTraceCodec::LZ4:
+#ifdef ADAPTSIM_HAVE_LZ4
+            return true;
+#else
+            return false;
+#endif
+        case InstTraceCodec::Zstd:
+#ifdef ADAPTSIM_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+    // ---------------- InstTraceWriter ----------------
+
+    InstTraceWriter::~InstTraceWriter() {
+        close();
+    }
+
+    bool InstTraceWriter::open(const std::string& path, InstTraceCodec c) {
+        close();
+        if (!inst_trace_codec_available(c)) {
+            std::cerr << "[InstTrace] Requested compression is not built in, writing uncompressed blocks" << std::endl;
+            c = InstTraceCodec::None;
+        }
+        out = std::fopen(path.c_str(), "wb");
+        if (!out) {
+            std::cerr << "[InstTrace] Cannot open trace file '" << path << "'" << std::endl;
+            return false;
+        }
+        InstTraceFileHeader hdr{};
+        std::memcpy(hdr.magic, ITRACE_MAGIC, sizeof(hdr.magic));
+        hdr.version = ITRACE_VERSION;
+        std::fwrite(&hdr, sizeof(hdr), 1, out);
+
+        codec = c;
+        block.resize(BLOCK_SIZE);
+        n_total = 0;
+        std::memset(arch_gpr, 0, sizeof(arch_gpr));
+        reset_block();
+        std::cout << "[InstTrace] Instruction trace enabled, output file: " << path << std::endl;
+        return true;
+    }
+
+    void InstTraceWriter::close() {
+        if (!out) {
+            return;
+        }
+        flush_block();
+        std::fclose(out);
+        out = nullptr;
+    }
+
+    void InstTraceWriter::reset_block() {
+        used = 0;
+        n_block = 0;
+        prev_pc = 0;
+        std::memset(delta_gpr, 0, sizeof(delta_gpr));
+    }
+
+    void InstTraceWriter::flush_block() {
+        if (n_block == 0) {
+            return;
+        }
+        InstTraceBlockHeader bh{};
+        bh.raw_size = static_cast<uint32_t>(used);
+        bh.n_records = n_block;
+        const size_t packed_size = compress_block(codec, block.data(), used, packed);
+        if (packed_size) {
+            bh.codec = static_cast<uint8_t>(codec);
+            bh.stored_size = static_cast<uint32_t>(packed_size);
+            std::fwrite(&bh, sizeof(bh), 1, out);
+            std::fwrite(packed.data(), 1, packed_size, out);
+        } else {
+            bh.codec = static_cast<uint8_t>(InstTraceCodec::None);
+            bh.stored_size = bh.raw_size;
+            std::fwrite(&bh, sizeof(bh), 1, out);
+            std::fwrite(block.data(), 1, used, out);
+        }
+        reset_block();
+    }
+
+    void InstTraceWriter::commit(uint32_t pc, uint32_t inst, const uint32_t* gpr) {
+        if (!out) {
+            return;
+        }
+        if (used + MAX_RECORD > BLOCK_SIZE) {
+            flush_block();
+        }
+
+        // RV32 每条指令至多写回一个寄存器；写回相同值的情况在日志中不可见
+        uint32_t rd = 0;
+        for (uint32_t i = 1; i < 32; ++i) {
+            if (gpr[i] != arch_gpr[i]) {
+                rd = i;
+                break;
+            }
+        }
+
+        uint8_t* p = block.data() + used;
+        uint8_t& flags = *p++;
+        flags = 0;
+        if (pc != prev_pc + 4) {
+            flags |= FLAG_PC_JUMP;
+            p = put_varint(p, zigzag(static_cast<int32_t>(pc - (prev_pc + 4))));
+        }
+        std::memcpy(p, &inst, sizeof(inst));
+        p += sizeof(inst);
+        if (rd) {
+            flags |= FLAG_REG_WRITE;
+            *p++ = static_cast<uint8_t>(rd);
+            p = put_varint(p, zigzag(static_cast<int32_t>(gpr[rd] - delta_gpr[rd])));
+            delta_gpr[rd] = gpr[rd];
+            arch_gpr[rd] = gpr[rd];
+        }
+
+        used = p - block.data();
+        prev_pc = pc;
+        ++n_block;
+        ++n_total;
+    }
+
+    void InstTraceWriter::sync(const uint32_t* gpr) {
+        std::memcpy(arch_gpr, gpr, sizeof(arch_gpr));
+    }
+
+    // ---------------- InstTraceReader ----------------
+
+    InstTraceReader::~InstTraceReader() {
+        if (in) {
+            std::fclose(in);
+        }
+    }
+
+    bool InstTraceReader::open(const std::string& path) {
+        in = std::fopen(path.c_str(), "rb");
+        if (!in) {
+            std::cerr << "[InstTrace] Cannot open trace file '" << path << "'" << std::endl;
+            return false;
+        }
+        InstTraceFileHeader hdr{};
+        if (std::fread(&hdr, sizeof(hdr), 1, in) != 1 ||
+            std::memcmp(hdr.magic, ITRACE_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != ITRACE_VERSION) {
+            std::cerr << "[InstTrace] '" << path << "' is not an instruction trace (version "
+                      << ITRACE_VERSION << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool InstTraceReader::load_block() {
+        InstTraceBlockHeader bh{};
+        if (std::fread(&bh, sizeof(bh), 1, in) != 1) {
+            return false;
+        }
+        packed.resize(bh.stored_size);
+        block.resize(bh.raw_size);
+        if (std::fread(packed.data(), 1, bh.stored_size, in) != bh.stored_size ||
+            !decompress_block(static_cast<InstTraceCodec>(bh.codec), packed.data(), bh.stored_size,
+                              block.data(), bh.raw_size)) {
+            std::cerr << "[InstTrace] Corrupt block at record " << next_index << std::endl;
+            return false;
+        }
+        pos = 0;
+        left_in_block = bh.n_records;
+        prev_pc = 0;
+        std::memset(delta_gpr, 0, sizeof(delta_gpr));
+        return true;
+    }
+
+    bool InstTraceReader::seek(uint64_t index) {
+        // 先丢弃当前块中剩余的记录，再按块头整块跳过
+        InstTraceEntry e{};
+        while (left_in_block > 0 && next_index < index) {
+            if (!next(e)) {
+                return false;
+            }
+        }
+        while (next_index < index) {
+            InstTraceBlockHeader bh{};
+            const long here = std::ftell(in);
+            if (std::fread(&bh, sizeof(bh), 1, in) != 1) {
+                return false;
+            }
+            if (next_index + bh.n_records > index) {
+                std::fseek(in, here, SEEK_SET);
+                if (!load_block()) {
+                    return false;
+                }
+                while (next_index < index) {
+                    if (!next(e)) {
+                        return false;
+                    }
+                }
+                break;
+            }
+            std::fseek(in, bh.stored_size, SEEK_CUR);
+            next_index += bh.n_records;
+        }
+        return true;
+    }
+
+    bool InstTraceReader::next(InstTraceEntry& entry) {
+        if (left_in_block == 0 && !load_block()) {
+            return false;
+        }
+        const uint8_t* p = block.data() + pos;
+        const uint8_t* end = block.data() + block.size();
+        if (p >= end) {
+            return false;
+        }
+
+        const uint8_t flags = *p++;
+        uint32_t pc = prev_pc + 4;
+        if (flags & FLAG_PC_JUMP) {
+            uint32_t v;
+            if (!get_varint(p, end, v)) return false;
+            pc += static_cast<uint32_t>(unzigzag(v));
+        }
+        if (end - p < 4) return false;
+        std::memcpy(&entry.inst, p, sizeof(entry.inst));
+        p += sizeof(entry.inst);
+
+        entry.rd = 0;
+        entry.rd_value = 0;
+        if (flags & FLAG_REG_WRITE) {
+            if (p >= end) return false;
+            const uint8_t rd = *p++ & 31;
+            uint32_t v;
+            if (!get_varint(p, end, v)) return false;
+            delta_gpr[rd] += static_cast<uint32_t>(unzigzag(v));
+            entry.rd = rd;
+            entry.rd_value = delta_gpr[rd];
+        }
+
+        entry.pc = pc;
+        entry.index = next_index++;
+        prev_pc = pc;
+        pos = p - block.data();
+        --left_in_block;
+        return true;
+    }
+
+} // namespace utils
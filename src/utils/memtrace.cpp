@@ -0,0 +1,123 @@
+// src/utils/memtrace.cpp
+
+#include "AdaptSim/utils/memtrace.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace utils {
+
+    namespace detail {
+        MemTrace mem_trace_instance;
+        thread_local MemTrace* bound_mem_trace = nullptr;
+    }
+
+    namespace {
+        bool write_header(std::FILE* f) {
+            MemTraceFileHeader hdr{};
+            std::memcpy(hdr.magic, MEMTRACE_MAGIC, sizeof(hdr.magic));
+            hdr.version = MEMTRACE_VERSION;
+            hdr.record_size = sizeof(MemTraceRecord);
+            return std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+        }
+    }
+
+    MemTrace::~MemTrace() {
+        close();
+    }
+
+    void MemTrace::start(size_t cap) {
+        close();
+        capacity = std::bit_ceil(cap < 2 ? size_t{2} : cap);
+        mask = capacity - 1;
+        ring = std::make_unique<MemTraceRecord[]>(capacity);
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        draining = false;
+        is_active = true;
+    }
+
+    bool MemTrace::open(const std::string& path, size_t cap) {
+        start(cap);
+        out = std::fopen(path.c_str(), "wb");
+        if (!out || !write_header(out)) {
+            std::cerr << "[MemTrace] Cannot open trace file '" << path << "'" << std::endl;
+            if (out) {
+                std::fclose(out);
+                out = nullptr;
+            }
+            is_active = false;
+            return false;
+        }
+        draining = true;
+        stop_flag.store(false, std::memory_order_relaxed);
+        writer = std::thread(&MemTrace::drain_loop, this);
+        std::cout << "[MemTrace] Memory trace enabled, output file: " << path << std::endl;
+        return true;
+    }
+
+    void MemTrace::close() {
+        is_active = false;
+        if (writer.joinable()) {
+            stop_flag.store(true, std::memory_order_release);
+            writer.join();
+        }
+        if (out) {
+            std::fclose(out);
+            out = nullptr;
+        }
+        draining = false;
+    }
+
+    bool MemTrace::write_range(std::FILE* f, uint64_t from, uint64_t to) const {
+        // 环形缓冲区中最多分两段连续写出
+        while (from < to) {
+            const size_t idx = from & mask;
+            const size_t n = std::min<uint64_t>(to - from, capacity - idx);
+            if (std::fwrite(&ring[idx], sizeof(MemTraceRecord), n, f) != n) {
+                return false;
+            }
+            from += n;
+        }
+        return true;
+    }
+
+    void MemTrace::drain_loop() {
+        for (;;) {
+            const bool stopping = stop_flag.load(std::memory_order_acquire);
+            const uint64_t h = head.load(std::memory_order_acquire);
+            const uint64_t t = tail.load(std::memory_order_relaxed);
+            if (h != t) {
+                if (!write_range(out, t, h)) {
+                    std::cerr << "[MemTrace] Write error, trace truncated" << std::endl;
+                }
+                tail.store(h, std::memory_order_release);
+            } else if (stopping) {
+                break;
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    bool MemTrace::dump(const std::string& path) const {
+        if (!ring) {
+            return false;
+        }
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) {
+            std::cerr << "[MemTrace] Cannot open dump file '" << path << "'" << std::endl;
+            return false;
+        }
+        const uint64_t h = head.load(std::memory_order_acquire);
+        const uint64_t from = h > capacity ? h - capacity : 0;
+        const bool ok = write_header(f) && write_range(f, from, h);
+        std::fclose(f);
+        return ok;
+    }
+
+} // namespace utils
@@ -0,0 +1,300 @@
+// src/utils/profiler.cpp
+
+#include "AdaptSim/utils/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+
+namespace utils {
+
+    // ---- SymbolTable ----
+
+    bool SymbolTable::load_elf(const std::string& path) {
+        symbols.clear();
+        std::ifstream f(path, std::ios::binary);
+        const std::vector<char> file{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+        Elf32_Ehdr ehdr{};
+        if (file.size() < sizeof(ehdr)) {
+            return false;
+        }
+        std::memcpy(&ehdr, file.data(), sizeof(ehdr));
+        if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 || ehdr.e_ident[EI_CLASS] != ELFCLASS32 ||
+            ehdr.e_shentsize != sizeof(Elf32_Shdr) ||
+            ehdr.e_shoff + static_cast<uint64_t>(ehdr.e_shnum) * sizeof(Elf32_Shdr) > file.size()) {
+            return false;
+        }
+        auto section = [&](uint32_t i) {
+            Elf32_Shdr shdr{};
+            std::memcpy(&shdr, file.data() + ehdr.e_shoff + i * sizeof(Elf32_Shdr), sizeof(shdr));
+            return shdr;
+        };
+
+        for (uint32_t i = 0; i < ehdr.e_shnum; ++i) {
+            const Elf32_Shdr symtab = section(i);
+            if (symtab.sh_type != SHT_SYMTAB || symtab.sh_link >= ehdr.e_shnum ||
+                static_cast<uint64_t>(symtab.sh_offset) + symtab.sh_size > file.size()) {
+                continue;
+            }
+            const Elf32_Shdr strtab = section(symtab.sh_link);
+            if (static_cast<uint64_t>(strtab.sh_offset) + strtab.sh_size > file.size()) {
+                continue;
+            }
+            for (uint32_t off = 0; off + sizeof(Elf32_Sym) <= symtab.sh_size; off += sizeof(Elf32_Sym)) {
+                Elf32_Sym sym{};
+                std::memcpy(&sym, file.data() + symtab.sh_offset + off, sizeof(sym));
+                const unsigned type = ELF32_ST_TYPE(sym.st_info);
+                if ((type != STT_FUNC && type != STT_NOTYPE) || sym.st_shndx == SHN_UNDEF ||
+                    sym.st_shndx >= SHN_LORESERVE || sym.st_name >= strtab.sh_size) {
+                    continue;
+                }
+                const char* name = file.data() + strtab.sh_offset + sym.st_name;
+                // 无类型的局部标签多为汇编里的跳转目标（.L 开头或 $x 映射符号），不作为函数
+                if (!*name || name[0] == '.' || name[0] == '$' || (type == STT_NOTYPE && sym.st_size == 0 &&
+                                                                    ELF32_ST_BIND(sym.st_info) == STB_LOCAL)) {
+                    continue;
+                }
+                symbols.push_back({sym.st_value, sym.st_size,
+                                   std::string(name, strnlen(name, strtab.sh_size - sym.st_name))});
+            }
+        }
+        // 同一地址有多个符号时保留有大小的那个（通常是函数本身而非别名标签）
+        std::stable_sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) {
+            return a.addr != b.addr ? a.addr < b.addr : a.size > b.size;
+        });
+        symbols.erase(std::unique(symbols.begin(), symbols.end(),
+                                  [](const Symbol& a, const Symbol& b) { return a.addr == b.addr; }),
+                      symbols.end());
+        return !symbols.empty();
+    }
+
+    const char* SymbolTable::lookup(uint32_t addr, uint32_t* offset) const {
+        auto it = std::upper_bound(symbols.begin(), symbols.end(), addr,
+                                   [](uint32_t a, const Symbol& s) { return a < s.addr; });
+        if (it == symbols.begin()) {
+            return nullptr;
+        }
+        --it;
+        if (it->size && addr - it->addr >= it->size) {
+            return nullptr;
+        }
+        if (offset) {
+            *offset = addr - it->addr;
+        }
+        return it->name.c_str();
+    }
+
+    std::string SymbolTable::name(uint32_t addr) const {
+        if (const char* sym = lookup(addr)) {
+            return sym;
+        }
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "0x%08x", addr);
+        return buf;
+    }
+
+    // ---- CounterMap ----
+
+    CounterMap::CounterMap(unsigned log2_capacity)
+        : slots(size_t{1} << log2_capacity, Entry{EMPTY, 0, 0, 0}), mask(slots.size() - 1) {}
+
+    void CounterMap::clear() {
+        std::fill(slots.begin(), slots.end(), Entry{EMPTY, 0, 0, 0});
+        used = 0;
+    }
+
+    void CounterMap::grow() {
+        std::vector<Entry> old(slots.size() * 2, Entry{EMPTY, 0, 0, 0});
+        old.swap(slots);
+        mask = slots.size() - 1;
+        for (const Entry& e : old) {
+            if (e.key == EMPTY) {
+                continue;
+            }
+            size_t i = hash(e.key) & mask;
+            while (slots[i].key != EMPTY) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = e;
+        }
+    }
+
+    // ---- Profiler ----
+
+    Profiler::Profiler(Options opt) : opt(std::move(opt)), blocks(10), interval(10) {
+        nodes.push_back({0, CounterMap::EMPTY});
+        stack_weight.push_back(0);
+        next_sample = this->opt.sample_cycles;
+        if (this->opt.bbv_interval) {
+            const std::string path = this->opt.output + ".bbv";
+            bbv = std::fopen(path.c_str(), "w");
+            if (!bbv) {
+                std::cerr << "Profiler: cannot write " << path << std::endl;
+            }
+        }
+    }
+
+    Profiler::~Profiler() {
+        if (bbv) {
+            std::fclose(bbv);
+        }
+    }
+
+    void Profiler::end_block() {
+        CounterMap::Entry& b = blocks[block_start];
+        if (b.tag == 0) {
+            b.tag = ++n_blocks; // SimPoint 的块号从 1 开始
+            if (nodes[0].frame == CounterMap::EMPTY) {
+                nodes[0].frame = block_start; // 第一个块的入口作为调用树的根
+            }
+        }
+        b.count++;
+        b.weight += block_len;
+        if (bbv) {
+            interval[b.tag].count += block_len;
+            interval_insts += block_len;
+            if (interval_insts >= opt.bbv_interval) {
+                flush_interval();
+            }
+        }
+        block_len = 0;
+    }
+
+    void Profiler::flush_interval() {
+        if (interval_insts == 0) {
+            return;
+        }
+        std::fputc('T', bbv);
+        interval.for_each([&](const CounterMap::Entry& e) {
+            std::fprintf(bbv, ":%u:%llu ", e.key, static_cast<unsigned long long>(e.count));
+        });
+        std::fputc('\n', bbv);
+        interval.clear();
+        interval_insts = 0;
+    }
+
+    void Profiler::track_call(const DecodedInst& d) {
+        const auto is_link = [](uint8_t r) { return r == 1 || r == 5; };
+        if (is_link(d.rd)) {
+            pending_call = true;
+        } else if (d.op == RvOp::JALR && d.rd == 0 && is_link(d.rs1)) {
+            cur_node = nodes[cur_node].parent; // 根的父节点是它自己
+        }
+    }
+
+    void Profiler::enter_call(uint32_t target) {
+        pending_call = false;
+        const uint64_t key = (uint64_t{cur_node} << 32) | target;
+        auto [it, inserted] = children.try_emplace(key, static_cast<uint32_t>(nodes.size()));
+        if (inserted) {
+            nodes.push_back({cur_node, target});
+            stack_weight.push_back(0);
+        }
+        cur_node = it->second;
+    }
+
+    bool Profiler::write(const SymbolTable& syms) {
+        if (block_len) {
+            end_block();
+        }
+        if (bbv) {
+            flush_interval();
+            std::fflush(bbv);
+        }
+        const auto u = [](uint64_t v) { return static_cast<unsigned long long>(v); };
+        bool ok = true;
+
+        // flat：按函数汇总
+        {
+            struct Row {
+                uint64_t samples = 0;
+                uint64_t cycles = 0;
+            };
+            std::map<std::string, Row> by_sym;
+            uint64_t total = 0;
+            pcs.for_each([&](const CounterMap::Entry& e) {
+                Row& r = by_sym[syms.name(e.key)];
+                r.samples += e.count;
+                r.cycles += e.weight;
+                total += e.weight;
+            });
+            std::vector<std::pair<std::string, Row>> rows(by_sym.begin(), by_sym.end());
+            std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) { return a.second.cycles > b.second.cycles; });
+            const std::string path = opt.output + ".flat";
+            std::FILE* f = std::fopen(path.c_str(), "w");
+            ok = ok && f;
+            if (f) {
+                std::fprintf(f, "%8s %8s %14s %14s  %s\n", "%cycles", "cum%", "cycles",
+                             opt.sample_cycles ? "samples" : "insts", "symbol");
+                uint64_t cum = 0;
+                for (const auto& [name, r] : rows) {
+                    cum += r.cycles;
+                    std::fprintf(f, "%8.2f %8.2f %14llu %14llu  %s\n", total ? 100.0 * r.cycles / total : 0.0,
+                                 total ? 100.0 * cum / total : 0.0, u(r.cycles), u(r.samples), name.c_str());
+                }
+                ok = std::fclose(f) == 0 && ok;
+            }
+        }
+
+        // folded：每个调用树节点一行 "根;...;叶 周期数"，可直接交给 flamegraph.pl
+        {
+            const std::string path = opt.output + ".folded";
+            std::FILE* f = std::fopen(path.c_str(), "w");
+            ok = ok && f;
+            if (f) {
+                std::vector<std::string> frames;
+                for (uint32_t n = 0; n < nodes.size(); n++) {
+                    if (!stack_weight[n]) {
+                        continue;
+                    }
+                    frames.clear();
+                    for (uint32_t i = n;; i = nodes[i].parent) {
+                        frames.push_back(nodes[i].frame == CounterMap::EMPTY ? "root" : syms.name(nodes[i].frame));
+                        if (i == 0) {
+                            break;
+                        }
+                    }
+                    for (size_t i = frames.size(); i-- > 0;) {
+                        std::fprintf(f, "%s%s", frames[i].c_str(), i ? ";" : "");
+                    }
+                    std::fprintf(f, " %llu\n", u(stack_weight[n]));
+                }
+                ok = std::fclose(f) == 0 && ok;
+            }
+        }
+
+        // bb：基本块执行次数，按指令数降序；块号与 .bbv 中一致
+        {
+            std::vector<CounterMap::Entry> bbs;
+            blocks.for_each([&](const CounterMap::Entry& e) { bbs.push_back(e); });
+            std::sort(bbs.begin(), bbs.end(), [](const auto& a, const auto& b) { return a.weight > b.weight; });
+            const std::string path = opt.output + ".bb";
+            std::FILE* f = std::fopen(path.c_str(), "w");
+            ok = ok && f;
+            if (f) {
+                std::fprintf(f, "%8s %10s %6s %14s %14s  %s\n", "id", "start", "len", "execs", "insts", "symbol");
+                for (const CounterMap::Entry& e : bbs) {
+                    uint32_t off = 0;
+                    const char* sym = syms.lookup(e.key, &off);
+                    std::fprintf(f, "%8u 0x%08x %6llu %14llu %14llu  ", e.tag, e.key, u(e.count ? e.weight / e.count : 0),
+                                 u(e.count), u(e.weight));
+                    if (sym) {
+                        std::fprintf(f, "%s+0x%x\n", sym, off);
+                    } else {
+                        std::fprintf(f, "?\n");
+                    }
+                }
+                ok = std::fclose(f) == 0 && ok;
+            }
+        }
+        if (!ok) {
+            std::cerr << "Profiler: failed writing " << opt.output << ".*" << std::endl;
+        }
+        return ok;
+    }
+
+} // namespace utils
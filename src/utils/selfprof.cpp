@@ -0,0 +1,143 @@
+// src/utils/selfprof.cpp
+
+#include "AdaptSim/utils/selfprof.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils::selfprof {
+
+    namespace {
+        using clock = std::chrono::steady_clock;
+
+        struct Registry {
+            std::mutex m;
+            std::vector<std::unique_ptr<ThreadStats>> threads;
+            // 时间戳与 steady_clock 的对照点，汇总时据此把计数换算成纳秒
+            const uint64_t tsc0 = now();
+            const clock::time_point t0 = clock::now();
+
+            ~Registry() {
+                if (!threads.empty()) {
+                    report();
+                }
+            }
+        };
+
+        Registry& registry() {
+            static Registry r;
+            return r;
+        }
+
+        std::string format_hms(double seconds) {
+            const uint64_t s = static_cast<uint64_t>(std::max(seconds, 0.0));
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%02llu:%02llu:%02llu", static_cast<unsigned long long>(s / 3600),
+                          static_cast<unsigned long long>(s / 60 % 60), static_cast<unsigned long long>(s % 60));
+            return buf;
+        }
+    }
+
+    const char* section_name(Section s) {
+        switch (s) {
+            case Section::Eval: return "eval";
+            case Section::MemRead: return "dpi_mem_read";
+            case Section::MemWrite: return "dpi_mem_write";
+            case Section::Wave: return "wave_dump";
+            case Section::ITrace: return "itrace";
+            case Section::Difftest: return "difftest";
+            case Section::COUNT: break;
+        }
+        return "unknown";
+    }
+
+    ThreadStats& thread_stats() {
+        thread_local ThreadStats* mine = nullptr;
+        if (!mine) [[unlikely]] {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.m);
+            r.threads.push_back(std::make_unique<ThreadStats>());
+            mine = r.threads.back().get();
+            mine->id = static_cast<unsigned>(r.threads.size() - 1);
+        }
+        return *mine;
+    }
+
+    void report(std::FILE* out) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.m);
+        const double wall_ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - r.t0).count());
+        const uint64_t ticks = now() - r.tsc0;
+        const double ns_per_tick = ticks ? wall_ns / static_cast<double>(ticks) : 1.0;
+
+        constexpr size_t N = static_cast<size_t>(Section::COUNT);
+        uint64_t sum_ticks[N] = {};
+        uint64_t sum_calls[N] = {};
+        std::fprintf(out, "[selfprof] wall %.3f s, %zu thread(s)\n", wall_ns / 1e9, r.threads.size());
+        std::fprintf(out, "%8s  %-14s %14s %12s %8s %10s\n", "thread", "section", "calls", "ms", "%wall", "ns/call");
+        auto row = [&](const char* thread, Section s, uint64_t t, uint64_t c) {
+            const double ns = static_cast<double>(t) * ns_per_tick;
+            std::fprintf(out, "%8s  %-14s %14llu %12.3f %8.2f %10.1f\n", thread, section_name(s),
+                         static_cast<unsigned long long>(c), ns / 1e6, wall_ns > 0 ? 100.0 * ns / wall_ns : 0.0,
+                         c ? ns / static_cast<double>(c) : 0.0);
+        };
+        for (const auto& th : r.threads) {
+            char id[16];
+            std::snprintf(id, sizeof(id), "%u", th->id);
+            for (size_t i = 0; i < N; i++) {
+                const uint64_t t = th->ticks[i].load(std::memory_order_relaxed);
+                const uint64_t c = th->calls[i].load(std::memory_order_relaxed);
+                sum_ticks[i] += t;
+                sum_calls[i] += c;
+                if (c) {
+                    row(id, static_cast<Section>(i), t, c);
+                }
+            }
+        }
+        if (r.threads.size() > 1) {
+            for (size_t i = 0; i < N; i++) {
+                if (sum_calls[i]) {
+                    row("all", static_cast<Section>(i), sum_ticks[i], sum_calls[i]);
+                }
+            }
+        }
+        std::fflush(out);
+    }
+
+    Progress::Progress(uint64_t insts, uint64_t cycles, uint64_t budget, uint32_t interval_ms)
+        : begin(clock::now()), last(begin), insts0(insts), cycles0(cycles), last_insts(insts), last_cycles(cycles),
+          budget(budget), interval(std::chrono::milliseconds(interval_ms)),
+          next_check(interval_ms ? insts + check_stride : UINT64_MAX) {}
+
+    void Progress::check(uint64_t insts, uint64_t cycles) {
+        const clock::time_point t = clock::now();
+        next_check = insts + check_stride;
+        if (t - last < interval) {
+            return;
+        }
+        const double dt = std::chrono::duration<double>(t - last).count();
+        const double khz = static_cast<double>(cycles - last_cycles) / dt / 1e3;
+        const double mips = static_cast<double>(insts - last_insts) / dt / 1e6;
+        const uint64_t done = insts - insts0;
+        std::fprintf(stderr, "[selfprof] %llu insts, %llu cycles, %.1f KHz, %.3f MIPS",
+                     static_cast<unsigned long long>(done), static_cast<unsigned long long>(cycles - cycles0), khz,
+                     mips);
+        if (budget && done < budget) {
+            // 按整个运行的平均速度估算，比只看最近一段稳定
+            const double rate = static_cast<double>(done) / std::chrono::duration<double>(t - begin).count();
+            std::fprintf(stderr, ", ETA %s", format_hms(static_cast<double>(budget - done) / rate).c_str());
+        }
+        std::fputc('\n', stderr);
+        // 一个间隔内大约读 16 次时钟
+        check_stride = std::max<uint64_t>(1024, (insts - last_insts) / 16);
+        next_check = insts + check_stride;
+        last = t;
+        last_insts = insts;
+        last_cycles = cycles;
+    }
+
+} // namespace utils::selfprof
@@ -0,0 +1,733 @@
+// src/utils/waveindex.cpp
+
+#include "AdaptSim/utils/waveindex.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fnmatch.h>
+#include <iostream>
+#include <string_view>
+#include <sys/stat.h>
+#include <unordered_map>
+
+namespace utils {
+
+    namespace {
+        constexpr size_t READ_CHUNK = 1u << 20;
+        constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+        // 以空白分隔的词法读取器，记录每个词在文件中的偏移
+        class VcdReader {
+        public:
+            VcdReader() = default;
+            ~VcdReader() {
+                if (f) {
+                    std::fclose(f);
+                }
+            }
+
+            VcdReader(const VcdReader&) = delete;
+            VcdReader& operator=(const VcdReader&) = delete;
+
+            bool open(const std::string& path) {
+                f = std::fopen(path.c_str(), "rb");
+                buf.resize(READ_CHUNK);
+                return f != nullptr;
+            }
+
+            bool seek(uint64_t off) {
+                pos = len = 0;
+                base = off;
+                eof = false;
+                return fseeko(f, static_cast<off_t>(off), SEEK_SET) == 0;
+            }
+
+            // 返回的词在下一次调用前有效
+            bool next(std::string_view& tok, uint64_t& off) {
+                while (true) {
+                    while (pos < len && is_space(buf[pos])) {
+                        pos++;
+                    }
+                    if (pos < len) {
+                        break;
+                    }
+                    if (!fill()) {
+                        return false;
+                    }
+                }
+                size_t end = pos;
+                while (true) {
+                    while (end < len && !is_space(buf[end])) {
+                        end++;
+                    }
+                    if (end < len) {
+                        break;
+                    }
+                    // 词跨过了缓冲区末尾：fill 会把它挪到缓冲区开头
+                    const size_t done = end - pos;
+                    const bool more = fill();
+                    end = pos + done;
+                    if (!more) {
+                        break;
+                    }
+                }
+                tok = std::string_view(buf.data() + pos, end - pos);
+                off = base + pos;
+                pos = end;
+                return true;
+            }
+
+            uint64_t tell() const { return base + pos; }
+
+        private:
+            static bool is_space(char c) {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+            }
+
+            // 丢掉已读的内容再读入一块；一个词占满整个缓冲区时扩容
+            bool fill() {
+                if (eof) {
+                    return false;
+                }
+                if (pos > 0) {
+                    std::memmove(buf.data(), buf.data() + pos, len - pos);
+                    len -= pos;
+                    base += pos;
+                    pos = 0;
+                }
+                if (len == buf.size()) {
+                    buf.resize(buf.size() * 2);
+                }
+                const size_t n = std::fread(buf.data() + len, 1, buf.size() - len, f);
+                if (n == 0) {
+                    eof = true;
+                    return false;
+                }
+                len += n;
+                return true;
+            }
+
+            std::FILE* f = nullptr;
+            std::vector<char> buf;
+            size_t pos = 0;
+            size_t len = 0;
+            uint64_t base = 0; // buf[0] 在文件中的偏移
+            bool eof = false;
+        };
+
+        bool skip_to_end(VcdReader& r) {
+            std::string_view tok;
+            uint64_t off;
+            while (r.next(tok, off)) {
+                if (tok == "$end") {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 正文中的一个时间戳或值变化
+        struct VcdEvent {
+            bool is_time;
+            uint64_t time;
+            uint64_t offset;   // 时间戳的偏移
+            std::string value; // 标量为单个字符，向量/实数保留 b/r 前缀
+            std::string id;
+        };
+
+        bool next_event(VcdReader& r, VcdEvent& ev) {
+            std::string_view tok;
+            uint64_t off;
+            while (r.next(tok, off)) {
+                switch (tok[0]) {
+                case '#':
+                    ev.is_time = true;
+                    ev.time = 0;
+                    std::from_chars(tok.data() + 1, tok.data() + tok.size(), ev.time);
+                    ev.offset = off;
+                    return true;
+                case '$':
+                    // $dumpvars 等只是把值变化括起来；其余（$comment 等）连同内容一起跳过
+                    if (tok != "$dumpvars" && tok != "$dumpall" && tok != "$dumpon" && tok != "$dumpoff" &&
+                        tok != "$end" && !skip_to_end(r)) {
+                        return false;
+                    }
+                    continue;
+                case 'b': case 'B': case 'r': case 'R': case 's': case 'S':
+                    ev.value.assign(tok);
+                    if (!r.next(tok, off)) {
+                        return false;
+                    }
+                    ev.is_time = false;
+                    ev.id.assign(tok);
+                    return true;
+                default:
+                    if (tok.size() < 2) {
+                        continue;
+                    }
+                    ev.is_time = false;
+                    ev.value.assign(1, tok[0]);
+                    ev.id.assign(tok.substr(1));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // VCD 标识符到值槽位；常见的短标识符按数值查表，避免逐个变化做哈希
+        class SlotMap {
+        public:
+            void add(const std::string& id, uint32_t slot) {
+                const uint64_t n = number(id);
+                if (n < DENSE_LIMIT) {
+                    if (n >= dense.size()) {
+                        dense.resize(n + 1, NO_SLOT);
+                    }
+                    dense[n] = slot;
+                } else {
+                    sparse.emplace(id, slot);
+                }
+            }
+
+            uint32_t find(const std::string& id) const {
+                const uint64_t n = number(id);
+                if (n < DENSE_LIMIT) {
+                    return n < dense.size() ? dense[n] : NO_SLOT;
+                }
+                auto it = sparse.find(id);
+                return it == sparse.end() ? NO_SLOT : it->second;
+            }
+
+        private:
+            static constexpr uint64_t DENSE_LIMIT = 1u << 20;
+
+            // 标识符由 '!'..'~' 组成，按 95 进制（每位 1..94）编号，不同长度也不会冲突
+            static uint64_t number(const std::string& id) {
+                uint64_t n = 0;
+                for (char c : id) {
+                    n = n * 95 + static_cast<uint8_t>(c - 32);
+                    if (n >= DENSE_LIMIT) {
+                        return UINT64_MAX;
+                    }
+                }
+                return n;
+            }
+
+            std::vector<uint32_t> dense;
+            std::unordered_map<std::string, uint32_t> sparse;
+        };
+
+        bool word(VcdReader& r, std::string& out) {
+            std::string_view tok;
+            uint64_t off;
+            if (!r.next(tok, off)) {
+                return false;
+            }
+            out.assign(tok);
+            return true;
+        }
+
+        struct VcdHeader {
+            std::vector<WaveSignal> sigs;
+            uint32_t n_slots = 0;
+            std::string timescale;
+            uint64_t body_offset = 0;
+        };
+
+        bool parse_header(VcdReader& r, VcdHeader& h) {
+            std::vector<std::string> scope;
+            std::unordered_map<std::string, uint32_t> slot_of;
+            std::string_view tok;
+            uint64_t off;
+            while (r.next(tok, off)) {
+                if (tok == "$scope") {
+                    std::string type, name;
+                    if (!word(r, type) || !word(r, name) || !skip_to_end(r)) {
+                        return false;
+                    }
+                    scope.push_back(name);
+                } else if (tok == "$upscope") {
+                    if (!scope.empty()) {
+                        scope.pop_back();
+                    }
+                    if (!skip_to_end(r)) {
+                        return false;
+                    }
+                } else if (tok == "$var") {
+                    WaveSignal s;
+                    std::string width, name;
+                    if (!word(r, s.type) || !word(r, width) || !word(r, s.id) || !word(r, name)) {
+                        return false;
+                    }
+                    while (r.next(tok, off) && tok != "$end") {
+                        s.range.append(tok);
+                    }
+                    s.width = static_cast<uint32_t>(std::strtoul(width.c_str(), nullptr, 10));
+                    for (const std::string& sc : scope) {
+                        s.name += sc;
+                        s.name += '.';
+                    }
+                    s.name += name;
+                    auto [it, added] = slot_of.emplace(s.id, h.n_slots);
+                    if (added) {
+                        h.n_slots++;
+                    }
+                    s.slot = it->second;
+                    h.sigs.push_back(std::move(s));
+                } else if (tok == "$timescale") {
+                    while (r.next(tok, off) && tok != "$end") {
+                        h.timescale.append(tok);
+                    }
+                } else if (tok == "$enddefinitions") {
+                    if (!skip_to_end(r)) {
+                        return false;
+                    }
+                    h.body_offset = r.tell();
+                    return true;
+                } else if (tok[0] == '$') {
+                    if (!skip_to_end(r)) {
+                        return false;
+                    }
+                }
+            }
+            return false;
+        }
+
+        bool vcd_stat(const std::string& path, uint64_t& size, int64_t& mtime) {
+            struct stat st{};
+            if (stat(path.c_str(), &st) != 0) {
+                return false;
+            }
+            size = static_cast<uint64_t>(st.st_size);
+            mtime = static_cast<int64_t>(st.st_mtime);
+            return true;
+        }
+
+        void put_u32(std::FILE* f, uint32_t v) {
+            std::fwrite(&v, sizeof(v), 1, f);
+        }
+
+        void put_str(std::FILE* f, const std::string& s) {
+            const uint16_t n = static_cast<uint16_t>(std::min<size_t>(s.size(), UINT16_MAX));
+            std::fwrite(&n, sizeof(n), 1, f);
+            std::fwrite(s.data(), 1, n, f);
+        }
+
+        bool get_u32(std::FILE* f, uint32_t& v) {
+            return std::fread(&v, sizeof(v), 1, f) == 1;
+        }
+
+        bool get_str(std::FILE* f, std::string& s) {
+            uint16_t n;
+            if (std::fread(&n, sizeof(n), 1, f) != 1) {
+                return false;
+            }
+            s.resize(n);
+            return std::fread(s.data(), 1, n, f) == n;
+        }
+
+        void put_change(std::FILE* out, const std::string& value, const std::string& id) {
+            std::fputs(value.c_str(), out);
+            if (value.size() > 1) {
+                std::fputc(' ', out);
+            }
+            std::fputs(id.c_str(), out);
+            std::fputc('\n', out);
+        }
+
+        bool copy_range(std::FILE* in, uint64_t from, uint64_t to, std::FILE* out) {
+            if (fseeko(in, static_cast<off_t>(from), SEEK_SET) != 0) {
+                return false;
+            }
+            std::vector<char> buf(READ_CHUNK);
+            while (from < to) {
+                const size_t want = static_cast<size_t>(std::min<uint64_t>(buf.size(), to - from));
+                const size_t n = std::fread(buf.data(), 1, want, in);
+                if (n == 0 || std::fwrite(buf.data(), 1, n, out) != n) {
+                    return false;
+                }
+                from += n;
+            }
+            return true;
+        }
+
+        std::vector<std::string> split_name(const std::string& name) {
+            std::vector<std::string> parts;
+            size_t start = 0;
+            for (size_t dot; (dot = name.find('.', start)) != std::string::npos; start = dot + 1) {
+                parts.push_back(name.substr(start, dot - start));
+            }
+            parts.push_back(name.substr(start));
+            return parts;
+        }
+
+    } // namespace
+
+    std::string wave_index_path(const std::string& vcd) {
+        return vcd + ".widx";
+    }
+
+    bool build_wave_index(const std::string& vcd, const std::string& idx_path, const WaveIndexOptions& opts) {
+        WaveIndexHeader hdr{};
+        VcdReader r;
+        if (!vcd_stat(vcd, hdr.vcd_size, hdr.vcd_mtime) || !r.open(vcd)) {
+            std::cerr << "[WaveIndex] Cannot open '" << vcd << "'" << std::endl;
+            return false;
+        }
+        VcdHeader h;
+        if (!parse_header(r, h)) {
+            std::cerr << "[WaveIndex] '" << vcd << "' is not a VCD file" << std::endl;
+            return false;
+        }
+        std::FILE* out = std::fopen(idx_path.c_str(), "wb");
+        if (!out) {
+            std::cerr << "[WaveIndex] Cannot write '" << idx_path << "'" << std::endl;
+            return false;
+        }
+        std::memcpy(hdr.magic, WAVEIDX_MAGIC, sizeof(hdr.magic));
+        hdr.version = WAVEIDX_VERSION;
+        hdr.n_slots = h.n_slots;
+        hdr.body_offset = h.body_offset;
+        hdr.n_signals = static_cast<uint32_t>(h.sigs.size());
+        std::strncpy(hdr.timescale, h.timescale.c_str(), sizeof(hdr.timescale) - 1);
+        std::fwrite(&hdr, sizeof(hdr), 1, out); // 占位，最后回填
+
+        SlotMap slots;
+        for (const WaveSignal& s : h.sigs) {
+            slots.add(s.id, s.slot);
+        }
+        std::vector<std::string> values(h.n_slots);
+        std::vector<WaveCheckpoint> ckpts;
+        std::vector<WaveMarker> markers;
+        auto checkpoint = [&](uint64_t time, uint64_t offset) {
+            ckpts.push_back({time, offset, static_cast<uint64_t>(ftello(out))});
+            for (const std::string& v : values) {
+                put_u32(out, static_cast<uint32_t>(v.size()));
+                std::fwrite(v.data(), 1, v.size(), out);
+            }
+        };
+        checkpoint(0, h.body_offset);
+        markers.push_back({0, h.body_offset});
+
+        VcdEvent ev;
+        while (next_event(r, ev)) {
+            if (ev.is_time) {
+                hdr.end_time = ev.time;
+                if (ev.offset - ckpts.back().offset >= opts.checkpoint_bytes) {
+                    checkpoint(ev.time, ev.offset);
+                }
+                if (ev.offset - markers.back().offset >= opts.marker_bytes) {
+                    markers.push_back({ev.time, ev.offset});
+                }
+            } else if (const uint32_t slot = slots.find(ev.id); slot != NO_SLOT) {
+                values[slot] = ev.value;
+            }
+        }
+
+        hdr.signals_offset = static_cast<uint64_t>(ftello(out));
+        for (const WaveSignal& s : h.sigs) {
+            put_u32(out, s.slot);
+            put_u32(out, s.width);
+            put_str(out, s.id);
+            put_str(out, s.name);
+            put_str(out, s.range);
+            put_str(out, s.type);
+        }
+        hdr.checkpoints_offset = static_cast<uint64_t>(ftello(out));
+        hdr.n_checkpoints = static_cast<uint32_t>(ckpts.size());
+        std::fwrite(ckpts.data(), sizeof(WaveCheckpoint), ckpts.size(), out);
+        hdr.markers_offset = static_cast<uint64_t>(ftello(out));
+        hdr.n_markers = markers.size();
+        std::fwrite(markers.data(), sizeof(WaveMarker), markers.size(), out);
+        std::rewind(out);
+        std::fwrite(&hdr, sizeof(hdr), 1, out);
+        const bool ok = !std::ferror(out);
+        if (std::fclose(out) != 0 || !ok) {
+            std::cerr << "[WaveIndex] Write error on '" << idx_path << "'" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    class WaveIndex::Scanner {
+    public:
+        VcdReader reader;
+        SlotMap slots;
+        std::vector<std::string> values;
+    };
+
+    WaveIndex::~WaveIndex() {
+        if (idx) {
+            std::fclose(idx);
+        }
+    }
+
+    bool WaveIndex::open(const std::string& vcd, const std::string& idx_path) {
+        vcd_path = vcd;
+        is_stale = false;
+        idx = std::fopen(idx_path.c_str(), "rb");
+        if (!idx) {
+            return false;
+        }
+        if (std::fread(&hdr, sizeof(hdr), 1, idx) != 1 ||
+            std::memcmp(hdr.magic, WAVEIDX_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != WAVEIDX_VERSION) {
+            std::cerr << "[WaveIndex] '" << idx_path << "' is not a wave index (version "
+                      << WAVEIDX_VERSION << ")" << std::endl;
+            return false;
+        }
+        uint64_t size;
+        int64_t mtime;
+        if (!vcd_stat(vcd, size, mtime) || size != hdr.vcd_size || mtime != hdr.vcd_mtime) {
+            is_stale = true;
+            return false;
+        }
+
+        sigs.resize(hdr.n_signals);
+        bool ok = fseeko(idx, static_cast<off_t>(hdr.signals_offset), SEEK_SET) == 0;
+        for (WaveSignal& s : sigs) {
+            ok = ok && get_u32(idx, s.slot) && get_u32(idx, s.width) && get_str(idx, s.id) &&
+                 get_str(idx, s.name) && get_str(idx, s.range) && get_str(idx, s.type);
+        }
+        ckpts.resize(hdr.n_checkpoints);
+        markers.resize(hdr.n_markers);
+        ok = ok && fseeko(idx, static_cast<off_t>(hdr.checkpoints_offset), SEEK_SET) == 0 &&
+             std::fread(ckpts.data(), sizeof(WaveCheckpoint), ckpts.size(), idx) == ckpts.size() &&
+             fseeko(idx, static_cast<off_t>(hdr.markers_offset), SEEK_SET) == 0 &&
+             std::fread(markers.data(), sizeof(WaveMarker), markers.size(), idx) == markers.size();
+        if (!ok || ckpts.empty()) {
+            std::cerr << "[WaveIndex] Corrupt index '" << idx_path << "'" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<size_t> WaveIndex::find(const std::string& pattern) const {
+        const bool glob = pattern.find_first_of("*?[") != std::string::npos;
+        const std::string suffix = "." + pattern;
+        std::vector<size_t> out;
+        for (size_t i = 0; i < sigs.size(); i++) {
+            const std::string& n = sigs[i].name;
+            const bool hit = glob ? fnmatch(pattern.c_str(), n.c_str(), 0) == 0
+                                  : n == pattern || n.ends_with(suffix);
+            if (hit) {
+                out.push_back(i);
+            }
+        }
+        return out;
+    }
+
+    bool WaveIndex::load_checkpoint(uint64_t t0, Scanner& sc) {
+        if (!sc.reader.open(vcd_path)) {
+            std::cerr << "[WaveIndex] Cannot open '" << vcd_path << "'" << std::endl;
+            return false;
+        }
+        for (const WaveSignal& s : sigs) {
+            sc.slots.add(s.id, s.slot);
+        }
+        // 最后一个不晚于 t0 的检查点；第一个检查点位于正文开头，总能用上
+        auto it = std::upper_bound(ckpts.begin(), ckpts.end(), t0,
+                                   [](uint64_t t, const WaveCheckpoint& c) { return t < c.time; });
+        const WaveCheckpoint& c = it == ckpts.begin() ? ckpts.front() : *std::prev(it);
+        sc.values.resize(hdr.n_slots);
+        bool ok = fseeko(idx, static_cast<off_t>(c.data_offset), SEEK_SET) == 0;
+        for (std::string& v : sc.values) {
+            uint32_t n;
+            ok = ok && get_u32(idx, n);
+            if (ok) {
+                v.resize(n);
+                ok = std::fread(v.data(), 1, n, idx) == n;
+            }
+        }
+        if (!ok || !sc.reader.seek(c.offset)) {
+            std::cerr << "[WaveIndex] Cannot restore checkpoint at time " << c.time << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool WaveIndex::values(uint64_t t0, uint64_t t1, const std::vector<size_t>& selected, const ChangeFn& fn) {
+        Scanner sc;
+        if (!load_checkpoint(t0, sc)) {
+            return false;
+        }
+        // 每个槽位上被选中的信号（别名共享槽位）
+        std::vector<std::vector<size_t>> watch(hdr.n_slots);
+        for (size_t i : selected) {
+            watch[sigs[i].slot].push_back(i);
+        }
+
+        bool started = false;
+        auto start = [&] {
+            started = true;
+            for (size_t i : selected) {
+                fn(t0, i, sc.values[sigs[i].slot]);
+            }
+        };
+        uint64_t now = 0;
+        VcdEvent ev;
+        while (next_event(sc.reader, ev)) {
+            if (ev.is_time) {
+                if (!started && ev.time > t0) {
+                    start();
+                }
+                if (ev.time > t1) {
+                    break;
+                }
+                now = ev.time;
+                continue;
+            }
+            const uint32_t slot = sc.slots.find(ev.id);
+            if (slot == NO_SLOT || watch[slot].empty()) {
+                continue;
+            }
+            sc.values[slot] = ev.value;
+            if (started) {
+                for (size_t i : watch[slot]) {
+                    fn(now, i, ev.value);
+                }
+            }
+        }
+        if (!started) {
+            start();
+        }
+        return true;
+    }
+
+    bool WaveIndex::trim(uint64_t t0, uint64_t t1, const std::vector<size_t>& selected, std::FILE* out) {
+        Scanner sc;
+        if (!load_checkpoint(t0, sc)) {
+            return false;
+        }
+        std::FILE* raw = std::fopen(vcd_path.c_str(), "rb");
+        if (!raw) {
+            return false;
+        }
+        const bool all = selected.empty();
+        std::vector<uint8_t> watch(hdr.n_slots, all);
+        for (size_t i : selected) {
+            watch[sigs[i].slot] = 1;
+        }
+
+        // 头部：不筛选时原样拷贝，否则只为选中的信号重建作用域与声明
+        bool ok = true;
+        if (all) {
+            ok = copy_range(raw, 0, hdr.body_offset, out);
+            std::fputc('\n', out); // body_offset 紧跟在 $end 之后
+        } else {
+            std::vector<size_t> order = selected;
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return split_name(sigs[a].name) < split_name(sigs[b].name);
+            });
+            order.erase(std::unique(order.begin(), order.end()), order.end());
+            std::fprintf(out, "$timescale %s $end\n", hdr.timescale);
+            std::vector<std::string> scope;
+            for (size_t i : order) {
+                const WaveSignal& s = sigs[i];
+                std::vector<std::string> path = split_name(s.name);
+                const std::string leaf = path.back();
+                path.pop_back();
+                size_t common = 0;
+                while (common < scope.size() && common < path.size() && scope[common] == path[common]) {
+                    common++;
+                }
+                for (size_t d = scope.size(); d > common; d--) {
+                    std::fputs("$upscope $end\n", out);
+                }
+                for (size_t d = common; d < path.size(); d++) {
+                    std::fprintf(out, "$scope module %s $end\n", path[d].c_str());
+                }
+                scope = std::move(path);
+                std::fprintf(out, "$var %s %u %s %s%s%s $end\n", s.type.c_str(), s.width, s.id.c_str(),
+                             leaf.c_str(), s.range.empty() ? "" : " ", s.range.c_str());
+            }
+            for (size_t d = scope.size(); d > 0; d--) {
+                std::fputs("$upscope $end\n", out);
+            }
+            std::fputs("$enddefinitions $end\n", out);
+        }
+
+        // t0 时刻的全部值作为初值
+        std::vector<std::string> slot_id(hdr.n_slots);
+        for (const WaveSignal& s : sigs) {
+            slot_id[s.slot] = s.id;
+        }
+        bool started = false;
+        auto start = [&] {
+            started = true;
+            std::fprintf(out, "#%llu\n$dumpvars\n", static_cast<unsigned long long>(t0));
+            for (uint32_t slot = 0; slot < hdr.n_slots; slot++) {
+                if (watch[slot] && !sc.values[slot].empty()) {
+                    put_change(out, sc.values[slot], slot_id[slot]);
+                }
+            }
+            std::fputs("$end\n", out);
+        };
+
+        uint64_t now = t0;
+        uint64_t last = t0; // 已写出的最后一个时间戳
+        bool now_written = true;
+        VcdEvent ev;
+        while (next_event(sc.reader, ev)) {
+            if (!ev.is_time) {
+                const uint32_t slot = sc.slots.find(ev.id);
+                if (slot == NO_SLOT || !watch[slot]) {
+                    continue;
+                }
+                sc.values[slot] = ev.value;
+                if (started) {
+                    if (!now_written) {
+                        std::fprintf(out, "#%llu\n", static_cast<unsigned long long>(now));
+                        now_written = true;
+                        last = now;
+                    }
+                    put_change(out, ev.value, ev.id);
+                }
+                continue;
+            }
+            if (!started && ev.time > t0) {
+                start();
+                if (all && ev.time <= t1) {
+                    // 不筛选信号时窗口内容原样拷贝：借助时间标记整段拷贝到窗口末尾附近，只解析最后一小段找出边界
+                    auto m = std::upper_bound(markers.begin(), markers.end(), t1,
+                                              [](uint64_t t, const WaveMarker& mk) { return t < mk.time; });
+                    uint64_t from = ev.offset;
+                    last = ev.time;
+                    if (m != markers.begin() && std::prev(m)->offset > from) {
+                        const WaveMarker& mk = *std::prev(m);
+                        ok = ok && copy_range(raw, from, mk.offset, out) && sc.reader.seek(mk.offset);
+                        from = mk.offset;
+                    }
+                    uint64_t to = hdr.vcd_size;
+                    while (ok && next_event(sc.reader, ev)) {
+                        if (ev.is_time) {
+                            if (ev.time > t1) {
+                                to = ev.offset;
+                                break;
+                            }
+                            last = ev.time;
+                        }
+                    }
+                    ok = ok && copy_range(raw, from, to, out);
+                    break;
+                }
+            }
+            if (ev.time > t1) {
+                break;
+            }
+            now = ev.time;
+            now_written = false;
+        }
+        if (!started) {
+            start();
+        }
+        // 补上窗口末尾的时间戳，使导出的波形覆盖整个窗口
+        if (t1 != UINT64_MAX && t1 > last && t1 <= hdr.end_time) {
+            std::fprintf(out, "#%llu\n", static_cast<unsigned long long>(t1));
+        }
+        std::fclose(raw);
+        return ok && !std::ferror(out);
+    }
+
+} // namespace utils
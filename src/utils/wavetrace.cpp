@@ -0,0 +1,428 @@
+// src/utils/wavetrace.cpp
+
+#include "AdaptSim/utils/wavetrace.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef ADAPTSIM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "verilated.h"
+#include "verilated_vcd_c.h"
+
+namespace utils {
+
+    // VerilatedVcdC 的输出目标：每次 open 开始新的一段，覆盖最旧的段
+    class WaveRecorder::RingFile final : public VerilatedVcdFile {
+    public:
+        explicit RingFile(size_t n) : segs(n), cur(n - 1) {}
+
+        bool open(const std::string&) override {
+            cur = (cur + 1) % segs.size();
+            used = std::min(used + 1, segs.size());
+            segs[cur].clear(); // 保留容量，稳定后不再分配
+            return true;
+        }
+        void close() override {}
+        ssize_t write(const char* bufp, ssize_t len) override {
+            segs[cur].append(bufp, static_cast<size_t>(len));
+            return len;
+        }
+
+        bool save(const std::string& path) const {
+            std::FILE* f = std::fopen(path.c_str(), "wb");
+            if (!f) {
+                return false;
+            }
+            bool ok = true;
+            const size_t first = (cur + segs.size() + 1 - used) % segs.size();
+            for (size_t i = 0; i < used && ok; i++) {
+                std::string_view seg = segs[(first + i) % segs.size()];
+                if (i > 0) {
+                    // 后续段去掉重复的头部，只保留全量值及之后的变化
+                    const size_t defs = seg.find("$enddefinitions");
+                    const size_t eol = defs == std::string_view::npos ? defs : seg.find('\n', defs);
+                    if (eol == std::string_view::npos) {
+                        continue;
+                    }
+                    seg.remove_prefix(eol + 1);
+                }
+                ok = std::fwrite(seg.data(), 1, seg.size(), f) == seg.size();
+            }
+            return std::fclose(f) == 0 && ok;
+        }
+
+    private:
+        std::vector<std::string> segs;
+        size_t cur;
+        size_t used = 0;
+    };
+
+    WaveRecorder::WaveRecorder(uint64_t window_cycles, unsigned segments)
+        : n_segments(std::max(segments, 2u)) {
+        // 当前段未写满，因此 n-1 个完整段就要覆盖整个窗口
+        seg_cycles = std::max<uint64_t>(1, (window_cycles + n_segments - 2) / (n_segments - 1));
+        file = std::make_unique<RingFile>(n_segments);
+        tfp = std::make_unique<VerilatedVcdC>(file.get());
+    }
+
+    WaveRecorder::~WaveRecorder() {
+        if (tfp) {
+            tfp->close();
+        }
+    }
+
+    void WaveRecorder::open() {
+        tfp->open("flight-recorder.vcd"); // 名字只传给 RingFile，不会创建文件
+    }
+
+    void WaveRecorder::dump(uint64_t time, uint64_t cycle) {
+        if (cycle - seg_start >= seg_cycles) {
+            seg_start = cycle;
+            tfp->openNext(false);
+        }
+        tfp->dump(time);
+    }
+
+    bool WaveRecorder::save(const std::string& path) {
+        tfp->flush();
+        if (!file->save(path)) {
+            std::cerr << "WaveRecorder: cannot write " << path << std::endl;
+            return false;
+        }
+        std::cout << "Flight-recorder waveform (last " << window() << "+ cycles) saved to " << path << std::endl;
+        return true;
+    }
+
+    bool parse_wave_compression(const std::string& name, WaveCompression& out) {
+        if (name.empty() || name == "none") {
+            out = WaveCompression::None;
+            return true;
+        }
+#ifdef ADAPTSIM_HAVE_ZSTD
+        if (name == "zstd") {
+            out = WaveCompression::Zstd;
+            return true;
+        }
+#endif
+        return false;
+    }
+
+    // 两块缓冲区：front 由仿真线程填充，back 交给写线程。写线程没写完 back 时 front 又满了才需要等待
+    class AsyncWaveSink::File final : public VerilatedVcdFile {
+    public:
+        File(size_t cap, WaveCompression compression) : cap(std::max<size_t>(cap, 4096)), compression(compression) {
+            front.reserve(this->cap);
+            back.reserve(this->cap);
+#ifdef ADAPTSIM_HAVE_ZSTD
+            if (compression == WaveCompression::Zstd) {
+                cctx = ZSTD_createCCtx();
+                zbuf.resize(ZSTD_CStreamOutSize());
+            }
+#endif
+            writer = std::thread([this] { writer_loop(); });
+        }
+
+        ~File() override {
+            close();
+            {
+                std::lock_guard<std::mutex> lock(m);
+                stop = true;
+            }
+            cv.notify_all();
+            writer.join();
+#ifdef ADAPTSIM_HAVE_ZSTD
+            ZSTD_freeCCtx(cctx);
+#endif
+        }
+
+        bool open(const std::string& name) override {
+            close();
+            std::string path = name;
+            if (compression == WaveCompression::Zstd && !path.ends_with(".zst")) {
+                path += ".zst";
+            }
+            // 写线程此时空闲，文件与压缩状态只在两次 open/close 之间由它使用
+            out = std::fopen(path.c_str(), "wb");
+            if (!out) {
+                std::cerr << "AsyncWaveSink: cannot write " << path << std::endl;
+                return false;
+            }
+#ifdef ADAPTSIM_HAVE_ZSTD
+            if (cctx) {
+                ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+                ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 3);
+            }
+#endif
+            return true;
+        }
+
+        void close() override {
+            if (!out) {
+                return;
+            }
+            submit();
+            drain();
+            finish_frame();
+            if (std::fclose(out) != 0 || failed) {
+                std::cerr << "AsyncWaveSink: write error, waveform may be truncated" << std::endl;
+            }
+            out = nullptr;
+            failed = false;
+        }
+
+        ssize_t write(const char* bufp, ssize_t len) override {
+            const size_t n = static_cast<size_t>(len);
+            if (front.size() + n > cap) [[unlikely]] {
+                submit();
+            }
+            front.insert(front.end(), bufp, bufp + n);
+            bytes_in.fetch_add(n, std::memory_order_relaxed);
+            return len;
+        }
+
+        std::atomic<uint64_t> bytes_in{0};
+        std::atomic<uint64_t> bytes_out{0};
+        std::atomic<uint64_t> stalls{0};
+
+    private:
+        // 把 front 交给写线程；back 还没写完时等待
+        void submit() {
+            if (front.empty()) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(m);
+            if (back_full) {
+                stalls.fetch_add(1, std::memory_order_relaxed);
+                cv.wait(lock, [this] { return !back_full; });
+            }
+            front.swap(back);
+            back_full = true;
+            lock.unlock();
+            cv.notify_all();
+            front.clear();
+        }
+
+        void drain() {
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [this] { return !back_full; });
+        }
+
+        void writer_loop() {
+            std::unique_lock<std::mutex> lock(m);
+            while (true) {
+                cv.wait(lock, [this] { return back_full || stop; });
+                if (!back_full) {
+                    return;
+                }
+                lock.unlock();
+                emit(back.data(), back.size());
+                back.clear();
+                lock.lock();
+                back_full = false;
+                cv.notify_all();
+            }
+        }
+
+        void put(const char* p, size_t n) {
+            if (std::fwrite(p, 1, n, out) != n) {
+                failed = true;
+            }
+            bytes_out.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        // 写线程调用
+        void emit(const char* p, size_t n) {
+#ifdef ADAPTSIM_HAVE_ZSTD
+            if (cctx) {
+                ZSTD_inBuffer in{p, n, 0};
+                while (in.pos < in.size) {
+                    ZSTD_outBuffer o{zbuf.data(), zbuf.size(), 0};
+                    if (ZSTD_isError(ZSTD_compressStream2(cctx, &o, &in, ZSTD_e_continue))) {
+                        failed = true;
+                        return;
+                    }
+                    put(zbuf.data(), o.pos);
+                }
+                return;
+            }
+#endif
+            put(p, n);
+        }
+
+        // 写线程已空闲时由仿真线程调用，结束压缩帧
+        void finish_frame() {
+#ifdef ADAPTSIM_HAVE_ZSTD
+            if (cctx) {
+                ZSTD_inBuffer in{nullptr, 0, 0};
+                size_t left;
+                do {
+                    ZSTD_outBuffer o{zbuf.data(), zbuf.size(), 0};
+                    left = ZSTD_compressStream2(cctx, &o, &in, ZSTD_e_end);
+                    if (ZSTD_isError(left)) {
+                        failed = true;
+                        return;
+                    }
+                    put(zbuf.data(), o.pos);
+                } while (left != 0);
+            }
+#endif
+        }
+
+        const size_t cap;
+        const WaveCompression compression;
+        std::vector<char> front;
+        std::vector<char> back;
+        std::FILE* out = nullptr;
+        bool failed = false;
+#ifdef ADAPTSIM_HAVE_ZSTD
+        ZSTD_CCtx* cctx = nullptr;
+        std::vector<char> zbuf;
+#endif
+
+        std::mutex m;
+        std::condition_variable cv;
+        bool back_full = false;
+        bool stop = false;
+        std::thread writer;
+    };
+
+    AsyncWaveSink::AsyncWaveSink(size_t buffer_bytes, WaveCompression compression)
+        : impl(std::make_unique<File>(buffer_bytes, compression)) {}
+
+    AsyncWaveSink::~AsyncWaveSink() = default;
+
+    VerilatedVcdFile* AsyncWaveSink::file() {
+        return impl.get();
+    }
+
+    uint64_t AsyncWaveSink::bytes_in() const {
+        return impl->bytes_in.load(std::memory_order_relaxed);
+    }
+
+    uint64_t AsyncWaveSink::bytes_out() const {
+        return impl->bytes_out.load(std::memory_order_relaxed);
+    }
+
+    uint64_t AsyncWaveSink::stall_count() const {
+        return impl->stalls.load(std::memory_order_relaxed);
+    }
+
+    bool parse_wave_window(const std::string& spec, WaveWindow& out) {
+        const size_t colon = spec.find(':');
+        const size_t dash = spec.find('-', colon == std::string::npos ? 0 : colon);
+        if (colon == std::string::npos || dash == std::string::npos) {
+            return false;
+        }
+        const std::string kind = spec.substr(0, colon);
+        if (kind == "pc") {
+            out.trigger = WaveWindow::Trigger::PcRange;
+        } else if (kind == "inst") {
+            out.trigger = WaveWindow::Trigger::InstCount;
+        } else if (kind == "cycle") {
+            out.trigger = WaveWindow::Trigger::CycleRange;
+        } else {
+            return false;
+        }
+        try {
+            out.begin = std::stoull(spec.substr(colon + 1, dash - colon - 1), nullptr, 0);
+            out.end = std::stoull(spec.substr(dash + 1), nullptr, 0);
+        } catch (const std::exception&) {
+            return false;
+        }
+        return out.begin < out.end;
+    }
+
+    WaveTrigger::WaveTrigger(std::vector<WaveWindow> windows_, unsigned max_files)
+        : windows(std::move(windows_)), fired(windows.size()), inside(windows.size()), active(windows.size()),
+          files_left(max_files) {
+        update_next_cycle();
+    }
+
+    // PC / 指令数窗口只在提交时判断，周期窗口两处都判断
+    bool WaveTrigger::should_close(const WaveWindow& w, size_t i, uint64_t inst_cnt, uint64_t cycle, bool at_commit) const {
+        switch (w.trigger) {
+            case WaveWindow::Trigger::PcRange: return at_commit && !inside[i];
+            case WaveWindow::Trigger::InstCount: return at_commit && inst_cnt >= w.end;
+            case WaveWindow::Trigger::CycleRange: return cycle >= w.end;
+        }
+        return true;
+    }
+
+    bool WaveTrigger::should_open(const WaveWindow& w, size_t i, uint64_t inst_cnt, uint64_t cycle, bool at_commit) const {
+        switch (w.trigger) {
+            case WaveWindow::Trigger::PcRange: return at_commit && inside[i];
+            case WaveWindow::Trigger::InstCount: return at_commit && !fired[i] && inst_cnt >= w.begin && inst_cnt < w.end;
+            case WaveWindow::Trigger::CycleRange: return !fired[i] && cycle >= w.begin && cycle < w.end;
+        }
+        return false;
+    }
+
+    WaveTriggerEvent WaveTrigger::poll(uint32_t pc, uint64_t inst_cnt, uint64_t cycle, bool at_commit) {
+        WaveTriggerEvent ev;
+        if (at_commit) {
+            for (size_t i = 0; i < windows.size(); i++) {
+                if (windows[i].trigger == WaveWindow::Trigger::PcRange) {
+                    inside[i] = pc >= windows[i].begin && pc < windows[i].end;
+                }
+            }
+        }
+        const bool was_recording = n_active > 0;
+        for (size_t i = 0; i < windows.size(); i++) {
+            if (active[i] && should_close(windows[i], i, inst_cnt, cycle, at_commit)) {
+                active[i] = 0;
+                n_active--;
+            }
+        }
+        // 没有窗口在输出且文件数已用完时不再激活新窗口
+        const bool can_open = n_active > 0 || files_left > 0;
+        int first_opened = -1;
+        for (size_t i = 0; i < windows.size() && can_open; i++) {
+            if (!active[i] && should_open(windows[i], i, inst_cnt, cycle, at_commit)) {
+                active[i] = 1;
+                fired[i] = 1;
+                n_active++;
+                if (first_opened < 0) {
+                    first_opened = static_cast<int>(i);
+                }
+            }
+        }
+        if (was_recording && n_active == 0) {
+            ev.close = true;
+        }
+        if (n_active > 0 && (!was_recording || ev.close)) {
+            ev.open = first_opened;
+            files_left--;
+        }
+        if (ev.close || first_opened >= 0 || n_active != 0) {
+            update_next_cycle();
+        }
+        return ev;
+    }
+
+    void WaveTrigger::update_next_cycle() {
+        next_cycle = UINT64_MAX;
+        const bool can_open = n_active > 0 || files_left > 0;
+        for (size_t i = 0; i < windows.size(); i++) {
+            const WaveWindow& w = windows[i];
+            if (w.trigger != WaveWindow::Trigger::CycleRange) {
+                continue;
+            }
+            if (active[i]) {
+                next_cycle = std::min(next_cycle, w.end);
+            } else if (!fired[i] && can_open) {
+                next_cycle = std::min(next_cycle, w.begin);
+            }
+        }
+    }
+
+} // namespace utils
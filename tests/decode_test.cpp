@@ -0,0 +1,123 @@
+// tests/decode_test.cpp
+//
+// 表驱动解码：按 opcode 分桶的查找与逐项扫描整张表一致，立即数与寄存器字段正确，解码缓存与直接解码一致。
+//
+
+#include "test.h"
+#include "AdaptSim/utils/decode.h"
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <string>
+
+namespace
+{
+    using utils::DecodedInst;
+    using utils::RvOp;
+
+    // 不分桶、逐项扫描整张表的参考解码，只给出匹配的表项数与第一项
+    int scan_table(uint32_t inst, RvOp& op) {
+        int matches = 0;
+        op = RvOp::INVALID;
+        if ((inst & 3) != 3) {
+            return 0;
+        }
+        for (const auto& p : utils::detail::OP_TABLE) {
+            if ((inst & p.mask) == p.match) {
+                if (matches++ == 0) {
+                    op = p.op;
+                }
+            }
+        }
+        return matches;
+    }
+
+} // namespace
+
+TEST_CASE("decode/table_matches_scan", [] {
+    std::mt19937 rng(5);
+    for (const auto& p : utils::detail::OP_TABLE) {
+        for (int i = 0; i < 1000; i++) {
+            const uint32_t inst = (static_cast<uint32_t>(rng()) & ~p.mask) | p.match;
+            RvOp op;
+            // 表项之间没有重叠，分桶查找的结果与逐项扫描一致
+            CHECK(scan_table(inst, op) == 1);
+            const DecodedInst d = utils::rv32_decode(inst);
+            CHECK(d.op == p.op);
+            CHECK(d.cls == p.cls);
+            CHECK(d.fmt == p.fmt);
+        }
+    }
+    // 任意编码：分桶查找与逐项扫描给出同样的结果（包括无法识别的编码）
+    for (int i = 0; i < 200000; i++) {
+        const uint32_t inst = static_cast<uint32_t>(rng());
+        RvOp op;
+        scan_table(inst, op);
+        CHECK(utils::rv32_decode(inst).op == op);
+    }
+});
+
+TEST_CASE("decode/fields", [] {
+    const DecodedInst addi = utils::rv32_decode(0x00100093); // addi x1, x0, 1
+    CHECK(addi.op == RvOp::ADDI && addi.rd == 1 && addi.rs1 == 0 && addi.imm == 1);
+    CHECK(addi.flags & utils::INST_WRITES_RD);
+
+    const DecodedInst lw = utils::rv32_decode(0xff812283); // lw x5, -8(x2)
+    CHECK(lw.op == RvOp::LW && lw.rd == 5 && lw.rs1 == 2 && lw.imm == -8 && lw.is_load());
+
+    const DecodedInst sw = utils::rv32_decode(0x00512623); // sw x5, 12(x2)
+    CHECK(sw.op == RvOp::SW && sw.rd == 0 && sw.rs1 == 2 && sw.rs2 == 5 && sw.imm == 12 && sw.is_store());
+
+    const DecodedInst beq = utils::rv32_decode(0xfe000ee3); // beq x0, x0, -4
+    CHECK(beq.op == RvOp::BEQ && beq.imm == -4 && beq.is_branch() && beq.is_control_flow());
+
+    const DecodedInst jal = utils::rv32_decode(0x001000ef); // jal x1, 2048
+    CHECK(jal.op == RvOp::JAL && jal.rd == 1 && jal.imm == 2048 && jal.is_jump());
+
+    const DecodedInst lui = utils::rv32_decode(0x123451b7); // lui x3, 0x12345
+    CHECK(lui.op == RvOp::LUI && lui.rd == 3 && lui.imm == 0x12345000);
+
+    const DecodedInst srai = utils::rv32_decode(0x4030d093); // srai x1, x1, 3
+    CHECK(srai.op == RvOp::SRAI && srai.rd == 1 && srai.rs1 == 1 && (srai.imm & 0x1f) == 3);
+
+    const DecodedInst mul = utils::rv32_decode(0x02208233); // mul x4, x1, x2
+    CHECK(mul.op == RvOp::MUL && mul.rd == 4 && mul.rs1 == 1 && mul.rs2 == 2);
+
+    const DecodedInst csrrw = utils::rv32_decode(0x300110f3); // csrrw x1, mstatus, x2
+    CHECK(csrrw.op == RvOp::CSRRW && csrrw.rd == 1 && csrrw.rs1 == 2);
+
+    CHECK(utils::rv32_decode(0x00000073).op == RvOp::ECALL);
+    CHECK(utils::rv32_decode(0x00100073).op == RvOp::EBREAK);
+    CHECK(utils::rv32_decode(0x30200073).op == RvOp::MRET);
+    CHECK(utils::rv32_decode(0x00100073).is_control_flow());
+
+    // 写 x0 的指令不算写回
+    const DecodedInst nop = utils::rv32_decode(0x00000013); // addi x0, x0, 0
+    CHECK(nop.op == RvOp::ADDI && !(nop.flags & utils::INST_WRITES_RD));
+
+    CHECK(!utils::rv32_decode(0x00000000).valid()); // 压缩指令空间
+    CHECK(!utils::rv32_decode(0xffffffff).valid());
+});
+
+TEST_CASE("decode/cache_and_names", [] {
+    utils::DecodeCache cache(4); // 16 项，迫使冲突替换
+    std::mt19937 rng(9);
+    for (int i = 0; i < 100000; i++) {
+        const auto& p = utils::detail::OP_TABLE[rng() % std::size(utils::detail::OP_TABLE)];
+        const uint32_t inst = (static_cast<uint32_t>(rng() % 64) * 0x01010101u & ~p.mask) | p.match;
+        const DecodedInst a = cache.decode(inst);
+        const DecodedInst b = utils::rv32_decode(inst);
+        CHECK(a.raw == b.raw && a.imm == b.imm && a.op == b.op && a.cls == b.cls && a.fmt == b.fmt);
+        CHECK(a.rd == b.rd && a.rs1 == b.rs1 && a.rs2 == b.rs2 && a.flags == b.flags);
+        CHECK(utils::decode_cached(inst).op == b.op);
+    }
+    CHECK(cache.miss_count() > 0);
+
+    std::set<std::string> names;
+    for (size_t i = 0; i < static_cast<size_t>(RvOp::COUNT); i++) {
+        names.insert(utils::rv_op_name(static_cast<RvOp>(i)));
+    }
+    CHECK(names.size() == static_cast<size_t>(RvOp::COUNT));
+    CHECK(std::string(utils::rv_op_name(RvOp::FENCE_I)) == "fence.i");
+});
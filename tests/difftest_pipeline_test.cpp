@@ -0,0 +1,93 @@
+// tests/difftest_pipeline_test.cpp
+//
+// 流水化差分测试：DUT 线程只送提交记录，检查线程按记录重建 DUT 寄存器并驱动 stub_ref 对比。
+// 覆盖全部一致、寄存器与 store 失配的序号和周期、跳过指令时的多寄存器更新，以及批量模式被改回逐条。
+//
+
+#include "test.h"
+#include "stub_ref_program.h"
+#include "AdaptSim/utils/difftest_pipeline.h"
+
+#include <cstdint>
+
+namespace
+{
+    using test::StubRefProgram;
+
+    // 第 i 条提交的 DUT 周期数
+    constexpr uint64_t cycle_of(size_t i) { return 10 * i + 7; }
+
+    // 在当前线程上充当 DUT：写内存、提交；skip_at 处的提交跳过对比。返回 finish() 的结果
+    bool run(StubRefProgram& p, utils::DifftestPipeline& pipe, size_t skip_at = SIZE_MAX) {
+        uint64_t cycle = 0;
+        pipe.set_cycle_source(&cycle);
+        pipe.start();
+        for (size_t i = 0; i < p.trace.size(); i++) {
+            cycle = cycle_of(i);
+            p.dut_store(i);
+            if (i == skip_at) {
+                pipe.skip_dut_once();
+            }
+            if (!pipe.commit(cycle, p.trace[i].ctx, p.trace[i].inst)) {
+                break;
+            }
+        }
+        return pipe.finish();
+    }
+
+} // namespace
+
+TEST_CASE("difftest_pipeline/all_match", [] {
+    StubRefProgram p;
+    utils::DifftestPipeline pipe(p.dt, 16);
+    CHECK(run(p, pipe));
+    CHECK(!pipe.failed());
+    CHECK(p.dt.get_commit_count() == p.trace.size());
+});
+
+TEST_CASE("difftest_pipeline/register_mismatch", [] {
+    StubRefProgram p;
+    const size_t k = 100;
+    p.trace[k].ctx.gpr[1] += 1;
+    utils::DifftestPipeline pipe(p.dt, 16);
+    CHECK(!run(p, pipe));
+    CHECK(pipe.failed());
+    CHECK(pipe.mismatch_index() == k);
+    CHECK(pipe.mismatch_cycle() == cycle_of(k));
+});
+
+TEST_CASE("difftest_pipeline/store_mismatch", [] {
+    StubRefProgram p;
+    const size_t k = StubRefProgram::store_inst(40);
+    p.trace[k].data = 0xdeadbeef;
+    utils::DifftestPipeline pipe(p.dt, 16);
+    CHECK(!run(p, pipe));
+    CHECK(pipe.mismatch_index() == k);
+    CHECK(pipe.mismatch_cycle() == cycle_of(k));
+});
+
+TEST_CASE("difftest_pipeline/skip_resyncs_registers", [] {
+    // 被跳过的指令（例如读 CSR）让 DUT 的 x5 变成 REF 算不出的值，同时还写回了 x1：
+    // 一条提交带两个寄存器变化，要靠 REG 记录送到检查线程，之后 REF 按 DUT 状态继续
+    StubRefProgram p;
+    const size_t k = 31;
+    for (size_t i = k; i < p.trace.size(); i++) {
+        p.trace[i].ctx.gpr[5] = 0x1234;
+    }
+    CHECK(p.trace[k].inst == 0x00108093); // addi x1, x1, 1
+    utils::DifftestPipeline pipe(p.dt, 16);
+    CHECK(run(p, pipe, k));
+    CHECK(p.dt.get_commit_count() == p.trace.size());
+});
+
+TEST_CASE("difftest_pipeline/batch_falls_back", [] {
+    // 批量模式需要一致点的 DUT 内存才能回滚 REF，流水模式下改回逐条对比
+    StubRefProgram p;
+    p.dt.set_batch(32);
+    const size_t k = StubRefProgram::store_inst(10);
+    p.trace[k].data ^= 1;
+    utils::DifftestPipeline pipe(p.dt, 16);
+    CHECK(!run(p, pipe));
+    CHECK(p.dt.get_batch() == 1);
+    CHECK(pipe.mismatch_index() == k);
+});
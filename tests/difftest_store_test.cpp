@@ -0,0 +1,161 @@
+// tests/difftest_store_test.cpp
+//
+// store 队列核对：一次提交带大量 store，按地址合并成区间读取 REF 内存（间隔不超过 64 字节合并，
+// 单个区间不超过 4KB），同一字节被多次写时只核对程序顺序中最后一次写入。
+// 与逐字节应用全部 store 得到的参考结果对照。
+//
+
+#include "test.h"
+#include "stub_ref_program.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using test::StubRefProgram;
+
+    constexpr uint32_t REGION = 0x80100000;
+    constexpr uint32_t REGION_SIZE = 64 << 10;
+
+    struct Store {
+        uint32_t addr;
+        uint32_t len;
+        uint32_t data;
+    };
+
+    // 把 stores 逐字节应用到 region 上，再装进 REF；region 就是 REF 执行后应有的内容
+    void apply(StubRefProgram& p, std::vector<uint8_t>& region, const std::vector<Store>& stores) {
+        for (const Store& s : stores) {
+            for (uint32_t b = 0; b < s.len; b++) {
+                region[s.addr - REGION + b] = static_cast<uint8_t>(s.data >> (8 * b));
+            }
+        }
+        p.dt.memcpy(REGION, region.data(), region.size(), DIFFTEST_TO_REF);
+    }
+
+    // 把 stores 作为程序第一条指令（lui）的写内存提交，返回对比结果
+    bool commit_with(const std::vector<Store>& stores, const std::vector<uint8_t>& ref_region,
+                     StubRefProgram& p) {
+        p.dt.memcpy(REGION, const_cast<uint8_t*>(ref_region.data()), ref_region.size(), DIFFTEST_TO_REF);
+        for (const Store& s : stores) {
+            p.dt.store_commit(s.addr, s.data, static_cast<int>(s.len));
+        }
+        return p.dt.commit(p.trace[0].ctx);
+    }
+
+    // 在 [REGION, REGION + span) 内随机生成对齐的 1/2/4 字节 store
+    std::vector<Store> random_stores(std::mt19937& rng, size_t n, uint32_t span) {
+        std::vector<Store> stores;
+        for (size_t i = 0; i < n; i++) {
+            const uint32_t len = 1u << (rng() % 3);
+            const uint32_t addr = REGION + (rng() % span & ~(len - 1));
+            stores.push_back({addr, len, static_cast<uint32_t>(rng())});
+        }
+        return stores;
+    }
+
+} // namespace
+
+TEST_CASE("difftest_store/last_writer_per_byte", [] {
+    std::vector<uint8_t> region(REGION_SIZE, 0);
+    const uint32_t a = REGION + 0x100;
+    {
+        // 先写错再写对：只核对最后一次
+        StubRefProgram p;
+        apply(p, region, {{a, 4, 0x11223344}});
+        CHECK(commit_with({{a, 4, 0xdeadbeef}, {a, 4, 0x11223344}}, region, p));
+    }
+    {
+        // 先写对再写错：失配
+        StubRefProgram p;
+        CHECK(!commit_with({{a, 4, 0x11223344}, {a, 4, 0xdeadbeef}}, region, p));
+    }
+    {
+        // 部分覆盖：sb 只拥有它写的那个字节，sw 的其余字节仍要核对
+        StubRefProgram p;
+        std::vector<uint8_t> r(REGION_SIZE, 0);
+        apply(p, r, {{a, 4, 0x11223344}, {a + 1, 1, 0x99}});
+        CHECK(commit_with({{a, 4, 0x11223344}, {a + 1, 1, 0x99}}, r, p));
+    }
+    {
+        StubRefProgram p;
+        std::vector<uint8_t> r(REGION_SIZE, 0);
+        apply(p, r, {{a, 4, 0x11223344}, {a + 1, 1, 0x99}});
+        CHECK(!commit_with({{a, 4, 0x11203344}, {a + 1, 1, 0x99}}, r, p));
+    }
+});
+
+TEST_CASE("difftest_store/range_boundaries", [] {
+    // 间隔恰为 64 字节的两个 store 合并读取，65 字节分开读取；错误的第二个 store 都要被发现
+    for (const uint32_t gap : {63u, 64u, 65u}) {
+        StubRefProgram p;
+        std::vector<uint8_t> region(REGION_SIZE, 0);
+        const std::vector<Store> stores{{REGION, 4, 1}, {REGION + 4 + gap, 4, 2}};
+        apply(p, region, stores);
+        CHECK(commit_with(stores, region, p));
+        StubRefProgram q;
+        CHECK(!commit_with({{REGION, 4, 1}, {REGION + 4 + gap, 4, 3}}, region, q));
+    }
+    // 连续 8KB 的 store 被切成不超过 4KB 的区间；切分点两侧与末尾的错误都要被发现
+    std::vector<Store> run;
+    for (uint32_t off = 0; off < 8192; off += 4) {
+        run.push_back({REGION + off, 4, off * 2654435761u});
+    }
+    std::vector<uint8_t> region(REGION_SIZE, 0);
+    {
+        StubRefProgram p;
+        apply(p, region, run);
+        CHECK(commit_with(run, region, p));
+    }
+    for (const size_t bad : {size_t{1023}, size_t{1024}, run.size() - 1}) {
+        StubRefProgram p;
+        std::vector<Store> wrong = run;
+        wrong[bad].data ^= 0x80;
+        CHECK(!commit_with(wrong, region, p));
+    }
+
+    // 两个重叠的 store 正好落在 4KB 上限处：它们必须在同一区间里决定每个字节的最后写入者
+    std::vector<Store> edge{{REGION + 2, 2, 0x1111}};
+    for (uint32_t off = 4; off < 4096; off += 4) {
+        edge.push_back({REGION + off, 4, off});
+    }
+    edge.push_back({REGION + 4096, 1, 0x55});
+    edge.push_back({REGION + 4096, 4, 0xaabbccdd});
+    {
+        StubRefProgram p;
+        std::vector<uint8_t> r(REGION_SIZE, 0);
+        apply(p, r, edge);
+        CHECK(commit_with(edge, r, p));
+    }
+});
+
+TEST_CASE("difftest_store/random_against_bytes", [] {
+    std::mt19937 rng(17);
+    for (int iter = 0; iter < 40; iter++) {
+        // 有的轮次集中在几 KB 内（大量重叠，区间在 4KB 上限处切分），有的稀疏分布
+        const uint32_t span = iter % 2 ? 6000 : REGION_SIZE - 8;
+        const std::vector<Store> stores = random_stores(rng, 1 + rng() % 1500, span);
+        std::vector<uint8_t> region(REGION_SIZE, 0);
+        {
+            StubRefProgram p;
+            apply(p, region, stores);
+            CHECK(commit_with(stores, region, p));
+        }
+        // 改动一个 store 的一个字节：只有它仍是该字节的最后写入者时才算失配
+        const size_t victim = rng() % stores.size();
+        const uint32_t byte = rng() % stores[victim].len;
+        std::vector<Store> wrong = stores;
+        wrong[victim].data ^= 1u << (8 * byte);
+        bool visible = true;
+        for (size_t i = victim + 1; i < stores.size(); i++) {
+            const uint32_t at = stores[victim].addr + byte;
+            if (at >= stores[i].addr && at < stores[i].addr + stores[i].len) {
+                visible = false;
+            }
+        }
+        StubRefProgram p;
+        CHECK(commit_with(wrong, region, p) == !visible);
+    }
+});
@@ -0,0 +1,76 @@
+// tests/difftest_test.cpp
+//
+// 批量差分测试：以随仓库构建的 stub_ref 为参考模型，批次中的寄存器失配与 store 失配
+// 都要逐条重放定位到第一条分歧指令，显式 flush 之后的批次照常对比。
+//
+
+#include "test.h"
+#include "stub_ref_program.h"
+
+#include <cstdint>
+
+namespace
+{
+    using test::StubRefProgram;
+
+    // 以批大小 batch 对比（观察 DUT 的写内存）
+    struct Batched : StubRefProgram {
+        explicit Batched(uint32_t batch, bool adaptive = false) {
+            dt.observe_dut_stores();
+            dt.set_batch(batch, adaptive);
+        }
+
+        // DUT 先写内存再提交，flush_at 之后额外 flush 一次；全部一致时返回 true
+        bool run(size_t flush_at = SIZE_MAX) {
+            for (size_t i = 0; i < trace.size(); i++) {
+                dut_store(i);
+                if (!dt.commit(trace[i].ctx) || (i == flush_at && !dt.flush())) {
+                    return false;
+                }
+            }
+            return dt.flush();
+        }
+    };
+
+} // namespace
+
+TEST_CASE("difftest/batch_all_match", [] {
+    for (const uint32_t batch : {1u, 7u, 32u}) {
+        Batched p(batch);
+        CHECK(p.run());
+        CHECK(p.dt.get_commit_count() == p.trace.size());
+    }
+    Batched p(16, true);
+    CHECK(p.run(50));
+});
+
+TEST_CASE("difftest/batch_register_mismatch", [] {
+    Batched p(32);
+    // 批次只在边界对比，DUT 的错误值要一直保留到批次结束才会被发现
+    const size_t k = 75;
+    for (size_t i = k; i < p.trace.size(); i++) {
+        p.trace[i].ctx.gpr[5] = 1;
+    }
+    CHECK(!p.run());
+    CHECK(p.dt.get_commit_count() == k);
+});
+
+TEST_CASE("difftest/batch_store_mismatch", [] {
+    // 寄存器都一致，只有 DUT 写内存的值错了：失配要定位到这条 store，而不是批次的最后一条
+    for (const size_t round : {size_t{0}, size_t{20}, StubRefProgram::LOOP - 1}) {
+        Batched p(32);
+        const size_t k = StubRefProgram::store_inst(round);
+        p.trace[k].data ^= 0x100;
+        CHECK(!p.run());
+        CHECK(p.dt.get_commit_count() == k);
+    }
+});
+
+TEST_CASE("difftest/batch_mismatch_after_flush", [] {
+    // 批次中途的 flush 之后（例如保存检查点）再失配，回滚与重放仍从新的一致点开始
+    Batched p(32);
+    const size_t k = StubRefProgram::store_inst(30);
+    p.trace[k].data = 0;
+    CHECK(!p.run(k - 5));
+    CHECK(p.dt.get_commit_count() == k);
+});
@@ -0,0 +1,125 @@
+// tests/itrace_test.cpp
+//
+// 指令提交日志：写入后逐条读回（跨多个块、各压缩算法），seek 跳转，以及 sync 重设写回基准。
+//
+
+#include "test.h"
+#include "AdaptSim/utils/itrace.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using utils::InstTraceCodec;
+    using utils::InstTraceEntry;
+
+    struct Expected {
+        uint32_t pc;
+        uint32_t inst;
+        uint8_t rd;
+        uint32_t rd_value;
+    };
+
+    // 生成一段带跳转和寄存器写回的提交序列，同时写入日志
+    std::vector<Expected> write_trace(const std::string& path, InstTraceCodec codec, size_t n) {
+        utils::InstTraceWriter writer;
+        CHECK(writer.open(path, codec));
+        std::mt19937 rng(3);
+        uint32_t gpr[32] = {};
+        uint32_t pc = 0x80000000;
+        std::vector<Expected> expected;
+        expected.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            if (rng() % 8 == 0) {
+                pc += (static_cast<int32_t>(rng() % 4096) - 2048) * 4; // 前后跳转
+            }
+            Expected e{pc, static_cast<uint32_t>(rng()), 0, 0};
+            if (rng() % 3) {
+                const uint8_t rd = 1 + rng() % 31;
+                // 值大多小幅变化，偶尔整体改变，覆盖不同长度的 varint
+                const uint32_t value = rng() % 4 ? gpr[rd] + 1 + rng() % 100 : static_cast<uint32_t>(rng());
+                if (value != gpr[rd]) {
+                    gpr[rd] = value;
+                    e.rd = rd;
+                    e.rd_value = value;
+                }
+            }
+            writer.commit(e.pc, e.inst, gpr);
+            expected.push_back(e);
+            pc += 4;
+        }
+        CHECK(writer.count() == n);
+        writer.close();
+        return expected;
+    }
+
+    bool same(const InstTraceEntry& got, const Expected& e, uint64_t index) {
+        return got.index == index && got.pc == e.pc && got.inst == e.inst &&
+               got.rd == e.rd && (e.rd == 0 || got.rd_value == e.rd_value);
+    }
+
+    void round_trip(InstTraceCodec codec) {
+        const std::string path = test::temp_path("itrace.bin");
+        // 每条记录至少 5 字节，200000 条跨越十几个 64KB 的块
+        const std::vector<Expected> expected = write_trace(path, codec, 200000);
+
+        utils::InstTraceReader reader;
+        CHECK(reader.open(path));
+        InstTraceEntry entry{};
+        uint64_t n = 0;
+        while (reader.next(entry)) {
+            if (n >= expected.size() || !same(entry, expected[n], n)) {
+                CHECK(!"record mismatch");
+                return;
+            }
+            n++;
+        }
+        CHECK(n == expected.size());
+
+        // seek 只向前跳：块内、跨多个整块，以及同一读取器上的连续跳转
+        for (const uint64_t index : {uint64_t{0}, uint64_t{7}, uint64_t{150000}, uint64_t{199999}}) {
+            utils::InstTraceReader r;
+            CHECK(r.open(path) && r.seek(index));
+            CHECK(r.next(entry) && same(entry, expected[index], index));
+        }
+        utils::InstTraceReader r;
+        CHECK(r.open(path) && r.seek(10) && r.seek(90000));
+        CHECK(r.next(entry) && same(entry, expected[90000], 90000));
+        CHECK(r.seek(expected.size()) && !r.next(entry));
+    }
+
+} // namespace
+
+TEST_CASE("itrace/round_trip_none", [] { round_trip(InstTraceCodec::None); });
+
+TEST_CASE("itrace/round_trip_compressed", [] {
+    for (const InstTraceCodec codec : {InstTraceCodec::LZ4, InstTraceCodec::Zstd}) {
+        if (utils::inst_trace_codec_available(codec)) {
+            round_trip(codec);
+        }
+    }
+});
+
+TEST_CASE("itrace/sync", [] {
+    const std::string path = test::temp_path("itrace_sync.bin");
+    utils::InstTraceWriter writer;
+    CHECK(writer.open(path));
+    uint32_t gpr[32] = {};
+    gpr[5] = 1;
+    writer.commit(0x1000, 0x00100293, gpr);
+    // 快进改变了 x7 但没有提交记录；sync 之后下一条只报告真正写回的 x9
+    gpr[7] = 0x1234;
+    writer.sync(gpr);
+    gpr[9] = 42;
+    writer.commit(0x2000, 0x02a00493, gpr);
+    writer.close();
+
+    utils::InstTraceReader reader;
+    CHECK(reader.open(path));
+    InstTraceEntry entry{};
+    CHECK(reader.next(entry) && entry.rd == 5 && entry.rd_value == 1);
+    CHECK(reader.next(entry) && entry.pc == 0x2000 && entry.rd == 9 && entry.rd_value == 42);
+    CHECK(!reader.next(entry));
+});
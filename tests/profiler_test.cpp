@@ -0,0 +1,141 @@
+// tests/profiler_test.cpp
+//
+// 客户程序热点分析：用一段合成的提交序列（主循环每轮调用一次函数）检查基本块划分、
+// PC 直方图的周期数、SimPoint BBV 区间，以及折叠调用栈的帧与周期数。
+//
+
+#include "test.h"
+#include "AdaptSim/utils/profiler.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using utils::Profiler;
+
+    constexpr uint32_t NOP = 0x00000013;  // addi x0, x0, 0
+    constexpr uint32_t CALL = 0x000000ef; // jal ra, ...（目标由下一条提交的 PC 给出）
+    constexpr uint32_t RET = 0x00008067;  // jalr x0, 0(ra)
+    constexpr uint32_t LOOP = 0x00000063; // beq x0, x0, ...
+
+    struct Step {
+        uint32_t pc;
+        uint32_t inst;
+        uint64_t cost; // 该指令的周期数
+    };
+
+    // 每轮：main 的块 A (nop; call) -> foo 的块 B (nop; nop; ret，每条 3 周期) -> main 的块 C (nop; beq)
+    const std::vector<Step> ROUND{
+        {0x1000, NOP, 1}, {0x1004, CALL, 1},
+        {0x2000, NOP, 3}, {0x2004, NOP, 3}, {0x2008, RET, 3},
+        {0x1008, NOP, 1}, {0x100c, LOOP, 1},
+    };
+    constexpr uint64_t ROUNDS = 10;
+
+    void run(Profiler& prof) {
+        uint64_t cycle = 0;
+        for (uint64_t r = 0; r < ROUNDS; r++) {
+            for (const Step& s : ROUND) {
+                cycle += s.cost;
+                prof.commit(s.pc, s.inst, cycle);
+            }
+        }
+    }
+
+    std::vector<std::string> read_lines(const std::string& path) {
+        std::ifstream f(path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(f, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+} // namespace
+
+TEST_CASE("profiler/blocks_and_histogram", [] {
+    const std::string out = test::temp_path("prof");
+    for (const char* ext : {".flat", ".folded", ".bb"}) {
+        test::temp_path(std::string("prof") + ext);
+    }
+    Profiler prof({0, 0, out});
+    run(prof);
+
+    std::map<uint32_t, utils::CounterMap::Entry> blocks;
+    prof.basic_blocks().for_each([&](const utils::CounterMap::Entry& e) { blocks[e.key] = e; });
+    CHECK(blocks.size() == 3);
+    // 块号按第一次结束的先后编号；weight 为累计指令数
+    CHECK(blocks[0x1000].tag == 1 && blocks[0x1000].count == ROUNDS && blocks[0x1000].weight == 2 * ROUNDS);
+    CHECK(blocks[0x2000].tag == 2 && blocks[0x2000].count == ROUNDS && blocks[0x2000].weight == 3 * ROUNDS);
+    CHECK(blocks[0x1008].tag == 3 && blocks[0x1008].count == ROUNDS && blocks[0x1008].weight == 2 * ROUNDS);
+
+    std::map<uint32_t, utils::CounterMap::Entry> pcs;
+    prof.pc_histogram().for_each([&](const utils::CounterMap::Entry& e) { pcs[e.key] = e; });
+    CHECK(pcs.size() == ROUND.size());
+    CHECK(pcs[0x2004].count == ROUNDS && pcs[0x2004].weight == 3 * ROUNDS);
+    CHECK(pcs[0x100c].count == ROUNDS && pcs[0x100c].weight == ROUNDS);
+
+    // 没有符号时以地址作为帧名；根是第一个块的入口
+    CHECK(prof.write(utils::SymbolTable{}));
+    const std::vector<std::string> folded = read_lines(out + ".folded");
+    CHECK(folded.size() == 2);
+    std::map<std::string, uint64_t> stacks;
+    for (const std::string& line : folded) {
+        const size_t sp = line.rfind(' ');
+        stacks[line.substr(0, sp)] = std::stoull(line.substr(sp + 1));
+    }
+    CHECK(stacks["0x00001000"] == 4 * ROUNDS);
+    CHECK(stacks["0x00001000;0x00002000"] == 9 * ROUNDS);
+
+    const std::vector<std::string> flat = read_lines(out + ".flat");
+    CHECK(flat.size() == 1 + ROUND.size());
+    CHECK(flat.size() > 1 && flat[1].find("0x00002000") != std::string::npos); // foo 的每条指令最贵
+});
+
+TEST_CASE("profiler/bbv_intervals", [] {
+    // 区间为两轮的指令数：每个区间恰好结束在块边界上，5 行内容相同
+    const std::string out = test::temp_path("prof_bbv");
+    for (const char* ext : {".bbv", ".flat", ".folded", ".bb"}) {
+        test::temp_path(std::string("prof_bbv") + ext);
+    }
+    {
+        Profiler prof({0, 2 * ROUND.size(), out});
+        run(prof);
+        CHECK(prof.write(utils::SymbolTable{}));
+    }
+    const std::vector<std::string> bbv = read_lines(out + ".bbv");
+    CHECK(bbv.size() == ROUNDS / 2);
+    for (const std::string& line : bbv) {
+        CHECK(!line.empty() && line[0] == 'T');
+        std::map<uint32_t, uint64_t> counts;
+        std::istringstream in(line.substr(1));
+        for (std::string item; in >> item;) {
+            unsigned id = 0;
+            unsigned long long n = 0;
+            CHECK(std::sscanf(item.c_str(), ":%u:%llu", &id, &n) == 2);
+            counts[id] = n;
+        }
+        CHECK((counts == std::map<uint32_t, uint64_t>{{1, 4}, {2, 6}, {3, 4}}));
+    }
+});
+
+TEST_CASE("profiler/sampling", [] {
+    // 每 10 周期一个样本：样本总数为总周期数 / 10，每个样本记 10 周期
+    const std::string out = test::temp_path("prof_sample");
+    Profiler prof({10, 0, out});
+    run(prof);
+    uint64_t samples = 0;
+    uint64_t cycles = 0;
+    prof.pc_histogram().for_each([&](const utils::CounterMap::Entry& e) {
+        samples += e.count;
+        cycles += e.weight;
+    });
+    CHECK(samples == 13 * ROUNDS / 10);
+    CHECK(cycles == 10 * samples);
+});
@@ -0,0 +1,60 @@
+// tests/spsc_ring_test.cpp
+//
+// SPSC 环形队列：容量取整、满/空边界，以及两个线程之间在反压下按顺序、不丢不重地传递。
+//
+
+#include "test.h"
+#include "AdaptSim/utils/spsc_ring.h"
+
+#include <cstdint>
+#include <thread>
+
+TEST_CASE("spsc_ring/bounds", [] {
+    utils::SpscRing<uint32_t> ring(5); // 向上取整为 8
+    CHECK(ring.capacity() == 8);
+    uint32_t v = 0;
+    CHECK(!ring.try_pop(v));
+    for (uint32_t round = 0; round < 3; round++) {
+        // 每轮从不同的起点填满再取空，覆盖索引回绕
+        for (uint32_t i = 0; i < 8; i++) {
+            CHECK(ring.try_push(round * 100 + i));
+        }
+        CHECK(!ring.try_push(999));
+        for (uint32_t i = 0; i < 5; i++) {
+            CHECK(ring.try_pop(v) && v == round * 100 + i);
+        }
+        for (uint32_t i = 8; i < 13; i++) {
+            CHECK(ring.try_push(round * 100 + i));
+        }
+        CHECK(!ring.try_push(999));
+        for (uint32_t i = 5; i < 13; i++) {
+            CHECK(ring.try_pop(v) && v == round * 100 + i);
+        }
+        CHECK(!ring.try_pop(v));
+    }
+    CHECK(utils::SpscRing<uint32_t>(0).capacity() == 2);
+});
+
+TEST_CASE("spsc_ring/two_threads", [] {
+    constexpr uint64_t N = 1000000;
+    utils::SpscRing<uint64_t> ring(64);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < N; i++) {
+            ring.push(i * 7 + 1);
+        }
+    });
+    uint64_t expected = 0;
+    bool ordered = true;
+    uint64_t v = 0;
+    while (expected < N) {
+        if (ring.try_pop(v)) {
+            ordered = ordered && v == expected * 7 + 1;
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(!ring.try_pop(v));
+});
@@ -0,0 +1,108 @@
+// tests/stub_ref_program.h
+//
+// 差分测试用例共用的小程序：在 stub_ref 上先跑一遍得到 DUT 应有的提交序列，
+// 之后由用例改动其中的寄存器或写内存来制造失配。
+//
+#ifndef ADAPTSIM_TEST_STUB_REF_PROGRAM_H
+#define ADAPTSIM_TEST_STUB_REF_PROGRAM_H
+
+#include "AdaptSim/utils/difftest.h"
+#include "AdaptSim/vmemory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace test
+{
+    /**
+     * @brief lui x2, 0x80010；每轮 addi x1, x1, 1 / sw x1, 0(x2) / addi x2, x2, 4；最后 ebreak。
+     * 构造时把程序装进 DUT 内存（当前线程绑定到 mem）和 REF，并让 REF 回到起点。
+     */
+    class StubRefProgram {
+    public:
+        static constexpr uint32_t IMG_BASE = 0x80000000;
+        static constexpr uint32_t DATA_BASE = 0x80010000;
+        static constexpr uint32_t REF_MEM_SIZE = 16u << 20; // stub_ref 的内存大小
+        static constexpr size_t LOOP = 64;
+        static constexpr uint32_t SW = 0x00112023;
+
+        // DUT 一侧的一条提交：提交后的寄存器（pc 为该指令的地址），以及该指令的写内存（len 为 0 表示没有）
+        struct Commit {
+            utils::diff_context_t ctx;
+            uint32_t inst = 0;
+            uint32_t addr = 0;
+            uint32_t data = 0;
+            uint32_t len = 0;
+        };
+
+        StubRefProgram() : prev(memory::bind_memory(&mem)), dt(ADAPTSIM_TEST_STUB_REF, 0) {
+            const std::vector<uint32_t> img = image();
+            for (size_t i = 0; i < img.size(); i++) {
+                mem.write(IMG_BASE + 4 * i, 4, img[i]);
+            }
+            load_ref();
+            const utils::diff_context_t start = dt.get_ref_state();
+            for (size_t i = 0; i + 1 < img.size(); i++) {
+                Commit c;
+                c.ctx = dt.get_ref_state();
+                c.inst = img[i];
+                const uint32_t pc = c.ctx.pc;
+                if (img[i] == SW) {
+                    c.addr = c.ctx.gpr[2];
+                    c.len = 4;
+                }
+                dt.exec(1);
+                c.ctx = dt.get_ref_state();
+                c.ctx.pc = pc;
+                c.data = c.ctx.gpr[1];
+                trace.push_back(c);
+            }
+            load_ref();
+            dt.restore_ref(start, 0);
+            dt.set_ref_memory(IMG_BASE, REF_MEM_SIZE);
+        }
+
+        ~StubRefProgram() { memory::bind_memory(prev); }
+
+        StubRefProgram(const StubRefProgram&) = delete;
+        StubRefProgram& operator=(const StubRefProgram&) = delete;
+
+        // DUT 执行第 i 条提交的写内存（经由 VMem 的写观察者通知 Difftest）
+        void dut_store(size_t i) {
+            const Commit& c = trace[i];
+            if (c.len) {
+                mem.notify_store(c.addr, c.len, c.data);
+                mem.write(c.addr, c.len, c.data);
+            }
+        }
+
+        // 第 round 轮的 sw 在提交序列中的序号（第一条是 lui，之后每轮三条，sw 是第二条）
+        static constexpr size_t store_inst(size_t round) { return 1 + 3 * round + 1; }
+
+        memory::VMem mem;
+        memory::VMem* prev;
+        utils::Difftest dt;
+        std::vector<Commit> trace;
+
+    private:
+        static std::vector<uint32_t> image() {
+            std::vector<uint32_t> img{0x80010137};
+            for (size_t i = 0; i < LOOP; i++) {
+                img.insert(img.end(), {0x00108093, SW, 0x00410113});
+            }
+            img.push_back(0x00100073);
+            return img;
+        }
+
+        // REF 内存恢复为程序镜像，数据区清零
+        void load_ref() {
+            std::vector<uint32_t> img = image();
+            img.resize((DATA_BASE - IMG_BASE) / 4 + LOOP, 0);
+            dt.memcpy(IMG_BASE, img.data(), img.size() * sizeof(uint32_t), DIFFTEST_TO_REF);
+        }
+    };
+
+} // namespace test
+
+#endif //ADAPTSIM_TEST_STUB_REF_PROGRAM_H
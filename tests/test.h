@@ -0,0 +1,49 @@
+// tests/test.h
+#ifndef ADAPTSIM_TEST_H
+#define ADAPTSIM_TEST_H
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace test
+{
+    using TestFn = std::function<void()>;
+
+    struct Case {
+        std::string name;
+        TestFn fn;
+    };
+
+    // 所有测试用例的注册表（按注册顺序运行）
+    std::vector<Case>& registry();
+
+    struct Registrar {
+        Registrar(const char* name, TestFn fn) {
+            registry().push_back({name, std::move(fn)});
+        }
+    };
+
+    // 记录一次检查失败；用例继续运行，结束后整体判为失败
+    void fail(const char* file, int line, const char* expr);
+
+    // 当前用例专用的临时文件路径，用例结束后删除
+    std::string temp_path(const std::string& name);
+
+} // namespace test
+
+#define TEST_CONCAT_IMPL(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_IMPL(a, b)
+// 在文件作用域注册一个测试用例；名称以 "<分组>/" 开头，ctest 按分组运行
+#define TEST_CASE(name, ...) \
+    static test::Registrar TEST_CONCAT(test_registrar_, __LINE__)(name, __VA_ARGS__)
+
+#define CHECK(expr) \
+    do { \
+        if (!(expr)) { \
+            test::fail(__FILE__, __LINE__, #expr); \
+        } \
+    } while (0)
+
+#endif //ADAPTSIM_TEST_H
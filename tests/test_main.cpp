@@ -0,0 +1,81 @@
+// tests/test_main.cpp
+//
+// adaptsim_tests 入口：依次运行名称包含给定子串的用例。
+// 用法: adaptsim_tests [名称子串]
+// 任一检查失败或没有匹配的用例时返回非零，供 ctest 使用。
+//
+
+#include "test.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+namespace test
+{
+    std::vector<Case>& registry() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    namespace
+    {
+        unsigned failures = 0;
+        std::vector<std::string> temp_files;
+    }
+
+    void fail(const char* file, int line, const char* expr) {
+        std::fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, expr);
+        failures++;
+    }
+
+    std::string temp_path(const std::string& name) {
+        std::error_code ec;
+        std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+        if (ec) {
+            dir = ".";
+        }
+        const std::string path = (dir / ("adaptsim_test_" + std::to_string(getpid()) + "_" + name)).string();
+        temp_files.push_back(path);
+        return path;
+    }
+
+    namespace
+    {
+        void remove_temp_files() {
+            for (const std::string& path : temp_files) {
+                std::error_code ec;
+                std::filesystem::remove(path, ec);
+            }
+            temp_files.clear();
+        }
+    }
+
+} // namespace test
+
+int main(int argc, char* argv[]) {
+    const std::string filter = argc > 1 ? argv[1] : "";
+    unsigned run = 0;
+    unsigned failed = 0;
+    for (const auto& c : test::registry()) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        const unsigned before = test::failures;
+        c.fn();
+        test::remove_temp_files();
+        const bool ok = test::failures == before;
+        std::printf("[%s] %s\n", ok ? " OK " : "FAIL", c.name.c_str());
+        std::fflush(stdout);
+        run++;
+        failed += !ok;
+    }
+    if (run == 0) {
+        std::fprintf(stderr, "adaptsim_tests: no test matches '%s'\n", filter.c_str());
+        return 1;
+    }
+    std::printf("%u/%u passed\n", run - failed, run);
+    return failed ? 1 : 0;
+}
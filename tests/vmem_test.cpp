@@ -0,0 +1,343 @@
+// tests/vmem_test.cpp
+//
+// VMem 写时复制快照：与逐字节的参考模型对照，覆盖脏页快速恢复与恢复到更早快照时的页表重建；
+// 以及镜像与 ELF 的装载。
+//
+
+#include "test.h"
+#include "AdaptSim/vmemory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <elf.h>
+#include <sys/stat.h>
+
+namespace
+{
+    using memory::MemSnapshot;
+    using memory::VMem;
+
+    constexpr uint32_t PAGE = VMem::PAGE_SIZE;
+    constexpr uint32_t IMG_BASE = 0x80000000;
+
+    // 参考模型：页地址 -> 页内容
+    using Shadow = std::map<uint32_t, std::vector<uint8_t>>;
+
+    bool same(VMem& mem, const Shadow& shadow) {
+        size_t n = 0;
+        bool ok = true;
+        mem.for_each_page([&](uint32_t addr, const uint8_t* data) {
+            n++;
+            const auto it = shadow.find(addr);
+            ok = ok && it != shadow.end() && std::memcmp(data, it->second.data(), PAGE) == 0;
+        });
+        return ok && n == shadow.size() && n == mem.allocated_pages();
+    }
+
+    void write_word(VMem& mem, Shadow& shadow, uint32_t addr, uint32_t value) {
+        mem.write(addr, 4, value);
+        for (uint32_t i = 0; i < 4; i++) {
+            std::vector<uint8_t>& page = shadow[(addr + i) & ~(PAGE - 1)];
+            if (page.empty()) {
+                page.resize(PAGE);
+            }
+            page[(addr + i) & (PAGE - 1)] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    void zero_range(VMem& mem, Shadow& shadow, uint32_t addr, uint32_t n) {
+        mem.zero_range(addr, n);
+        for (uint32_t i = 0; i < n; i++) {
+            const auto it = shadow.find((addr + i) & ~(PAGE - 1));
+            if (it != shadow.end()) {
+                it->second[(addr + i) & (PAGE - 1)] = 0;
+            }
+        }
+    }
+
+    // 一次随机改动：镜像内与镜像外的字写入（含跨页），偶尔清零一段
+    void mutate(VMem& mem, Shadow& shadow, std::mt19937& rng, uint32_t img_size) {
+        const int writes = static_cast<int>(rng() % 50);
+        for (int i = 0; i < writes; i++) {
+            uint32_t addr = rng() % 3 ? IMG_BASE + rng() % img_size : 0x90000000 + rng() % 65536;
+            if (rng() % 5 == 0) {
+                addr |= PAGE - 2; // 跨页
+            }
+            write_word(mem, shadow, addr, rng());
+        }
+        if (rng() % 7 == 0) {
+            zero_range(mem, shadow, IMG_BASE + rng() % img_size, 5000);
+        }
+    }
+
+    void snapshot_restore(memory::LoadMode mode) {
+        const uint32_t img_size = 64 * PAGE;
+        std::vector<uint8_t> img(img_size);
+        for (size_t i = 0; i < img.size(); i++) {
+            img[i] = static_cast<uint8_t>(i * 7);
+        }
+        const std::string path = test::temp_path("vmem.bin");
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(img.data()), img_size);
+
+        VMem mem;
+        Shadow shadow;
+        CHECK(mem.load_from_file(path, IMG_BASE, mode));
+        for (uint32_t off = 0; off < img_size; off += PAGE) {
+            shadow[IMG_BASE + off].assign(img.begin() + off, img.begin() + off + PAGE);
+        }
+        CHECK(!mem.tracking_dirty());
+        CHECK(mem.dirty_pages() == 0);
+
+        std::mt19937 rng(1);
+        const MemSnapshot first = mem.snapshot();
+        const Shadow first_shadow = shadow;
+        CHECK(first.page_count() == shadow.size());
+        std::vector<std::pair<MemSnapshot, Shadow>> snaps{{first, first_shadow}};
+        for (int round = 0; round < 200; round++) {
+            mutate(mem, shadow, rng, img_size);
+            CHECK(same(mem, shadow));
+            switch (rng() % 4) {
+                case 0:
+                    snaps.emplace_back(mem.snapshot(), shadow);
+                    CHECK(mem.dirty_pages() == 0);
+                    break;
+                case 1: {
+                    // 最近的快照：只还原脏页
+                    mem.restore(snaps.back().first);
+                    shadow = snaps.back().second;
+                    CHECK(same(mem, shadow));
+                    CHECK(mem.dirty_pages() == 0);
+                    break;
+                }
+                case 2: {
+                    // 任意一个更早的快照：重建页表
+                    const auto& [snap, snap_shadow] = snaps[rng() % snaps.size()];
+                    mem.restore(snap);
+                    shadow = snap_shadow;
+                    CHECK(same(mem, shadow));
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        // 之后的写入不影响已经取得的快照
+        mem.restore(first);
+        CHECK(same(mem, first_shadow));
+
+        // 脏页表按页记录，同一页多次写入只算一次，新分配的页也在其中
+        mem.write(IMG_BASE, 4, 1);
+        mem.write(IMG_BASE + 4, 4, 2);
+        mem.write(0xa0000000, 1, 3);
+        CHECK(mem.dirty_pages() == 2);
+        size_t live = 0;
+        mem.for_each_dirty_page([&](uint32_t, const uint8_t* data) { live += data != nullptr; });
+        CHECK(live == 2);
+        mem.restore(first);
+        CHECK(mem.read(0xa0000000, 1) == 0);
+        CHECK(same(mem, first_shadow));
+    }
+
+} // namespace
+
+TEST_CASE("vmem/snapshot_restore_copy", [] { snapshot_restore(memory::LoadMode::Copy); });
+TEST_CASE("vmem/snapshot_restore_mmap", [] { snapshot_restore(memory::LoadMode::Mmap); });
+
+TEST_CASE("vmem/snapshot_shares_pages", [] {
+    VMem mem;
+    mem.write(IMG_BASE, 4, 0x11111111);
+    const MemSnapshot snap = mem.snapshot();
+    // 快照之后写入复制该页，快照中的页保持原值
+    mem.write(IMG_BASE, 4, 0x22222222);
+    CHECK(mem.dirty_pages() == 1);
+    const MemSnapshot later = mem.snapshot();
+    mem.restore(snap);
+    CHECK(mem.read(IMG_BASE, 4) == 0x11111111);
+    mem.restore(later);
+    CHECK(mem.read(IMG_BASE, 4) == 0x22222222);
+});
+
+TEST_CASE("vmem/load_copy_and_mmap", [] {
+    // 非页对齐的装载地址与不足整页的结尾：两种模式得到相同内容，写入不会回写到文件
+    std::vector<uint8_t> img(3 * PAGE + PAGE / 2);
+    for (size_t i = 0; i < img.size(); i++) {
+        img[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    const std::string path = test::temp_path("image.bin");
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(img.data()), img.size());
+
+    for (const uint32_t base : {IMG_BASE, IMG_BASE + 100}) {
+        VMem copy;
+        VMem mapped;
+        CHECK(copy.load_from_file(path, base, memory::LoadMode::Copy));
+        CHECK(mapped.load_from_file(path, base, memory::LoadMode::Mmap));
+        bool same_bytes = true;
+        for (size_t i = 0; i < img.size(); i++) {
+            const uint32_t addr = base + static_cast<uint32_t>(i);
+            same_bytes = same_bytes && copy.read(addr, 1) == img[i] && mapped.read(addr, 1) == img[i];
+        }
+        CHECK(same_bytes);
+        mapped.write(base + PAGE, 4, 0xdeadbeef);
+        CHECK(mapped.read(base + PAGE, 4) == 0xdeadbeef);
+    }
+    std::vector<uint8_t> back(img.size());
+    std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(back.data()), back.size());
+    CHECK(back == img);
+
+    // 装不下的镜像被拒绝
+    VMem mem;
+    CHECK(!mem.load_from_file(path, 0xffffff00u));
+});
+
+TEST_CASE("vmem/load_elf", [] {
+    // 两个 PT_LOAD 段：代码段，以及带 .bss 的数据段
+    constexpr uint32_t TEXT = 0x80000000;
+    constexpr uint32_t DATA = 0x80003000;
+    constexpr uint32_t TEXT_SIZE = PAGE + 0x800;
+    constexpr uint32_t DATA_SIZE = 16;
+    constexpr uint32_t BSS_END = DATA + 2 * PAGE;
+    constexpr uint32_t PHOFF = sizeof(Elf32_Ehdr);
+    constexpr uint32_t TEXT_OFF = PAGE;
+    constexpr uint32_t DATA_OFF = TEXT_OFF + 2 * PAGE;
+
+    std::vector<uint8_t> file(DATA_OFF + DATA_SIZE);
+    Elf32_Ehdr ehdr{};
+    std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS32;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_type = ET_EXEC;
+    ehdr.e_machine = EM_RISCV;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_entry = TEXT + 0x10;
+    ehdr.e_phoff = PHOFF;
+    ehdr.e_ehsize = sizeof(Elf32_Ehdr);
+    ehdr.e_phentsize = sizeof(Elf32_Phdr);
+    ehdr.e_phnum = 2;
+    std::memcpy(file.data(), &ehdr, sizeof(ehdr));
+    const Elf32_Phdr phdrs[2] = {
+        {PT_LOAD, TEXT_OFF, TEXT, TEXT, TEXT_SIZE, TEXT_SIZE, PF_R | PF_X, PAGE},
+        {PT_LOAD, DATA_OFF, DATA, DATA, DATA_SIZE, BSS_END - DATA, PF_R | PF_W, PAGE},
+    };
+    std::memcpy(file.data() + PHOFF, phdrs, sizeof(phdrs));
+    for (uint32_t i = 0; i < TEXT_SIZE; i++) {
+        file[TEXT_OFF + i] = static_cast<uint8_t>(i * 3 + 1);
+    }
+    for (uint32_t i = 0; i < DATA_SIZE; i++) {
+        file[DATA_OFF + i] = static_cast<uint8_t>(0xa0 + i);
+    }
+    const std::string path = test::temp_path("image.elf");
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()), file.size());
+
+    for (const memory::LoadMode mode : {memory::LoadMode::Copy, memory::LoadMode::Mmap}) {
+        VMem mem;
+        // .bss 落在已有页上的部分要清零，没有分配过的页保持未分配
+        mem.write(DATA + 0x100, 4, 0xffffffff);
+        uint32_t entry = 0;
+        CHECK(mem.load_elf(path, &entry, mode));
+        CHECK(entry == TEXT + 0x10);
+        bool text_ok = true;
+        for (uint32_t i = 0; i < TEXT_SIZE; i++) {
+            text_ok = text_ok && mem.read(TEXT + i, 1) == file[TEXT_OFF + i];
+        }
+        CHECK(text_ok);
+        CHECK(mem.read(DATA, 4) == 0xa3a2a1a0);
+        CHECK(mem.read(DATA + 0x100, 4) == 0);
+        CHECK(mem.read(DATA + PAGE + 8, 4) == 0);
+        CHECK(mem.allocated_pages() == 3);
+    }
+
+    // 非 RISC-V 或损坏的文件被拒绝
+    file[offsetof(Elf32_Ehdr, e_machine)] = EM_386;
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(file.data()), file.size());
+    VMem mem;
+    CHECK(!mem.load_elf(path));
+    file[0] = 0;
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(file.data()), file.size());
+    CHECK(!mem.load_elf(path));
+});
+
+TEST_CASE("vmem/load_empty_and_unmappable", [] {
+    // 空镜像：成功且不分配页
+    const std::string empty = test::temp_path("empty.bin");
+    std::ofstream(empty, std::ios::binary).flush();
+    VMem mem;
+    CHECK(mem.load_from_file(empty, IMG_BASE, memory::LoadMode::Mmap));
+    CHECK(mem.load_from_file("/dev/null", IMG_BASE));
+    CHECK(mem.allocated_pages() == 0);
+    CHECK(!mem.load_from_file(test::temp_path("missing.bin"), IMG_BASE));
+
+    // 管道无法映射，退回逐段读取；内容跨越多个页且不是整页
+    const std::string fifo = test::temp_path("image.fifo");
+    CHECK(mkfifo(fifo.c_str(), 0600) == 0);
+    std::vector<uint8_t> img(3 * PAGE + 100);
+    for (size_t i = 0; i < img.size(); i++) {
+        img[i] = static_cast<uint8_t>(i * 13 + 1);
+    }
+    std::thread writer([&] {
+        std::ofstream(fifo, std::ios::binary).write(reinterpret_cast<const char*>(img.data()), img.size());
+    });
+    const bool loaded = mem.load_from_file(fifo, IMG_BASE, memory::LoadMode::Mmap);
+    writer.join();
+    CHECK(loaded);
+    CHECK(mem.allocated_pages() == 4);
+    bool same_bytes = true;
+    for (size_t i = 0; i < img.size(); i++) {
+        same_bytes = same_bytes && mem.read(IMG_BASE + static_cast<uint32_t>(i), 1) == img[i];
+    }
+    CHECK(same_bytes);
+});
+
+TEST_CASE("vmem/map_file_pages_and_take", [] {
+    // 检查点恢复的做法：先把文件中的页映射到临时实例，成功后再整体换进正在使用的内存
+    const std::string path = test::temp_path("pages.bin");
+    std::vector<uint8_t> data(3 * PAGE);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+    const uint32_t addrs[] = {IMG_BASE + 5 * PAGE, IMG_BASE, 0x1000};
+
+    VMem mem;
+    int notified = 0;
+    mem.set_store_observer([](void* user, uint32_t, uint32_t, uint32_t, uint32_t) { ++*static_cast<int*>(user); },
+                           &notified);
+    mem.write(IMG_BASE + 7 * PAGE, 4, 0x12345678);
+    mem.snapshot();
+
+    VMem restored;
+    CHECK(!restored.map_file_pages(path, addrs, 3, 100));         // 未对齐
+    CHECK(!restored.map_file_pages(path, addrs, 3, PAGE));        // 超出文件
+    CHECK(!restored.map_file_pages(test::temp_path("none"), addrs, 3, 0));
+    CHECK(restored.allocated_pages() == 0);
+    CHECK(restored.map_file_pages(path, addrs, 3, 0));
+
+    mem.take_pages(restored);
+    CHECK(restored.allocated_pages() == 0);
+    CHECK(mem.allocated_pages() == 3 && !mem.tracking_dirty());
+    CHECK(mem.read(IMG_BASE + 7 * PAGE, 4) == 0); // 原有的页被丢弃
+    bool same_bytes = true;
+    for (size_t p = 0; p < 3; p++) {
+        for (uint32_t i = 0; i < PAGE; i += 97) {
+            same_bytes = same_bytes && mem.read(addrs[p] + i, 1) == data[p * PAGE + i];
+        }
+    }
+    CHECK(same_bytes);
+    // 写时复制：改动内存不影响文件，写观察者仍挂在原实例上
+    CHECK(mem.has_store_observer());
+    mem.notify_store(IMG_BASE, 4, 0);
+    mem.write(IMG_BASE, 4, 0);
+    CHECK(notified == 1);
+    std::vector<uint8_t> again(data.size());
+    std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(again.data()), again.size());
+    CHECK(again == data);
+});
@@ -0,0 +1,198 @@
+// tests/wave_index_test.cpp
+//
+// VCD 旁路索引：对随机生成的波形按时间窗口查询，与直接重放整个文件的结果对照；
+// 裁剪出的窗口文件重新建索引后，查询结果与原文件一致。
+//
+
+#include "test.h"
+#include "AdaptSim/utils/waveindex.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    using Change = std::tuple<uint64_t, std::string, std::string>; // (时间, 信号名, 值)
+
+    struct VcdChange {
+        uint64_t time;
+        std::string id;
+        std::string value;
+    };
+
+    constexpr uint64_t END_TIME = 100000;
+
+    std::string bin(uint32_t v) {
+        std::string s;
+        do {
+            s.insert(s.begin(), static_cast<char>('0' + (v & 1)));
+            v >>= 1;
+        } while (v);
+        return "b" + s;
+    }
+
+    // 写出一个 VCD：clk 每个时间戳翻转，pc 与 valid 随机变化；IFU.pc 是 pc 的别名
+    std::vector<VcdChange> write_vcd(const std::string& path) {
+        std::ofstream out(path);
+        out << "$timescale 1ps $end\n"
+               "$scope module TOP $end\n"
+               "$scope module core $end\n"
+               "$var wire 1 ! clk $end\n"
+               "$var wire 32 \" pc [31:0] $end\n"
+               "$var wire 1 # valid $end\n"
+               "$scope module IFU $end\n"
+               "$var wire 32 \" pc [31:0] $end\n"
+               "$upscope $end\n"
+               "$upscope $end\n"
+               "$upscope $end\n"
+               "$enddefinitions $end\n"
+               "#0\n$dumpvars\n0!\nb0 \"\n0#\n$end\n";
+        std::vector<VcdChange> changes{{0, "!", "0"}, {0, "\"", "b0"}, {0, "#", "0"}};
+
+        std::mt19937 rng(11);
+        bool clk = false;
+        bool valid = false;
+        uint32_t pc = 0;
+        for (uint64_t t = 5; t <= END_TIME; t += 5) {
+            out << '#' << t << '\n';
+            clk = !clk;
+            out << clk << "!\n";
+            changes.push_back({t, "!", clk ? "1" : "0"});
+            if (rng() % 2) {
+                pc = rng() % 3 ? pc + 4 : static_cast<uint32_t>(rng());
+                out << bin(pc) << " \"\n";
+                changes.push_back({t, "\"", bin(pc)});
+            }
+            if (rng() % 5 == 0) {
+                valid = !valid;
+                out << valid << "#\n";
+                changes.push_back({t, "#", valid ? "1" : "0"});
+            }
+        }
+        return changes;
+    }
+
+    // 直接重放全部变化得到的查询结果
+    std::vector<Change> replay(const std::vector<VcdChange>& changes, const std::vector<utils::WaveSignal>& sigs,
+                               uint64_t t0, uint64_t t1, const std::vector<size_t>& selected) {
+        std::map<std::string, std::string> cur;
+        size_t k = 0;
+        for (; k < changes.size() && changes[k].time <= t0; k++) {
+            cur[changes[k].id] = changes[k].value;
+        }
+        std::vector<Change> out;
+        for (size_t i : selected) {
+            out.emplace_back(t0, sigs[i].name, cur[sigs[i].id]);
+        }
+        for (; k < changes.size() && changes[k].time <= t1; k++) {
+            for (size_t i : selected) {
+                if (sigs[i].id == changes[k].id) {
+                    out.emplace_back(changes[k].time, sigs[i].name, changes[k].value);
+                }
+            }
+        }
+        return out;
+    }
+
+    std::vector<Change> query(utils::WaveIndex& index, uint64_t t0, uint64_t t1, const std::vector<size_t>& selected) {
+        std::vector<Change> out;
+        CHECK(index.values(t0, t1, selected, [&](uint64_t t, size_t i, const std::string& v) {
+            out.emplace_back(t, index.signals()[i].name, v);
+        }));
+        return out;
+    }
+
+    std::vector<size_t> all_signals(const utils::WaveIndex& index) {
+        std::vector<size_t> sel(index.signals().size());
+        for (size_t i = 0; i < sel.size(); i++) {
+            sel[i] = i;
+        }
+        return sel;
+    }
+
+    // 小间隔的检查点和时间标记，让查询与裁剪都跨越多个检查点
+    constexpr utils::WaveIndexOptions OPTS{4096, 512};
+
+} // namespace
+
+TEST_CASE("wave_index/query", [] {
+    const std::string vcd = test::temp_path("wave.vcd");
+    const std::string idx = test::temp_path("wave.vcd.widx");
+    const std::vector<VcdChange> changes = write_vcd(vcd);
+    CHECK(utils::build_wave_index(vcd, idx, OPTS));
+
+    utils::WaveIndex index;
+    CHECK(index.open(vcd, idx) && !index.stale());
+    CHECK(index.header().n_slots == 3);
+    CHECK(index.header().end_time == END_TIME);
+    CHECK(index.header().n_checkpoints > 10);
+    CHECK(index.signals().size() == 4);
+
+    // 无通配符时按后缀匹配，别名各算一个信号
+    CHECK(index.find("pc").size() == 2);
+    CHECK(index.find("IFU.pc").size() == 1);
+    CHECK(index.find("TOP.core.clk").size() == 1);
+    CHECK(index.find("TOP.core.*").size() == 4);
+    CHECK(index.find("*.v?lid").size() == 1);
+    CHECK(index.find("lk").empty());
+
+    const std::vector<size_t> pcs = index.find("pc");
+    const std::vector<size_t> all = all_signals(index);
+    std::mt19937 rng(13);
+    std::vector<std::pair<uint64_t, uint64_t>> windows{
+        {0, 0}, {0, END_TIME}, {50000, 50500}, {12343, 12999}, {END_TIME, END_TIME + 100}, {END_TIME + 5, END_TIME + 10}};
+    for (int i = 0; i < 20; i++) {
+        const uint64_t t0 = rng() % END_TIME;
+        windows.emplace_back(t0, t0 + rng() % 3000);
+    }
+    for (const auto& [t0, t1] : windows) {
+        CHECK(query(index, t0, t1, all) == replay(changes, index.signals(), t0, t1, all));
+        CHECK(query(index, t0, t1, pcs) == replay(changes, index.signals(), t0, t1, pcs));
+    }
+
+    // VCD 改变后索引过期
+    std::ofstream(vcd, std::ios::app) << "#" << END_TIME + 5 << "\n1!\n";
+    utils::WaveIndex reopened;
+    CHECK(!reopened.open(vcd, idx) && reopened.stale());
+});
+
+TEST_CASE("wave_index/trim", [] {
+    const std::string vcd = test::temp_path("wave.vcd");
+    const std::string idx = test::temp_path("wave.vcd.widx");
+    const std::string cut = test::temp_path("cut.vcd");
+    const std::string cut_idx = test::temp_path("cut.vcd.widx");
+    write_vcd(vcd);
+    CHECK(utils::build_wave_index(vcd, idx, OPTS));
+    utils::WaveIndex index;
+    CHECK(index.open(vcd, idx));
+
+    const std::vector<std::vector<size_t>> selections{{}, index.find("TOP.core.pc"), index.find("*clk")};
+    for (const auto& [t0, t1] : {std::pair<uint64_t, uint64_t>{30000, 42000}, {12343, 12999}, {0, 200}}) {
+        for (const std::vector<size_t>& sel : selections) {
+            std::FILE* out = std::fopen(cut.c_str(), "wb");
+            CHECK(out && index.trim(t0, t1, sel, out));
+            std::fclose(out);
+
+            CHECK(utils::build_wave_index(cut, cut_idx, OPTS));
+            utils::WaveIndex trimmed;
+            CHECK(trimmed.open(cut, cut_idx));
+            const std::vector<size_t> want = sel.empty() ? all_signals(index) : sel;
+            CHECK(trimmed.signals().size() == want.size());
+            CHECK(trimmed.header().end_time <= t1);
+            // 裁剪结果中信号的顺序可能不同，按名称对应
+            std::vector<size_t> mapped;
+            for (size_t i : want) {
+                const std::vector<size_t> hit = trimmed.find(index.signals()[i].name);
+                CHECK(hit.size() == 1);
+                mapped.push_back(hit.empty() ? 0 : hit.front());
+            }
+            CHECK(query(trimmed, t0, t1, mapped) == query(index, t0, t1, want));
+        }
+    }
+});
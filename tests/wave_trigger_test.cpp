@@ -0,0 +1,87 @@
+// tests/wave_trigger_test.cpp
+//
+// 触发式波形窗口：窗口描述解析，以及 poll 在各类窗口下的开关文件时机。
+//
+
+#include "test.h"
+#include "AdaptSim/utils/wavetrace.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    using utils::WaveTrigger;
+    using utils::WaveTriggerEvent;
+    using utils::WaveWindow;
+
+    bool quiet(const WaveTriggerEvent& ev) {
+        return !ev.close && ev.open < 0;
+    }
+
+} // namespace
+
+TEST_CASE("wave_trigger/parse", [] {
+    WaveWindow w{};
+    CHECK(utils::parse_wave_window("pc:0x80000000-0x80000100", w));
+    CHECK(w.trigger == WaveWindow::Trigger::PcRange && w.begin == 0x80000000 && w.end == 0x80000100);
+    CHECK(utils::parse_wave_window("inst:1000-2000", w));
+    CHECK(w.trigger == WaveWindow::Trigger::InstCount && w.begin == 1000 && w.end == 2000);
+    CHECK(utils::parse_wave_window("cycle:5000-6000", w));
+    CHECK(w.trigger == WaveWindow::Trigger::CycleRange && w.begin == 5000 && w.end == 6000);
+
+    CHECK(!utils::parse_wave_window("time:1-2", w));
+    CHECK(!utils::parse_wave_window("inst:2000-1000", w));
+    CHECK(!utils::parse_wave_window("inst:abc-10", w));
+    CHECK(!utils::parse_wave_window("inst1000-2000", w));
+});
+
+TEST_CASE("wave_trigger/cycle_window", [] {
+    WaveTrigger trig({{WaveWindow::Trigger::CycleRange, 100, 200}});
+    CHECK(!trig.empty() && !trig.recording());
+    CHECK(trig.next_cycle_event() == 100);
+
+    WaveTriggerEvent ev = trig.poll(0, 0, 100, false);
+    CHECK(!ev.close && ev.open == 0 && trig.recording());
+    CHECK(trig.next_cycle_event() == 200);
+    CHECK(quiet(trig.poll(0, 5, 150, true)));
+
+    ev = trig.poll(0, 0, 200, false);
+    CHECK(ev.close && ev.open < 0 && !trig.recording());
+    CHECK(trig.next_cycle_event() == UINT64_MAX);
+    CHECK(quiet(trig.poll(0, 0, 150, false))); // 只触发一次
+});
+
+TEST_CASE("wave_trigger/inst_window", [] {
+    WaveTrigger trig({{WaveWindow::Trigger::InstCount, 10, 20}});
+    CHECK(trig.next_cycle_event() == UINT64_MAX);
+    CHECK(quiet(trig.poll(0, 9, 30, true)));
+    CHECK(quiet(trig.poll(0, 10, 31, false))); // 指令数窗口只在提交时判断
+    CHECK(trig.poll(0, 10, 32, true).open == 0);
+    CHECK(quiet(trig.poll(0, 15, 40, true)));
+    CHECK(trig.poll(0, 20, 50, true).close && !trig.recording());
+    CHECK(quiet(trig.poll(0, 15, 60, true)));
+});
+
+TEST_CASE("wave_trigger/pc_window_max_files", [] {
+    WaveTrigger trig({{WaveWindow::Trigger::PcRange, 0x100, 0x200}}, 2);
+    CHECK(trig.poll(0x100, 1, 1, true).open == 0);
+    CHECK(quiet(trig.poll(0x104, 2, 2, true)));
+    CHECK(trig.poll(0x300, 3, 3, true).close);
+    // 再次进入区间时重新打开，直到用完文件数
+    CHECK(trig.poll(0x150, 4, 4, true).open == 0);
+    CHECK(trig.poll(0x400, 5, 5, true).close);
+    CHECK(quiet(trig.poll(0x150, 6, 6, true)) && !trig.recording());
+});
+
+TEST_CASE("wave_trigger/overlapping_windows", [] {
+    WaveTrigger trig({{WaveWindow::Trigger::InstCount, 10, 30},
+                      {WaveWindow::Trigger::CycleRange, 50, 100}});
+    CHECK(trig.poll(0, 10, 20, true).open == 0);
+    // 周期窗口在已有输出时激活，共用当前文件
+    CHECK(quiet(trig.poll(0, 0, 50, false)) && trig.recording());
+    CHECK(trig.next_cycle_event() == 100);
+    CHECK(quiet(trig.poll(0, 30, 60, true)) && trig.recording());
+    WaveTriggerEvent ev = trig.poll(0, 0, 100, false);
+    CHECK(ev.close && ev.open < 0 && !trig.recording());
+});
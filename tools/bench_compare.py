@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""
+对比两次 sim_bench --json 的结果，找出性能回退。
+用法: bench_compare.py <基线.json> <本次.json> [--tolerance 0.10] [--filter 子串]
+按 ops_per_sec 比较；任一用例比基线慢超过 tolerance 时以状态 1 退出。
+只出现在一侧的用例只列出，不算回退。
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, encoding='utf-8') as f:
+        return {r['name']: r for r in json.load(f)['results']}
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Compare sim_bench JSON results against a baseline.')
+    ap.add_argument('baseline')
+    ap.add_argument('current')
+    ap.add_argument('--tolerance', type=float, default=0.10, help='allowed slowdown ratio (default 0.10)')
+    ap.add_argument('--filter', default='', help='only compare benchmarks whose name contains this')
+    args = ap.parse_args()
+
+    base = load(args.baseline)
+    cur = load(args.current)
+    names = [n for n in list(base) + [n for n in cur if n not in base] if args.filter in n]
+
+    regressions = 0
+    print(f'{"benchmark":<36} {"base Mops/s":>12} {"now Mops/s":>12} {"change":>9}')
+    for name in names:
+        b, c = base.get(name), cur.get(name)
+        if b is None or c is None:
+            print(f'{name:<36} {"-" if b is None else b["ops_per_sec"] / 1e6:>12} '
+                  f'{"-" if c is None else c["ops_per_sec"] / 1e6:>12} {"n/a":>9}')
+            continue
+        change = c['ops_per_sec'] / b['ops_per_sec'] - 1.0 if b['ops_per_sec'] else 0.0
+        mark = ''
+        if change < -args.tolerance:
+            mark = '  REGRESSION'
+            regressions += 1
+        print(f'{name:<36} {b["ops_per_sec"] / 1e6:>12.2f} {c["ops_per_sec"] / 1e6:>12.2f} {change:>+8.1%}{mark}')
+
+    if regressions:
+        print(f'{regressions} benchmark(s) slower than baseline by more than {args.tolerance:.0%}', file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
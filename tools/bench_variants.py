@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""
+对比各 Vcore 模型变体的 sim_bench --json 结果，选出本机上最快的变体。
+用法: bench_variants.py <结果.json> [<结果.json> ...] [--filter core_]
+每个文件对应一个变体（取文件中的 "variant" 字段）；按所选用例 ops_per_sec 的几何平均排名。
+"""
+import argparse
+import json
+import math
+import sys
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Rank Vcore model variants by sim_bench results.')
+    ap.add_argument('results', nargs='+')
+    ap.add_argument('--filter', default='core_', help='only use benchmarks whose name contains this')
+    args = ap.parse_args()
+
+    variants = []
+    for path in args.results:
+        with open(path, encoding='utf-8') as f:
+            data = json.load(f)
+        rates = {r['name']: r['ops_per_sec'] for r in data['results'] if args.filter in r['name']}
+        variants.append((data.get('variant', path), rates))
+
+    names = sorted({n for _, rates in variants for n in rates})
+    # 只用所有变体都有的用例计算几何平均，缺项的变体不会因此占便宜
+    common = [n for n in names if all(n in rates for _, rates in variants)]
+    if not common:
+        print('no benchmark shared by all variants', file=sys.stderr)
+        return 1
+
+    width = max(12, *(len(v) for v, _ in variants))
+    print(f'{"benchmark":<36}' + ''.join(f' {v:>{width}}' for v, _ in variants))
+    for n in names:
+        cells = ''.join(f' {rates[n] / 1e6:>{width}.3f}' if n in rates else f' {"-":>{width}}' for _, rates in variants)
+        print(f'{n:<36}{cells}')
+
+    scores = [(v, math.exp(sum(math.log(rates[n]) for n in common) / len(common))) for v, rates in variants]
+    print(f'{"geomean Mops/s":<36}' + ''.join(f' {s / 1e6:>{width}.3f}' for _, s in scores))
+    best, best_score = max(scores, key=lambda x: x[1])
+    print(f'fastest variant on this host: {best}')
+    for v, s in scores:
+        if v != best:
+            print(f'  {v}: {s / best_score - 1.0:+.1%}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
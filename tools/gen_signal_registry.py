@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""
+根据 Verilator 生成的 Vcore___024root.h 生成信号注册表 (名称 -> 访问函数/位宽)。
+用法: gen_signal_registry.py <Vcore___024root.h> <输出 .cpp>
+输入文件不存在时报错退出：空表会让 GPR 等内部信号全部读成 0。
+"""
+import os
+import re
+import sys
+
+# CData/*0:0*/ core__DOT__validReg;   VlWide<3>/*95:0*/ core__DOT__x;
+MEMBER_RE = re.compile(r'^\s*(CData|SData|IData|QData|VlWide<(\d+)>)\s*/\*(\d+):(\d+)\*/\s*(\w+)\s*;')
+# VL_IN8(&clock,0,0);   VL_OUT(io_debugPC,31,0);   VL_OUTW(x,95,0,3);
+PORT_RE = re.compile(r'^\s*VL_(?:IN|OUT|INOUT)(8|16|64|W)?\(\s*&?(\w+)\s*,\s*(\d+)\s*,\s*(\d+)\s*(?:,\s*(\d+)\s*)?\)\s*;')
+
+TYPE_BYTES = {'CData': 1, 'SData': 2, 'IData': 4, 'QData': 8}
+PORT_BYTES = {'8': 1, '16': 2, None: 4, '64': 8}
+
+
+def parse(path):
+    signals = []
+    seen = set()
+    with open(path, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            m = MEMBER_RE.match(line)
+            if m:
+                ctype, words, msb, lsb, name = m.groups()
+                nbytes = 4 * int(words) if words else TYPE_BYTES[ctype]
+            else:
+                m = PORT_RE.match(line)
+                if not m:
+                    continue
+                kind, name, msb, lsb, words = m.groups()
+                nbytes = 4 * int(words) if kind == 'W' else PORT_BYTES[kind]
+            if name.startswith('__V') or name in seen:
+                continue
+            seen.add(name)
+            signals.append((name, int(msb) - int(lsb) + 1, nbytes))
+    return signals
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: gen_signal_registry.py <Vcore___024root.h> <out.cpp>')
+    src, out = sys.argv[1], sys.argv[2]
+    if not os.path.exists(src):
+        sys.exit('gen_signal_registry.py: %s not found (run Verilator first)' % src)
+    signals = parse(src)
+    if not signals:
+        sys.exit('gen_signal_registry.py: no signals found in %s' % src)
+
+    lines = [
+        '// 由 tools/gen_signal_registry.py 根据 Vcore___024root.h 自动生成，请勿手动修改',
+        '#include "AdaptSim/multicore/signals.h"',
+        '#include "Vcore.h"',
+        '#include "Vcore___024root.h"',
+        '',
+        'namespace multiple::detail {',
+        '',
+        '    static const SignalDesc table[] = {',
+    ]
+    for name, width, nbytes in signals:
+        lines.append('        {"%s", [](Vcore___024root* r) -> void* { return &r->%s; }, %d, %d},'
+                     % (name, name, width, nbytes))
+    lines += [
+        '        {nullptr, nullptr, 0, 0},',
+        '    };',
+        '',
+        '    const SignalDesc* const SIGNAL_TABLE = table;',
+        '    const size_t SIGNAL_TABLE_SIZE = %d;' % len(signals),
+        '',
+        '} // namespace multiple::detail',
+        '',
+    ]
+    text = '\n'.join(lines)
+    # 内容不变时不改写文件，避免无谓的重新编译
+    if os.path.exists(out):
+        with open(out, encoding='utf-8') as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(os.path.abspath(out)), exist_ok=True)
+    with open(out, 'w', encoding='utf-8') as f:
+        f.write(text)
+
+
+if __name__ == '__main__':
+    main()
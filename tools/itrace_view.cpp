@@ -0,0 +1,57 @@
+// tools/itrace_view.cpp
+//
+// 离线查看 InstTraceWriter 生成的指令提交日志，按需反汇编。
+// 用法: itrace_view <itrace.bin> [-s 起始序号] [-n 条数] [--raw]
+//   --raw 不反汇编，只输出 pc / 编码 / 写回
+//
+
+#include "AdaptSim/utils/itrace.h"
+#include "AdaptSim/utils/disasm.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <itrace.bin> [-s start] [-n count] [--raw]\n", argv[0]);
+        return 1;
+    }
+    uint64_t start = 0;
+    uint64_t count = UINT64_MAX;
+    bool raw = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            start = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "--raw") == 0) {
+            raw = true;
+        }
+    }
+
+    utils::InstTraceReader reader;
+    if (!reader.open(argv[1]) || !reader.seek(start)) {
+        return 1;
+    }
+
+    utils::InstTraceEntry e{};
+    for (uint64_t n = 0; n < count && reader.next(e); ++n) {
+        std::string text;
+        if (raw) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%08x: %08x", e.pc, e.inst);
+            text = buf;
+        } else {
+            text = utils::disassemble(e.pc, e.inst);
+        }
+        if (e.rd) {
+            std::printf("%10llu  %s    x%u <- 0x%08x\n", static_cast<unsigned long long>(e.index),
+                        text.c_str(), e.rd, e.rd_value);
+        } else {
+            std::printf("%10llu  %s\n", static_cast<unsigned long long>(e.index), text.c_str());
+        }
+    }
+    return 0;
+}
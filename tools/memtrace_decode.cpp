@@ -0,0 +1,57 @@
+// tools/memtrace_decode.cpp
+//
+// 离线解码 MemTrace 二进制访存追踪文件，按文本逐条输出。
+// 用法: memtrace_decode <trace.bin> [-r | -w]
+//   -r 只输出读，-w 只输出写
+//
+
+#include "AdaptSim/utils/memtrace.h"
+
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char* argv[]) {
+    int only = -1; // -1 全部, 0 只读, 1 只写
+    if (argc == 3 && std::strcmp(argv[2], "-r") == 0) {
+        only = 0;
+    } else if (argc == 3 && std::strcmp(argv[2], "-w") == 0) {
+        only = 1;
+    } else if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <trace.bin> [-r | -w]\n", argv[0]);
+        return 1;
+    }
+
+    std::FILE* f = std::fopen(argv[1], "rb");
+    if (!f) {
+        std::fprintf(stderr, "Error: cannot open '%s'\n", argv[1]);
+        return 1;
+    }
+
+    utils::MemTraceFileHeader hdr{};
+    if (std::fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        std::memcmp(hdr.magic, utils::MEMTRACE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != utils::MEMTRACE_VERSION || hdr.record_size != sizeof(utils::MemTraceRecord)) {
+        std::fprintf(stderr, "Error: '%s' is not a memory trace (version %u)\n", argv[1], utils::MEMTRACE_VERSION);
+        std::fclose(f);
+        return 1;
+    }
+
+    utils::MemTraceRecord buf[4096];
+    size_t n;
+    unsigned long long total = 0;
+    while ((n = std::fread(buf, sizeof(buf[0]), std::size(buf), f)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            const utils::MemTraceRecord& r = buf[i];
+            if (only >= 0 && r.is_write != only) {
+                continue;
+            }
+            std::printf("%12llu %s addr=0x%08x len=%u data=0x%08x\n",
+                        static_cast<unsigned long long>(r.cycle), r.is_write ? "W" : "R",
+                        r.addr, r.len, r.data);
+            ++total;
+        }
+    }
+    std::fclose(f);
+    std::fprintf(stderr, "%llu records\n", total);
+    return 0;
+}
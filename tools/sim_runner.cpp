@@ -0,0 +1,313 @@
+// tools/sim_runner.cpp
+//
+// 批量回归：在一个进程内用工作窃取线程池并行跑多个测试镜像，每个测试一个 SimContext。
+// 用法: sim_runner <镜像目录 | 清单文件> [-j 线程数] [--max-insts N] [--max-cycles N] [--hang-cycles N]
+//                  [--ref nemu.so] [--ref-mem-size N] [--history 上次结果.jsonl] [-o 结果.jsonl] [-v]
+//   清单每行: <镜像路径> [预计开销]，# 开头为注释；相对路径相对于清单所在目录
+//   结果为 JSON lines，每个测试一行；开销大的测试先调度
+//
+
+#include "AdaptSim/multicore/context.h"
+#include "AdaptSim/multicore/core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr uint32_t IMG_BASE = 0x80000000;
+
+    struct Options {
+        unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+        uint64_t max_insts = 0;             // 0 表示不限
+        uint64_t max_cycles = 100000000;
+        uint64_t hang_cycles = 0;           // 0 表示使用 cfg.hang_cycles
+        std::string ref;
+        uint64_t ref_mem_size = 8u << 20;   // 启用 difftest 时同步给 REF 的镜像区间大小
+        std::string history;
+        std::string output = "-";
+        bool verbose = false;
+    };
+
+    struct Job {
+        std::string image;
+        uint64_t weight; // 预计开销，越大越先调度
+    };
+
+    struct Result {
+        const char* status; // pass / fail / timeout / hang / mismatch / error
+        int halt_ret = 0;
+        uint64_t insts = 0;
+        uint64_t cycles = 0;
+        double wall_ms = 0;
+    };
+
+    // 每个线程一个队列。所有任务在开始前已知，因此队列空了就去别的队列窃取，全部为空即结束。
+    class WorkQueues {
+    public:
+        explicit WorkQueues(size_t n) : queues(n) {}
+
+        // jobs 已按开销降序排好，轮流分给各线程，使每个线程都从长任务开始
+        void deal(size_t n_jobs) {
+            for (size_t i = 0; i < n_jobs; i++) {
+                queues[i % queues.size()].jobs.push_back(i);
+            }
+        }
+
+        bool pop(size_t self, size_t& job) {
+            // 自己和窃取都取队首（剩余开销最大者），让长任务尽早开跑、缩短批次尾部
+            for (size_t k = 0; k < queues.size(); k++) {
+                Queue& q = queues[(self + k) % queues.size()];
+                std::lock_guard<std::mutex> lock(q.m);
+                if (!q.jobs.empty()) {
+                    job = q.jobs.front();
+                    q.jobs.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct Queue {
+            std::mutex m;
+            std::deque<size_t> jobs;
+        };
+        std::vector<Queue> queues;
+    };
+
+    bool is_elf(const std::string& path) {
+        char magic[4] = {};
+        std::ifstream f(path, std::ios::binary);
+        f.read(magic, sizeof(magic));
+        return f && std::memcmp(magic, "\x7f" "ELF", 4) == 0;
+    }
+
+    // 从上一次的结果中读出每个镜像实际用掉的周期数，作为本次的开销估计
+    std::unordered_map<std::string, uint64_t> load_history(const std::string& path) {
+        std::unordered_map<std::string, uint64_t> cost;
+        std::ifstream f(path);
+        std::string line;
+        while (std::getline(f, line)) {
+            const size_t img = line.find("\"image\":\"");
+            const size_t cyc = line.find("\"cycles\":");
+            if (img == std::string::npos || cyc == std::string::npos) {
+                continue;
+            }
+            const size_t begin = img + 9;
+            const size_t end = line.find('"', begin);
+            cost[line.substr(begin, end - begin)] = std::strtoull(line.c_str() + cyc + 9, nullptr, 10);
+        }
+        return cost;
+    }
+
+    std::vector<Job> collect_jobs(const std::string& source, const std::string& history) {
+        std::vector<Job> jobs;
+        std::error_code ec;
+        if (fs::is_directory(source, ec)) {
+            for (const auto& entry : fs::directory_iterator(source, ec)) {
+                if (entry.is_regular_file()) {
+                    jobs.push_back({entry.path().string(), static_cast<uint64_t>(entry.file_size())});
+                }
+            }
+        } else {
+            std::ifstream f(source);
+            if (!f) {
+                std::fprintf(stderr, "sim_runner: cannot open %s\n", source.c_str());
+                return jobs;
+            }
+            const fs::path base = fs::path(source).parent_path();
+            std::string line;
+            while (std::getline(f, line)) {
+                std::istringstream in(line);
+                std::string path;
+                if (!(in >> path) || path[0] == '#') {
+                    continue;
+                }
+                uint64_t weight = 0;
+                if (!(in >> weight)) {
+                    weight = fs::file_size(base / path, ec);
+                }
+                jobs.push_back({fs::path(path).is_absolute() ? path : (base / path).string(), weight});
+            }
+        }
+        if (!history.empty()) {
+            const auto cost = load_history(history);
+            for (Job& job : jobs) {
+                if (auto it = cost.find(job.image); it != cost.end()) {
+                    job.weight = it->second;
+                }
+            }
+        }
+        std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.weight > b.weight; });
+        return jobs;
+    }
+
+    Result run_one(const Job& job, const Options& opt) {
+        const auto t0 = std::chrono::steady_clock::now();
+        Result r{"error"};
+
+        multiple::cfg conf = multiple::cfg_inst;
+        conf.trace_enabled = false;
+        conf.inst_trace_enabled = false;
+        conf.mem_trace_enabled = false;
+        conf.diff_enaled = !opt.ref.empty();
+        conf.diff_ref_path = opt.ref;
+        conf.img_path = job.image;
+        conf.mmap_img = true; // 同一镜像被多次运行时共享只读页
+
+        multiple::SimContext ctx(conf);
+        const bool loaded = is_elf(job.image)
+            ? ctx.mem.load_elf(job.image, nullptr, memory::LoadMode::Mmap)
+            : ctx.mem.load_from_file(job.image, IMG_BASE, memory::LoadMode::Mmap);
+        if (!loaded) {
+            return r;
+        }
+
+        multiple::Sim_core core(ctx);
+        core.sim_init();
+        if (conf.diff_enaled) {
+            utils::Difftest* dt = ctx.create_difftest(0);
+            if (!dt || !dt->is_good()) {
+                return r;
+            }
+            std::vector<uint8_t> img(opt.ref_mem_size);
+            ctx.mem.read_bytes(IMG_BASE, img.data(), img.size());
+            dt->memcpy(IMG_BASE, img.data(), img.size(), DIFFTEST_TO_REF);
+            core.attach_difftest(dt);
+        }
+
+        multiple::StopConditions stop;
+        stop.max_insts = opt.max_insts;
+        stop.max_cycles = opt.max_cycles;
+        stop.hang_cycles = opt.hang_cycles;
+        multiple::RunResult run = core.run(stop);
+        if (!core.finish_difftest()) {
+            run.reason = multiple::RunExit::Mismatch;
+            ctx.cpu_state.state = multiple::CPU_STATES::CPU_ABORT;
+        }
+
+        switch (run.reason) {
+            case multiple::RunExit::Halt: r.status = ctx.is_exit_status_bad() ? "fail" : "pass"; break;
+            case multiple::RunExit::Mismatch: r.status = "mismatch"; break;
+            case multiple::RunExit::Hang: r.status = "hang"; break;
+            default: r.status = "timeout"; break;
+        }
+        r.halt_ret = ctx.cpu_state.halt_ret;
+        r.insts = core.get_inst_count();
+        r.cycles = core.get_cycle_count();
+        r.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return r;
+    }
+
+    std::string json_escape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        return out;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr,
+                     "usage: %s <image-dir|manifest> [-j N] [--max-insts N] [--max-cycles N] [--hang-cycles N]\n"
+                     "          [--ref so] [--ref-mem-size N] [--history prev.jsonl] [-o out.jsonl] [-v]\n", argv[0]);
+        return 1;
+    }
+    Options opt;
+    for (int i = 2; i < argc; ++i) {
+        const bool has_arg = i + 1 < argc;
+        if (std::strcmp(argv[i], "-j") == 0 && has_arg) {
+            opt.jobs = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+        } else if (std::strcmp(argv[i], "--max-insts") == 0 && has_arg) {
+            opt.max_insts = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "--max-cycles") == 0 && has_arg) {
+            opt.max_cycles = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "--hang-cycles") == 0 && has_arg) {
+            opt.hang_cycles = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "--ref") == 0 && has_arg) {
+            opt.ref = argv[++i];
+        } else if (std::strcmp(argv[i], "--ref-mem-size") == 0 && has_arg) {
+            opt.ref_mem_size = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "--history") == 0 && has_arg) {
+            opt.history = argv[++i];
+        } else if (std::strcmp(argv[i], "-o") == 0 && has_arg) {
+            opt.output = argv[++i];
+        } else if (std::strcmp(argv[i], "-v") == 0) {
+            opt.verbose = true;
+        }
+    }
+
+    const std::vector<Job> jobs = collect_jobs(argv[1], opt.history);
+    if (jobs.empty()) {
+        std::fprintf(stderr, "sim_runner: no images found in %s\n", argv[1]);
+        return 1;
+    }
+    std::FILE* out = opt.output == "-" ? stdout : std::fopen(opt.output.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "sim_runner: cannot write %s\n", opt.output.c_str());
+        return 1;
+    }
+    // 各仿真组件的提示信息写在 std::cout 上，批量运行时关掉，结果直接写到 out
+    if (!opt.verbose) {
+        std::cout.rdbuf(nullptr);
+    }
+
+    const size_t n_threads = std::min<size_t>(opt.jobs, jobs.size());
+    WorkQueues queues(n_threads);
+    queues.deal(jobs.size());
+    std::mutex out_mutex;
+    std::atomic<size_t> failed{0};
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < n_threads; t++) {
+        workers.emplace_back([&, t] {
+            size_t idx;
+            while (queues.pop(t, idx)) {
+                const Result r = run_one(jobs[idx], opt);
+                if (std::strcmp(r.status, "pass") != 0) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+                const double ipc = r.cycles ? static_cast<double>(r.insts) / static_cast<double>(r.cycles) : 0.0;
+                std::lock_guard<std::mutex> lock(out_mutex);
+                std::fprintf(out,
+                             "{\"image\":\"%s\",\"status\":\"%s\",\"halt_ret\":%d,\"insts\":%llu,\"cycles\":%llu,"
+                             "\"ipc\":%.4f,\"wall_ms\":%.3f,\"worker\":%zu}\n",
+                             json_escape(jobs[idx].image).c_str(), r.status, r.halt_ret,
+                             static_cast<unsigned long long>(r.insts), static_cast<unsigned long long>(r.cycles),
+                             ipc, r.wall_ms, t);
+                std::fflush(out);
+            }
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    std::fprintf(stderr, "sim_runner: %zu/%zu passed\n", jobs.size() - failed.load(), jobs.size());
+    return failed.load() ? 1 : 0;
+}
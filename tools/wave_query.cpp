@@ -0,0 +1,199 @@
+// tools/wave_query.cpp
+//
+// 基于旁路索引查询大 VCD 波形（Sim_core 追踪输出的 wave.vcd 等）的时间窗口，耗时与窗口大小而不是文件大小成正比。
+// 用法:
+//   wave_query index  <wave.vcd> [-c 检查点间隔MB] [-m 时间标记间隔KB]    顺序读一遍，生成 <wave.vcd>.widx
+//   wave_query list   <wave.vcd> [模式]                                   列出信号
+//   wave_query values <wave.vcd> -s 信号[,信号...] [-t 起始:结束]          输出窗口初值与窗口内的变化
+//   wave_query trim   <wave.vcd> -o 输出.vcd [-s 信号[,信号...]] [-t 起始:结束]   导出只含窗口的 VCD
+// 信号按层次名匹配，可用通配符（TOP.core.*.pc），也可只写末尾几级（IFU.pc）。
+// 索引不存在或 VCD 已改变时自动重建。只支持未压缩的 VCD。
+//
+
+#include "AdaptSim/utils/waveindex.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // "起始:结束"，任一端可省略
+    bool parse_window(const char* spec, uint64_t& t0, uint64_t& t1) {
+        const char* colon = std::strchr(spec, ':');
+        if (!colon) {
+            return false;
+        }
+        char* end;
+        t0 = colon == spec ? 0 : std::strtoull(spec, &end, 0);
+        t1 = colon[1] == '\0' ? UINT64_MAX : std::strtoull(colon + 1, &end, 0);
+        return t0 <= t1;
+    }
+
+    // 标量原样输出；全 0/1 的向量转为十六进制，含 x/z 时保留二进制
+    std::string format_value(const std::string& v) {
+        if (v.empty()) {
+            return "x";
+        }
+        if (v[0] != 'b' && v[0] != 'B') {
+            return v[0] == 'r' || v[0] == 'R' || v[0] == 's' || v[0] == 'S' ? v.substr(1) : v;
+        }
+        std::string bits = v.substr(1);
+        if (bits.find_first_not_of("01") != std::string::npos) {
+            return v;
+        }
+        bits.insert(0, (4 - bits.size() % 4) % 4, '0');
+        std::string hex = "0x";
+        for (size_t i = 0; i < bits.size(); i += 4) {
+            const int d = (bits[i] - '0') << 3 | (bits[i + 1] - '0') << 2 | (bits[i + 2] - '0') << 1 | (bits[i + 3] - '0');
+            hex += "0123456789abcdef"[d];
+        }
+        return hex;
+    }
+
+    bool open_index(utils::WaveIndex& idx, const std::string& vcd) {
+        const std::string path = utils::wave_index_path(vcd);
+        if (idx.open(vcd, path)) {
+            return true;
+        }
+        std::fprintf(stderr, "%s index for '%s', building it\n", idx.stale() ? "Stale" : "No", vcd.c_str());
+        return utils::build_wave_index(vcd, path) && idx.open(vcd, path);
+    }
+
+    bool select(const utils::WaveIndex& idx, const std::string& list, std::vector<size_t>& out) {
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t comma = list.find(',', start);
+            if (comma == std::string::npos) {
+                comma = list.size();
+            }
+            const std::string pattern = list.substr(start, comma - start);
+            if (!pattern.empty()) {
+                const std::vector<size_t> hit = idx.find(pattern);
+                if (hit.empty()) {
+                    std::fprintf(stderr, "Error: no signal matches '%s'\n", pattern.c_str());
+                    return false;
+                }
+                out.insert(out.end(), hit.begin(), hit.end());
+            }
+            start = comma + 1;
+        }
+        return true;
+    }
+
+    int usage(const char* prog) {
+        std::fprintf(stderr,
+                     "usage: %s index  <wave.vcd> [-c checkpoint_mb] [-m marker_kb]\n"
+                     "       %s list   <wave.vcd> [pattern]\n"
+                     "       %s values <wave.vcd> -s sig[,sig...] [-t start:end]\n"
+                     "       %s trim   <wave.vcd> -o out.vcd [-s sig[,sig...]] [-t start:end]\n",
+                     prog, prog, prog, prog);
+        return 1;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+    const std::string cmd = argv[1];
+    const std::string vcd = argv[2];
+    utils::WaveIndexOptions opts;
+    uint64_t t0 = 0;
+    uint64_t t1 = UINT64_MAX;
+    std::string sig_list;
+    std::string pattern;
+    const char* out_path = nullptr;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            opts.checkpoint_bytes = std::strtoull(argv[++i], nullptr, 0) << 20;
+        } else if (std::strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            opts.marker_bytes = std::strtoull(argv[++i], nullptr, 0) << 10;
+        } else if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            if (!parse_window(argv[++i], t0, t1)) {
+                std::fprintf(stderr, "Error: bad time window '%s', expected start:end\n", argv[i]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            sig_list = argv[++i];
+        } else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            pattern = argv[i];
+        }
+    }
+
+    if (cmd == "index") {
+        if (!utils::build_wave_index(vcd, utils::wave_index_path(vcd), opts)) {
+            return 1;
+        }
+        utils::WaveIndex idx;
+        if (!idx.open(vcd, utils::wave_index_path(vcd))) {
+            return 1;
+        }
+        const utils::WaveIndexHeader& h = idx.header();
+        std::fprintf(stderr, "%u signals, end time %llu %s, %u checkpoints, %llu markers\n", h.n_signals,
+                     static_cast<unsigned long long>(h.end_time), h.timescale, h.n_checkpoints,
+                     static_cast<unsigned long long>(h.n_markers));
+        return 0;
+    }
+
+    utils::WaveIndex idx;
+    if (!open_index(idx, vcd)) {
+        return 1;
+    }
+
+    if (cmd == "list") {
+        const std::vector<utils::WaveSignal>& sigs = idx.signals();
+        std::vector<size_t> hit;
+        if (pattern.empty()) {
+            for (size_t i = 0; i < sigs.size(); ++i) {
+                hit.push_back(i);
+            }
+        } else {
+            hit = idx.find(pattern);
+        }
+        for (size_t i : hit) {
+            std::printf("%-6s %4u %s%s\n", sigs[i].type.c_str(), sigs[i].width, sigs[i].name.c_str(),
+                        sigs[i].range.c_str());
+        }
+        return 0;
+    }
+
+    std::vector<size_t> selected;
+    if (!select(idx, sig_list, selected)) {
+        return 1;
+    }
+
+    if (cmd == "values") {
+        if (selected.empty()) {
+            std::fprintf(stderr, "Error: values needs -s\n");
+            return 1;
+        }
+        const std::vector<utils::WaveSignal>& sigs = idx.signals();
+        const bool ok = idx.values(t0, t1, selected, [&](uint64_t t, size_t i, const std::string& v) {
+            std::printf("%12llu  %-40s %s\n", static_cast<unsigned long long>(t), sigs[i].name.c_str(),
+                        format_value(v).c_str());
+        });
+        return ok ? 0 : 1;
+    }
+
+    if (cmd == "trim") {
+        if (!out_path) {
+            std::fprintf(stderr, "Error: trim needs -o\n");
+            return 1;
+        }
+        std::FILE* out = std::fopen(out_path, "wb");
+        if (!out) {
+            std::fprintf(stderr, "Error: cannot write '%s'\n", out_path);
+            return 1;
+        }
+        const bool ok = idx.trim(t0, t1, selected, out);
+        return std::fclose(out) == 0 && ok ? 0 : 1;
+    }
+
+    return usage(argv[0]);
+}